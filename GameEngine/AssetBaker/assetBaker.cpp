@@ -0,0 +1,269 @@
+// Offline asset baker: turns the source images under Resources/ into .gtex containers with
+// their full mip chains, so the game only has to map and upload them, and compiles the text
+// levels under Resources/Levels into .glvl files.
+//
+// usage: AssetBaker.exe [--root <GameEngine project dir>] [--format rgba8|bc1|bc3|bc7] [--force] [--report]
+//
+// Every container's VRAM footprint against plain RGB8 and the PSNR of its top level against
+// the source image are printed after baking. Containers newer than their sources and already
+// in the requested format (bc1 by default) are kept unless --force is given. --report compares
+// load times of the source BMPs against the baked containers; the first load of each file
+// is reported separately from the average of the repeats, so running it right after a
+// reboot (with nothing left to bake) gives real cold-cache numbers. The timing runs before
+// the quality report, which would otherwise have read every file already.
+
+#include "..\GameEngine\Model Loading\texture.h"
+#include "..\GameEngine\Model Loading\textureContainer.h"
+#include "..\GameEngine\Level\level.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#define REPORT_REPEATS 10
+
+static std::vector<std::string> listFiles(const std::string& directory, const std::string& extension)
+{
+	std::vector<std::string> files;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((directory + "\\*" + extension).c_str(), &data);
+	if (find != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				files.push_back(data.cFileName);
+		} while (FindNextFileA(find, &data));
+		FindClose(find);
+	}
+#else
+	DIR* dir = opendir(directory.c_str());
+	if (dir != NULL)
+	{
+		struct dirent* entry;
+		while ((entry = readdir(dir)) != NULL)
+		{
+			std::string name = entry->d_name;
+			if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+				files.push_back(name);
+		}
+		closedir(dir);
+	}
+#endif
+
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// CPU side of loadBMP: decode into memory
+static double timeSource(const std::string& path)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	unsigned int width, height;
+	std::vector<unsigned char> data;
+	readBMP(path.c_str(), width, height, data);
+	return elapsedMs(start);
+}
+
+// CPU side of loadTexture: map the container and touch every page the upload would read
+static volatile unsigned int sink;
+
+static double timeContainer(const std::string& path)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	MappedFile file;
+	if (file.open(path.c_str()) && validateTextureContainer(file.data(), file.size()))
+	{
+		unsigned int sum = 0;
+		for (size_t i = 0; i < file.size(); i += 4096)
+			sum += file.data()[i];
+		sink = sink + sum;
+	}
+	return elapsedMs(start);
+}
+
+static bool bake(const std::vector<std::string>& sources, const std::string& container, GLenum format, bool force)
+{
+	MappedFile existing;
+	GLenum target = sources.size() == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	if (!force && isTextureContainerFresh(target, sources, container.c_str(), format, existing))
+	{
+		printf("Up to date %s\n", container.c_str());
+		return true;
+	}
+
+	existing.close();
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	bool baked = sources.size() == 6 ? bakeCubemap(sources, container.c_str(), format) : bakeTexture(sources[0].c_str(), container.c_str(), format);
+	printf("%s %s (%.2f ms)\n", baked ? "Baked" : "FAILED", container.c_str(), elapsedMs(start));
+	return baked;
+}
+
+// VRAM saved and top-level PSNR against the source images
+static void reportQuality(const std::string& name, const std::vector<std::string>& sources, const std::string& container)
+{
+	MappedFile file;
+	if (!file.open(container.c_str()) || !validateTextureContainer(file.data(), file.size()))
+		return;
+
+	const TextureContainerHeader* header = (const TextureContainerHeader*)file.data();
+	const TextureContainerLevel& top = header->levels[0];
+	double squaredError = 0.0;
+	for (unsigned int face = 0; face < sources.size(); face++)
+	{
+		unsigned int width, height;
+		std::vector<unsigned char> source;
+		readBMPAsRGBA(sources[face].c_str(), sources.size() == 6, width, height, source);
+
+		std::vector<unsigned char> baked;
+		const unsigned char* level = file.data() + top.offset + face * top.size;
+		if (header->format == 0)
+			decompressImage(header->internalFormat, level, top.width, top.height, baked);
+		else
+			baked.assign(level, level + top.size);
+
+		// averaged as squared error so the faces of a cubemap combine into one figure
+		double psnr = computePSNR(&source[0], &baked[0], (size_t)width * height);
+		squaredError += 255.0 * 255.0 / pow(10.0, psnr / 10.0);
+	}
+	squaredError /= sources.size();
+	double psnr = squaredError > 0.0 ? std::min(100.0, 10.0 * log10(255.0 * 255.0 / squaredError)) : 100.0;
+
+	size_t videoMemory = textureContainerVideoMemory(file.data());
+	size_t rgb8Memory = textureContainerRGB8Memory(file.data());
+	printf("%-24s %6s %10zu %10zu %9.1f%% %9.2f\n", name.c_str(), textureFormatName(header->internalFormat), rgb8Memory / 1024, videoMemory / 1024,
+		100.0 * (1.0 - (double)videoMemory / rgb8Memory), psnr);
+}
+
+static void report(const std::string& name, const std::vector<std::string>& sources, const std::string& container)
+{
+	double sourceFirst = 0.0;
+	for (unsigned int i = 0; i < sources.size(); i++)
+		sourceFirst += timeSource(sources[i]);
+	double containerFirst = timeContainer(container);
+
+	double sourceWarm = 0.0;
+	double containerWarm = 0.0;
+	for (int r = 0; r < REPORT_REPEATS; r++)
+	{
+		for (unsigned int i = 0; i < sources.size(); i++)
+			sourceWarm += timeSource(sources[i]);
+		containerWarm += timeContainer(container);
+	}
+	sourceWarm /= REPORT_REPEATS;
+	containerWarm /= REPORT_REPEATS;
+
+	printf("%-24s %10.2f %10.2f %10.2f %10.2f\n", name.c_str(), sourceFirst, sourceWarm, containerFirst, containerWarm);
+}
+
+int main(int argc, char** argv)
+{
+	std::string root = ".";
+	GLenum format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	bool force = false;
+	bool reportTimes = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--root" && i + 1 < argc)
+			root = argv[++i];
+		else if (arg == "--format" && i + 1 < argc)
+		{
+			format = parseTextureFormat(argv[++i]);
+			if (format == 0)
+			{
+				printf("Unknown format %s, expected rgba8, bc1, bc3 or bc7\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (arg == "--force")
+			force = true;
+		else if (arg == "--report")
+			reportTimes = true;
+	}
+
+	std::string textureDirectory = root + "/Resources/Textures";
+	std::string skyboxDirectory = root + "/Resources/Skybox";
+	std::vector<std::string> textures = listFiles(textureDirectory, ".bmp");
+	if (textures.empty())
+	{
+		printf("No textures found under %s, pass --root <GameEngine project dir>\n", textureDirectory.c_str());
+		return 1;
+	}
+
+	// same face order as the skybox in main.cpp
+	const char* sides[6] = { "west", "east", "up", "down", "south", "north" };
+	std::vector<std::string> skyboxFaces;
+	for (int i = 0; i < 6; i++)
+		skyboxFaces.push_back(skyboxDirectory + "/clouds1_" + sides[i] + ".bmp");
+	std::string skyboxContainer = skyboxDirectory + "/clouds1.gtex";
+
+	int failures = 0;
+	for (unsigned int i = 0; i < textures.size(); i++)
+	{
+		std::string source = textureDirectory + "/" + textures[i];
+		failures += !bake(std::vector<std::string>(1, source), textureCachePath(source.c_str()), format, force);
+	}
+	failures += !bake(skyboxFaces, skyboxContainer, format, force);
+
+	std::string levelDirectory = root + "/Resources/Levels";
+	std::vector<std::string> levels = listFiles(levelDirectory, ".level");
+	for (unsigned int i = 0; i < levels.size(); i++)
+	{
+		std::string source = levelDirectory + "/" + levels[i];
+		std::string binary = source.substr(0, source.size() - 6) + ".glvl";
+		if (!force && fileModifiedTime(binary.c_str()) >= fileModifiedTime(source.c_str()))
+		{
+			printf("Up to date %s\n", binary.c_str());
+			continue;
+		}
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		bool compiled = compileLevel(source.c_str(), binary.c_str());
+		printf("%s %s (%.2f ms)\n", compiled ? "Compiled" : "FAILED", binary.c_str(), elapsedMs(start));
+		failures += !compiled;
+	}
+
+	// timed before the quality pass, which reads every source and container into the file cache
+	if (reportTimes && failures == 0)
+	{
+		printf("\n%-24s %10s %10s %10s %10s\n", "texture (ms)", "bmp first", "bmp warm", "gtex first", "gtex warm");
+		for (unsigned int i = 0; i < textures.size(); i++)
+		{
+			std::string source = textureDirectory + "/" + textures[i];
+			report(textures[i], std::vector<std::string>(1, source), textureCachePath(source.c_str()));
+		}
+		report("clouds1 skybox", skyboxFaces, skyboxContainer);
+	}
+
+	if (failures == 0)
+	{
+		printf("\n%-24s %6s %10s %10s %10s %9s\n", "texture", "format", "RGB8 KB", "VRAM KB", "saved", "PSNR dB");
+		for (unsigned int i = 0; i < textures.size(); i++)
+		{
+			std::string source = textureDirectory + "/" + textures[i];
+			reportQuality(textures[i], std::vector<std::string>(1, source), textureCachePath(source.c_str()));
+		}
+		reportQuality("clouds1 skybox", skyboxFaces, skyboxContainer);
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+#include "assetRegistry.h"
+#include "..\Graphics\glState.h"
+#include "..\imgui\imgui.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <climits>
+#endif
+
+AssetRegistry assetRegistry;
+
+static const char* assetTypeNames[ASSET_TYPE_COUNT] = { "meshes", "textures", "shaders" };
+
+std::string canonicalAssetPath(const std::string& path)
+{
+	std::string result = path;
+
+#ifdef _WIN32
+	char full[_MAX_PATH];
+	if (_fullpath(full, path.c_str(), _MAX_PATH) != NULL)
+		result = full;
+	std::transform(result.begin(), result.end(), result.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+#else
+	char* full = realpath(path.c_str(), NULL);
+	if (full != NULL)
+	{
+		result = full;
+		free(full);
+	}
+#endif
+
+	std::replace(result.begin(), result.end(), '\\', '/');
+	return result;
+}
+
+AssetRegistry::AssetRegistry()
+{
+	for (int i = 0; i < ASSET_TYPE_COUNT; i++)
+	{
+		stats[i].assets = 0;
+		stats[i].loaded = 0;
+		stats[i].bytes = 0;
+		stats[i].shared = 0;
+		stats[i].loadMs = 0.0;
+	}
+}
+
+template <class T>
+AssetHandle<T> AssetRegistry::find(std::map<std::string, std::weak_ptr<AssetEntry<T> > >& assets, const std::string& key, AssetType type,
+	std::function<T*()> load, std::function<void(T*)> unload, std::function<size_t(T*)> measure)
+{
+	std::shared_ptr<AssetEntry<T> > existing = assets[key].lock();
+	if (existing != NULL)
+	{
+		stats[type].shared++;
+		return AssetHandle<T>(existing);
+	}
+
+	AssetEntry<T>* entry = new AssetEntry<T>();
+	entry->key = key;
+	entry->type = type;
+	entry->value = NULL;
+	entry->failed = false;
+	entry->bytes = 0;
+	entry->load = load;
+	entry->unload = unload;
+	entry->measure = measure;
+	stats[type].assets++;
+
+	// runs when the last handle goes away; the expired map slot is reused by the next request
+	std::shared_ptr<AssetEntry<T> > created(entry, [](AssetEntry<T>* entry) {
+		if (entry->value != NULL)
+		{
+			entry->unload(entry->value);
+			delete entry->value;
+		}
+		assetRegistry.assetReleased(entry->type, entry->bytes, entry->value != NULL);
+		delete entry;
+	});
+	assets[key] = created;
+
+	return AssetHandle<T>(created);
+}
+
+static std::string textureListKey(const std::vector<std::string>& paths)
+{
+	std::string key;
+	for (unsigned int i = 0; i < paths.size(); i++)
+		key += canonicalAssetPath(paths[i]) + ";";
+	return key;
+}
+
+AssetHandle<Mesh> AssetRegistry::mesh(const std::string& path)
+{
+	return mesh(path, std::vector<Texture>());
+}
+
+AssetHandle<Mesh> AssetRegistry::mesh(const std::string& path, const std::vector<Texture>& textures)
+{
+	// the same model with different textures is a different mesh
+	std::string key = canonicalAssetPath(path);
+	for (unsigned int i = 0; i < textures.size(); i++)
+		key += "|" + textures[i].type + ":" + std::to_string(textures[i].id);
+
+	MeshLoaderObj* loader = &this->loader;
+	return find<Mesh>(meshes, key, ASSET_MESH,
+		[=]() {
+			ALLOCATION_SCOPE(ALLOC_TAG_MESH);
+			Mesh mesh = textures.empty() ? loader->loadObj(path) : loader->loadObj(path, textures);
+			return mesh.indices.empty() ? NULL : new Mesh(mesh);
+		},
+		[](Mesh* mesh) {
+			glState.deleteVertexArray(mesh->vao);
+			glState.deleteBuffer(mesh->vbo);
+			glState.deleteBuffer(mesh->ibo);
+		},
+		[](Mesh* mesh) {
+			return mesh->vertices.size() * sizeof(Vertex) + mesh->indices.size() * sizeof(unsigned int);
+		});
+}
+
+AssetHandle<Texture> AssetRegistry::findTexture(const std::string& key, GLenum target, const char* type, std::function<GLuint()> load)
+{
+	std::string textureType = type;
+	return find<Texture>(textures, key, ASSET_TEXTURE,
+		[=]() {
+			GLuint id = load();
+			if (id == 0)
+				return (Texture*)NULL;
+			Texture* texture = new Texture();
+			texture->id = id;
+			texture->type = textureType;
+			return texture;
+		},
+		[](Texture* texture) {
+			glState.deleteTexture(texture->id);
+		},
+		[=](Texture* texture) {
+			return textureVideoMemory(target, texture->id);
+		});
+}
+
+AssetHandle<Texture> AssetRegistry::texture(const std::string& path)
+{
+	return findTexture("2d|" + canonicalAssetPath(path), GL_TEXTURE_2D, "texture_diffuse", [=]() {
+		return loadTexture(path.c_str());
+	});
+}
+
+AssetHandle<Texture> AssetRegistry::cubemap(const std::vector<std::string>& faces, const char* cachePath)
+{
+	std::string cache = cachePath != NULL ? cachePath : "";
+	return findTexture("cube|" + textureListKey(faces) + (cachePath != NULL ? canonicalAssetPath(cache) : "source"), GL_TEXTURE_CUBE_MAP, "texture_cubemap", [=]() {
+		return cache.empty() ? loadCubemap(faces) : loadCubemapTexture(faces, cache.c_str());
+	});
+}
+
+AssetHandle<Texture> AssetRegistry::textureArray(const std::vector<std::string>& layers, const char* cachePath)
+{
+	std::string cache = cachePath != NULL ? cachePath : "";
+	return findTexture("array|" + textureListKey(layers) + (cachePath != NULL ? canonicalAssetPath(cache) : "memory"), GL_TEXTURE_2D_ARRAY, "texture_array", [=]() {
+		return loadTextureArray(layers, cache.empty() ? NULL : cache.c_str());
+	});
+}
+
+AssetHandle<Shader> AssetRegistry::shader(const std::string& vertexPath, const std::string& fragmentPath)
+{
+	return find<Shader>(shaders, canonicalAssetPath(vertexPath) + "|" + canonicalAssetPath(fragmentPath), ASSET_SHADER,
+		[=]() {
+			return new Shader(vertexPath.c_str(), fragmentPath.c_str());
+		},
+		[](Shader* shader) {
+			glDeleteProgram(shader->getId());
+		},
+		[](Shader* shader) {
+			// the driver's binary is the closest thing to a program's footprint
+			GLint length = 0;
+			if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+				glGetProgramiv(shader->getId(), GL_PROGRAM_BINARY_LENGTH, &length);
+			return (size_t)length;
+		});
+}
+
+void AssetRegistry::assetLoaded(AssetType type, size_t bytes, double ms)
+{
+	stats[type].loaded++;
+	stats[type].bytes += bytes;
+	stats[type].loadMs += ms;
+}
+
+void AssetRegistry::assetReleased(AssetType type, size_t bytes, bool loaded)
+{
+	stats[type].assets--;
+	if (loaded)
+	{
+		stats[type].loaded--;
+		stats[type].bytes -= bytes;
+	}
+}
+
+AssetTypeStats AssetRegistry::getStats(AssetType type)
+{
+	return stats[type];
+}
+
+void AssetRegistry::printReport()
+{
+	printf("%-10s %8s %8s %8s %10s %10s\n", "assets", "live", "loaded", "shared", "VRAM KB", "load ms");
+	for (int i = 0; i < ASSET_TYPE_COUNT; i++)
+		printf("%-10s %8u %8u %8u %10zu %10.2f\n", assetTypeNames[i], stats[i].assets, stats[i].loaded, stats[i].shared, stats[i].bytes / 1024, stats[i].loadMs);
+}
+
+void AssetRegistry::drawOverlay()
+{
+	ImGui::Begin("Assets");
+	for (int i = 0; i < ASSET_TYPE_COUNT; i++)
+	{
+		ImGui::Text("%-8s %u/%u loaded, %.2f MB, %u shared", assetTypeNames[i], stats[i].loaded, stats[i].assets,
+			stats[i].bytes / (1024.0 * 1024.0), stats[i].shared);
+	}
+	ImGui::End();
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "..\Model Loading\mesh.h"
+#include "..\Model Loading\meshLoaderObj.h"
+#include "..\Model Loading\texture.h"
+#include "..\Shaders\shader.h"
+#include "..\Memory\allocationTracker.h"
+
+enum AssetType
+{
+	ASSET_MESH,
+	ASSET_TEXTURE,
+	ASSET_SHADER,
+	ASSET_TYPE_COUNT
+};
+
+// state shared by every handle to one asset; value stays NULL until the first get()
+template <class T>
+struct AssetEntry
+{
+	std::string key;
+	AssetType type;
+	T* value;
+	bool failed;
+	size_t bytes;
+	std::function<T*()> load;
+	std::function<void(T*)> unload;
+	std::function<size_t(T*)> measure;
+};
+
+// Shared reference to a registry asset. The asset is loaded by the first get() on any handle
+// to it and freed, GL objects included, when the last handle goes away.
+template <class T>
+class AssetHandle
+{
+	private:
+		std::shared_ptr<AssetEntry<T> > entry;
+
+	public:
+		AssetHandle() {}
+		AssetHandle(const std::shared_ptr<AssetEntry<T> >& entry) : entry(entry) {}
+
+		// NULL if the asset failed to load
+		T* get();
+		T* operator->() { return get(); }
+		T& operator*() { return *get(); }
+
+		bool isValid() const { return entry != NULL; }
+		bool isLoaded() const { return entry != NULL && entry->value != NULL; }
+		void reset() { entry.reset(); }
+};
+
+struct AssetTypeStats
+{
+	// live assets (with at least one handle) and how many of them are loaded
+	unsigned int assets;
+	unsigned int loaded;
+	// video memory of the loaded ones
+	size_t bytes;
+	// requests answered with an asset that already had a handle
+	unsigned int shared;
+	double loadMs;
+};
+
+// Hands out shared handles to meshes, textures and shader programs, keyed by canonical path
+// and load parameters, so the same file is never loaded twice.
+class AssetRegistry
+{
+	private:
+		std::map<std::string, std::weak_ptr<AssetEntry<Mesh> > > meshes;
+		std::map<std::string, std::weak_ptr<AssetEntry<Texture> > > textures;
+		std::map<std::string, std::weak_ptr<AssetEntry<Shader> > > shaders;
+		AssetTypeStats stats[ASSET_TYPE_COUNT];
+		MeshLoaderObj loader;
+
+		template <class T>
+		AssetHandle<T> find(std::map<std::string, std::weak_ptr<AssetEntry<T> > >& assets, const std::string& key, AssetType type,
+			std::function<T*()> load, std::function<void(T*)> unload, std::function<size_t(T*)> measure);
+
+		AssetHandle<Texture> findTexture(const std::string& key, GLenum target, const char* type, std::function<GLuint()> load);
+
+	public:
+		AssetRegistry();
+
+		AssetHandle<Mesh> mesh(const std::string& path);
+		AssetHandle<Mesh> mesh(const std::string& path, const std::vector<Texture>& textures);
+		// loadTexture: the baked container when caching is on, the BMP otherwise
+		AssetHandle<Texture> texture(const std::string& path);
+		// a NULL cachePath decodes the source images instead of using a container
+		AssetHandle<Texture> cubemap(const std::vector<std::string>& faces, const char* cachePath);
+		AssetHandle<Texture> textureArray(const std::vector<std::string>& layers, const char* cachePath);
+		AssetHandle<Shader> shader(const std::string& vertexPath, const std::string& fragmentPath);
+
+		// bookkeeping for AssetHandle and the handle deleter
+		void assetLoaded(AssetType type, size_t bytes, double ms);
+		void assetReleased(AssetType type, size_t bytes, bool loaded);
+
+		AssetTypeStats getStats(AssetType type);
+		void printReport();
+		void drawOverlay();
+};
+
+extern AssetRegistry assetRegistry;
+
+// absolute, '/'-separated and (on Windows) lower-case, so different spellings of one file match
+std::string canonicalAssetPath(const std::string& path);
+
+template <class T>
+T* AssetHandle<T>::get()
+{
+	if (entry == NULL)
+		return NULL;
+
+	if (entry->value == NULL && !entry->failed)
+	{
+		ALLOCATION_SCOPE(ALLOC_TAG_LOADER);
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		entry->value = entry->load();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		if (entry->value == NULL)
+		{
+			std::cout << "Could not load asset " << entry->key << std::endl;
+			entry->failed = true;
+			return NULL;
+		}
+		entry->bytes = entry->measure(entry->value);
+		assetRegistry.assetLoaded(entry->type, entry->bytes, ms);
+	}
+
+	return entry->value;
+}
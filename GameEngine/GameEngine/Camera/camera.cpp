@@ -9,6 +9,7 @@ Camera::Camera(glm::vec3 cameraPosition)
 	this->rotationOx = 0.0f;
 	this->rotationOy = -90.0f;
 	this->speedMultiplier = 2.0f;
+	initRenderState();
 }
 
 Camera::Camera()
@@ -20,6 +21,7 @@ Camera::Camera()
 	this->rotationOx = 0.0f;
 	this->rotationOy = -90.0f;
 	this->speedMultiplier = 2.0f;
+	initRenderState();
 }
 
 Camera::Camera(glm::vec3 cameraPosition, glm::vec3 cameraViewDirection, glm::vec3 cameraUp)
@@ -29,6 +31,7 @@ Camera::Camera(glm::vec3 cameraPosition, glm::vec3 cameraViewDirection, glm::vec
 	this->cameraUp = cameraUp;
 	this->cameraRight = glm::cross(cameraViewDirection, cameraUp);
 	this->speedMultiplier = 2.0f;
+	initRenderState();
 }
 
 Camera::Camera(glm::vec3 cameraPosition, glm::vec3 cameraViewDirection, glm::vec3 cameraUp, float speedMultiplier)
@@ -38,33 +41,49 @@ Camera::Camera(glm::vec3 cameraPosition, glm::vec3 cameraViewDirection, glm::vec
 	this->cameraUp = cameraUp;
 	this->cameraRight = glm::cross(cameraViewDirection, cameraUp);
 	this->speedMultiplier = speedMultiplier;
+	initRenderState();
 }
 
 Camera::~Camera()
 {
 }
 
+void Camera::initRenderState()
+{
+	this->fieldOfView = 90.0f;
+	this->aspectRatio = 1.0f;
+	this->nearPlane = 0.1f;
+	this->farPlane = 10000.0f;
+	this->renderState.version = 0;
+	this->renderStateDirty = true;
+}
+
 void Camera::keyboardMoveFront(float cameraSpeed) {
 	cameraPosition += glm::vec3(1.0f, 0.0f, 1.0f) * cameraViewDirection * cameraSpeed * speedMultiplier;
+	renderStateDirty = true;
 }
 
 void Camera::keyboardMoveBack(float cameraSpeed) {
 	cameraPosition -= glm::vec3(1.0f, 0.0f, 1.0f) * cameraViewDirection * cameraSpeed * speedMultiplier;
+	renderStateDirty = true;
 }
 
 // subtract with cross product between viewing direction & camera's up orientation
 void Camera::keyboardMoveLeft(float cameraSpeed) {
 	cameraPosition -= glm::cross(cameraViewDirection, cameraUp) * cameraSpeed * speedMultiplier;
+	renderStateDirty = true;
 }
 
 // add with cross product between viewing direction & camera's up orientation
 void Camera::keyboardMoveRight(float cameraSpeed) {
 	cameraPosition += glm::cross(cameraViewDirection, cameraUp) * cameraSpeed * speedMultiplier;
+	renderStateDirty = true;
 }
 
 // move Up for positive value, Down for negative value
 void Camera::verticalMovement(float cameraSpeed) {
 	cameraPosition += glm::vec3(0.0f, 1.0f, 0.0f) * cameraSpeed * speedMultiplier;
+	renderStateDirty = true;
 }
 
 /*
@@ -95,6 +114,7 @@ void Camera::rotateOx(float angle, glm::vec3 pivot)
 	cameraViewDirection = glm::normalize(glm::vec3((glm::rotate(glm::mat4(1.0f), angle, cameraRight) * glm::vec4(cameraViewDirection, 1))));
 	cameraUp = glm::normalize(glm::cross(cameraRight, cameraViewDirection));
 	cameraRight = glm::cross(cameraViewDirection, cameraUp);
+	renderStateDirty = true;
 }
 
 void Camera::rotateOy(float angle, glm::vec3 pivot) {
@@ -113,6 +133,7 @@ void Camera::rotateOy(float angle, glm::vec3 pivot) {
 	cameraViewDirection = glm::normalize(glm::vec3(rotationMatrix * glm::vec4(cameraViewDirection, 0.0f)));
 	cameraUp = glm::normalize(glm::vec3(rotationMatrix * glm::vec4(cameraUp, 0.0f)));
 	cameraRight = glm::normalize(glm::cross(cameraViewDirection, cameraUp));
+	renderStateDirty = true;
 }
 
 
@@ -124,6 +145,55 @@ glm::mat4 Camera::getViewMatrix()
 	return glm::lookAt(cameraPosition, cameraPosition + cameraViewDirection, cameraUp);
 }
 
+void Camera::setProjection(float fieldOfView, float aspectRatio, float nearPlane, float farPlane)
+{
+	if (fieldOfView == this->fieldOfView && aspectRatio == this->aspectRatio && nearPlane == this->nearPlane && farPlane == this->farPlane)
+		return;
+
+	this->fieldOfView = fieldOfView;
+	this->aspectRatio = aspectRatio;
+	this->nearPlane = nearPlane;
+	this->farPlane = farPlane;
+	renderStateDirty = true;
+}
+
+const CameraRenderState& Camera::getRenderState()
+{
+	if (!renderStateDirty)
+		return renderState;
+
+	renderState.view = getViewMatrix();
+	renderState.projection = glm::perspective(fieldOfView, aspectRatio, nearPlane, farPlane);
+	renderState.viewProjection = renderState.projection * renderState.view;
+	renderState.inverseView = glm::inverse(renderState.view);
+	renderState.inverseProjection = glm::inverse(renderState.projection);
+	renderState.inverseViewProjection = renderState.inverseView * renderState.inverseProjection;
+	renderState.skyboxViewProjection = renderState.projection * glm::mat4(glm::mat3(renderState.view));
+	extractFrustumPlanes(renderState.viewProjection, renderState.frustum);
+	renderState.position = cameraPosition;
+	renderState.nearPlane = nearPlane;
+	renderState.farPlane = farPlane;
+	renderState.version++;
+
+	renderStateDirty = false;
+	return renderState;
+}
+
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4* planes)
+{
+	glm::vec4 rowX = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 rowY = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 rowZ = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 rowW = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	planes[0] = rowW + rowX;
+	planes[1] = rowW - rowX;
+	planes[2] = rowW + rowY;
+	planes[3] = rowW - rowY;
+	planes[4] = rowW + rowZ;
+	planes[5] = rowW - rowZ;
+}
+
 glm::vec3 Camera::getCameraPosition()
 {
 	return cameraPosition;
@@ -151,24 +221,28 @@ void Camera::setCameraPosition(glm::vec3 vec)
 {
 	//return cameraPosition;
 	this->cameraPosition = vec;
+	renderStateDirty = true;
 }
 
 void Camera::setCameraViewDirection(glm::vec3 vec)
 {
 	//return cameraViewDirection;
 	this->cameraViewDirection = vec;
+	renderStateDirty = true;
 }
 
  void Camera::setCameraUp(glm::vec3 vec)
 {
 	//return cameraUp;
 	 this->cameraUp = vec;
+	renderStateDirty = true;
 }
 
 void Camera::setCameraRight(glm::vec3 vec)
 {
 	//return cameraRight;
 	this->cameraRight = vec;
+	renderStateDirty = true;
 }
 
 
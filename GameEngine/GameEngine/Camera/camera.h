@@ -6,6 +6,29 @@
 #include <gtc\type_ptr.hpp>
 #include "..\Graphics\window.h"
 
+// everything the passes and the culler need from the camera for one frame
+struct CameraRenderState
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::mat4 inverseView;
+	glm::mat4 inverseProjection;
+	glm::mat4 inverseViewProjection;
+	// rotation only, for geometry that stays centred on the camera like the skybox
+	glm::mat4 skyboxViewProjection;
+	// left, right, bottom, top, near, far; xyz point inwards, unnormalised
+	glm::vec4 frustum[6];
+	glm::vec3 position;
+	float nearPlane;
+	float farPlane;
+	// bumped every time the state is rebuilt
+	unsigned int version;
+};
+
+// planes of the frustum of viewProjection, straight from the rows of the matrix (Gribb & Hartmann)
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4* planes);
+
 class Camera
 {
 	private:
@@ -15,6 +38,17 @@ class Camera
 		glm::vec3 cameraRight;
 		float speedMultiplier;
 
+		float fieldOfView;
+		float aspectRatio;
+		float nearPlane;
+		float farPlane;
+
+		// rebuilt on the first getRenderState() after anything above changed
+		CameraRenderState renderState;
+		bool renderStateDirty;
+
+		void initRenderState();
+
 		//rotation - to be removed
 		float rotationOx;
 		float rotationOy;
@@ -27,6 +61,9 @@ class Camera
 		~Camera();
 
 		glm::mat4 getViewMatrix();
+		// only marks the render state stale when one of the values actually changed
+		void setProjection(float fieldOfView, float aspectRatio, float nearPlane, float farPlane);
+		const CameraRenderState& getRenderState();
 		glm::vec3 getCameraPosition();
 		glm::vec3 getCameraViewDirection();
 		glm::vec3 getCameraUp();
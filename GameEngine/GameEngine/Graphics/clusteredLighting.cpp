@@ -0,0 +1,410 @@
+#include "clusteredLighting.h"
+#include "glState.h"
+#include "glStats.h"
+#include "..\Threading\parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLUSTERED_LIGHTING_SSE2
+#include <emmintrin.h>
+#endif
+
+ClusteredLighting clusteredLighting;
+
+ClusteredLighting::ClusteredLighting()
+{
+	this->lightsChanged = true;
+	this->depthScale = 0.0f;
+	this->depthBias = 0.0f;
+	for (int k = 0; k <= CLUSTERED_SLICES; k++)
+		this->sliceDepths[k] = 0.0f;
+	this->scaleX = 1.0f;
+	this->scaleY = 1.0f;
+	this->viewForward = glm::vec3(0.0f, 0.0f, -1.0f);
+	for (int i = 0; i < 3; i++)
+	{
+		this->buffers[i] = 0;
+		this->textures[i] = 0;
+	}
+	for (int s = 0; s < CLUSTERED_SLICES; s++)
+		this->sliceOverflows[s] = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		this->lists[i].depthScale = 0.0f;
+		this->lists[i].depthBias = 0.0f;
+		this->lists[i].viewForward = glm::vec3(0.0f, 0.0f, -1.0f);
+	}
+	this->current = 0;
+	this->assignMs = 0.0f;
+	this->visibleLights = 0;
+	this->maxClusterLights = 0;
+	this->overflowCount = 0;
+}
+
+void ClusteredLighting::init()
+{
+	// lights as two RGBA32F texels (position and radius, then color), clusters as offset and
+	// count, light indices as 16 bit
+	static const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+
+	glGenBuffers(3, buffers);
+	glGenTextures(3, textures);
+	for (int i = 0; i < 3; i++)
+	{
+		// a texture buffer needs a data store before anything samples it
+		glState.bindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+		glState.bindTexture(CLUSTERED_FIRST_UNIT + i, GL_TEXTURE_BUFFER, textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+	}
+	lightsChanged = true;
+}
+
+void ClusteredLighting::shutdown()
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (textures[i] != 0)
+			glState.deleteTexture(textures[i]);
+		if (buffers[i] != 0)
+			glState.deleteBuffer(buffers[i]);
+		textures[i] = 0;
+		buffers[i] = 0;
+	}
+}
+
+void ClusteredLighting::clearLights()
+{
+	positionsX.clear();
+	positionsY.clear();
+	positionsZ.clear();
+	radii.clear();
+	colors.clear();
+	lightsChanged = true;
+}
+
+bool ClusteredLighting::addLight(const glm::vec3& position, float radius, const glm::vec3& color)
+{
+	unsigned int count = getLightCount();
+	if (count >= CLUSTERED_MAX_LIGHTS)
+		return false;
+
+	// the attribute arrays stay a multiple of four long, the padding is never read back
+	if (count % 4 == 0)
+	{
+		positionsX.resize(count + 4, 0.0f);
+		positionsY.resize(count + 4, 0.0f);
+		positionsZ.resize(count + 4, 0.0f);
+		radii.resize(count + 4, 0.0f);
+	}
+	positionsX[count] = position.x;
+	positionsY[count] = position.y;
+	positionsZ[count] = position.z;
+	radii[count] = radius;
+	colors.push_back(color);
+	lightsChanged = true;
+	return true;
+}
+
+unsigned int ClusteredLighting::getLightCount()
+{
+	return (unsigned int)colors.size();
+}
+
+static int tileOf(float ndc, int tiles)
+{
+	int tile = (int)((ndc * 0.5f + 0.5f) * tiles);
+	return std::min(std::max(tile, 0), tiles - 1);
+}
+
+// NDC range of [low, high] seen between the depths nearDepth and farDepth (both in front of the
+// camera): x / depth is lowest at the near depth when x is negative and at the far depth when
+// it is positive, the other way round for the highest
+static void projectRange(float low, float high, float nearDepth, float farDepth, float scale, float& minNdc, float& maxNdc)
+{
+	minNdc = scale * low / (low >= 0.0f ? farDepth : nearDepth);
+	maxNdc = scale * high / (high >= 0.0f ? nearDepth : farDepth);
+}
+
+void ClusteredLighting::computeBounds(const CameraRenderState& camera, unsigned int first, unsigned int last)
+{
+	const glm::mat4& view = camera.view;
+
+	// lights to view space four at a time, then the depth range and screen rectangle of the whole
+	// sphere to drop the ones that are out of sight
+	for (unsigned int i = first; i < last; i += 4)
+	{
+		float viewX[4], viewY[4], depths[4], radius[4], minX[4], maxX[4], minY[4], maxY[4];
+
+#ifdef CLUSTERED_LIGHTING_SSE2
+		__m128 x = _mm_loadu_ps(&positionsX[i]);
+		__m128 y = _mm_loadu_ps(&positionsY[i]);
+		__m128 z = _mm_loadu_ps(&positionsZ[i]);
+		__m128 r = _mm_loadu_ps(&radii[i]);
+
+		__m128 centerX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(view[0][0])), _mm_mul_ps(y, _mm_set1_ps(view[1][0]))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(view[2][0])), _mm_set1_ps(view[3][0])));
+		__m128 centerY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(view[0][1])), _mm_mul_ps(y, _mm_set1_ps(view[1][1]))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(view[2][1])), _mm_set1_ps(view[3][1])));
+		// the camera looks down -z, depth is positive in front of it
+		__m128 depth = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(view[0][2])), _mm_mul_ps(y, _mm_set1_ps(view[1][2]))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(view[2][2])), _mm_set1_ps(view[3][2]))));
+		__m128 nearDepth = _mm_sub_ps(depth, r);
+		__m128 farDepth = _mm_add_ps(depth, r);
+
+		__m128 zero = _mm_setzero_ps();
+		__m128 low = _mm_sub_ps(centerX, r);
+		__m128 high = _mm_add_ps(centerX, r);
+		__m128 lowPositive = _mm_cmpge_ps(low, zero);
+		__m128 highPositive = _mm_cmpge_ps(high, zero);
+		__m128 lowDepth = _mm_or_ps(_mm_and_ps(lowPositive, farDepth), _mm_andnot_ps(lowPositive, nearDepth));
+		__m128 highDepth = _mm_or_ps(_mm_and_ps(highPositive, nearDepth), _mm_andnot_ps(highPositive, farDepth));
+		_mm_storeu_ps(minX, _mm_div_ps(_mm_mul_ps(low, _mm_set1_ps(scaleX)), lowDepth));
+		_mm_storeu_ps(maxX, _mm_div_ps(_mm_mul_ps(high, _mm_set1_ps(scaleX)), highDepth));
+
+		low = _mm_sub_ps(centerY, r);
+		high = _mm_add_ps(centerY, r);
+		lowPositive = _mm_cmpge_ps(low, zero);
+		highPositive = _mm_cmpge_ps(high, zero);
+		lowDepth = _mm_or_ps(_mm_and_ps(lowPositive, farDepth), _mm_andnot_ps(lowPositive, nearDepth));
+		highDepth = _mm_or_ps(_mm_and_ps(highPositive, nearDepth), _mm_andnot_ps(highPositive, farDepth));
+		_mm_storeu_ps(minY, _mm_div_ps(_mm_mul_ps(low, _mm_set1_ps(scaleY)), lowDepth));
+		_mm_storeu_ps(maxY, _mm_div_ps(_mm_mul_ps(high, _mm_set1_ps(scaleY)), highDepth));
+
+		_mm_storeu_ps(viewX, centerX);
+		_mm_storeu_ps(viewY, centerY);
+		_mm_storeu_ps(depths, depth);
+		_mm_storeu_ps(radius, r);
+#else
+		for (int lane = 0; lane < 4; lane++)
+		{
+			glm::vec4 center = view * glm::vec4(positionsX[i + lane], positionsY[i + lane], positionsZ[i + lane], 1.0f);
+			viewX[lane] = center.x;
+			viewY[lane] = center.y;
+			depths[lane] = -center.z;
+			radius[lane] = radii[i + lane];
+			float nearDepth = depths[lane] - radius[lane];
+			float farDepth = depths[lane] + radius[lane];
+			projectRange(center.x - radius[lane], center.x + radius[lane], nearDepth, farDepth, scaleX, minX[lane], maxX[lane]);
+			projectRange(center.y - radius[lane], center.y + radius[lane], nearDepth, farDepth, scaleY, minY[lane], maxY[lane]);
+		}
+#endif
+
+		for (unsigned int lane = 0; lane < 4 && i + lane < last; lane++)
+		{
+			LightBounds& light = bounds[i + lane];
+			light.viewX = viewX[lane];
+			light.viewY = viewY[lane];
+			light.depth = depths[lane];
+			light.radius = radius[lane];
+			light.minSlice = 1;
+			light.maxSlice = 0;
+
+			float nearDepth = depths[lane] - radius[lane];
+			float farDepth = depths[lane] + radius[lane];
+			if (farDepth < camera.nearPlane || nearDepth > camera.farPlane)
+				continue;
+			// a sphere reaching past the near plane has no meaningful rectangle, keep it
+			if (nearDepth >= camera.nearPlane && (minX[lane] > 1.0f || maxX[lane] < -1.0f || minY[lane] > 1.0f || maxY[lane] < -1.0f))
+				continue;
+
+			float sliceNear = logf(std::max(nearDepth, camera.nearPlane)) * depthScale + depthBias;
+			float sliceFar = logf(std::min(farDepth, camera.farPlane)) * depthScale + depthBias;
+			light.minSlice = std::min(std::max((int)sliceNear, 0), CLUSTERED_SLICES - 1);
+			light.maxSlice = std::min(std::max((int)sliceFar, 0), CLUSTERED_SLICES - 1);
+		}
+	}
+}
+
+void ClusteredLighting::fillSlice(int slice)
+{
+	unsigned int first = slice * CLUSTERED_TILES_X * CLUSTERED_TILES_Y;
+	for (unsigned int c = first; c < first + CLUSTERED_TILES_X * CLUSTERED_TILES_Y; c++)
+		clusterCounts[c] = 0;
+
+	unsigned int overflow = 0;
+	unsigned int count = getLightCount();
+	for (unsigned int l = 0; l < count; l++)
+	{
+		const LightBounds& light = bounds[l];
+		if (slice < light.minSlice || slice > light.maxSlice)
+			continue;
+
+		// the part of the sphere inside this slice: never wider than its cross section at the
+		// slice depth closest to the centre. The slices start at the near plane, so both depths
+		// are in front of the camera
+		float nearDepth = std::max(sliceDepths[slice], light.depth - light.radius);
+		float farDepth = std::min(sliceDepths[slice + 1], light.depth + light.radius);
+		float offset = light.depth < nearDepth ? nearDepth - light.depth : std::max(light.depth - farDepth, 0.0f);
+		float r = sqrtf(std::max(light.radius * light.radius - offset * offset, 0.0f));
+
+		float minX, maxX, minY, maxY;
+		projectRange(light.viewX - r, light.viewX + r, nearDepth, farDepth, scaleX, minX, maxX);
+		projectRange(light.viewY - r, light.viewY + r, nearDepth, farDepth, scaleY, minY, maxY);
+		if (minX > 1.0f || maxX < -1.0f || minY > 1.0f || maxY < -1.0f)
+			continue;
+
+		int maxTileX = tileOf(maxX, CLUSTERED_TILES_X);
+		int maxTileY = tileOf(maxY, CLUSTERED_TILES_Y);
+		for (int y = tileOf(minY, CLUSTERED_TILES_Y); y <= maxTileY; y++)
+		{
+			for (int x = tileOf(minX, CLUSTERED_TILES_X); x <= maxTileX; x++)
+			{
+				unsigned int cluster = first + y * CLUSTERED_TILES_X + x;
+				if (clusterCounts[cluster] < CLUSTERED_MAX_LIGHTS_PER_CLUSTER)
+					clusterLights[cluster * CLUSTERED_MAX_LIGHTS_PER_CLUSTER + clusterCounts[cluster]++] = (unsigned short)l;
+				else
+					overflow++;
+			}
+		}
+	}
+	sliceOverflows[slice] = overflow;
+}
+
+unsigned int ClusteredLighting::assign(const CameraRenderState& camera)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	// allocated on first use rather than at static initialisation
+	if (clusterCounts.empty())
+	{
+		clusterLights.resize(CLUSTERED_CLUSTER_COUNT * CLUSTERED_MAX_LIGHTS_PER_CLUSTER);
+		clusterCounts.resize(CLUSTERED_CLUSTER_COUNT);
+		for (int i = 0; i < 2; i++)
+			lists[i].ranges.resize(2 * CLUSTERED_CLUSTER_COUNT);
+	}
+
+	// slice = log(depth) * depthScale + depthBias, so near lands on 0 and far on CLUSTERED_SLICES
+	float logRange = logf(camera.farPlane / camera.nearPlane);
+	depthScale = CLUSTERED_SLICES / logRange;
+	depthBias = -CLUSTERED_SLICES * logf(camera.nearPlane) / logRange;
+	for (int k = 0; k <= CLUSTERED_SLICES; k++)
+		sliceDepths[k] = expf((k - depthBias) / depthScale);
+	sliceDepths[0] = camera.nearPlane;
+	sliceDepths[CLUSTERED_SLICES] = camera.farPlane;
+	scaleX = camera.projection[0][0];
+	scaleY = camera.projection[1][1];
+	viewForward = -glm::vec3(camera.view[0][2], camera.view[1][2], camera.view[2][2]);
+
+	unsigned int count = getLightCount();
+	bounds.resize(count);
+	if (count < CLUSTERED_MIN_PARALLEL_LIGHTS)
+	{
+		computeBounds(camera, 0, count);
+		for (int s = 0; s < CLUSTERED_SLICES; s++)
+			fillSlice(s);
+	}
+	else
+	{
+		unsigned int batches = (count + CLUSTERED_BOUNDS_BATCH - 1) / CLUSTERED_BOUNDS_BATCH;
+		parallelFor(batches, [&](unsigned int batch) {
+			computeBounds(camera, batch * CLUSTERED_BOUNDS_BATCH, std::min(count, (batch + 1) * CLUSTERED_BOUNDS_BATCH));
+		});
+		// a slice only writes its own clusters, so they never share a cluster
+		parallelFor(CLUSTERED_SLICES, [&](unsigned int slice) {
+			fillSlice((int)slice);
+		});
+	}
+
+	// pack the fixed-size per cluster lists into one run of indices
+	current = 1 - current;
+	ClusterLists& out = lists[current];
+	unsigned int total = 0;
+	maxClusterLights = 0;
+	for (unsigned int c = 0; c < CLUSTERED_CLUSTER_COUNT; c++)
+	{
+		out.ranges[2 * c] = total;
+		out.ranges[2 * c + 1] = clusterCounts[c];
+		total += clusterCounts[c];
+		maxClusterLights = std::max(maxClusterLights, clusterCounts[c]);
+	}
+	out.indices.resize(total);
+	for (unsigned int c = 0; c < CLUSTERED_CLUSTER_COUNT; c++)
+	{
+		if (clusterCounts[c] > 0)
+			memcpy(&out.indices[out.ranges[2 * c]], &clusterLights[c * CLUSTERED_MAX_LIGHTS_PER_CLUSTER], clusterCounts[c] * sizeof(unsigned short));
+	}
+	out.depthScale = depthScale;
+	out.depthBias = depthBias;
+	out.viewForward = viewForward;
+
+	overflowCount = 0;
+	for (int s = 0; s < CLUSTERED_SLICES; s++)
+		overflowCount += sliceOverflows[s];
+	visibleLights = 0;
+	for (unsigned int l = 0; l < count; l++)
+		visibleLights += bounds[l].minSlice <= bounds[l].maxSlice;
+
+	assignMs = (float)std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return current;
+}
+
+void ClusteredLighting::bind(GLuint program, unsigned int assigned, int renderWidth, int renderHeight)
+{
+	if (buffers[0] == 0 || clusterCounts.empty())
+		return;
+
+	const ClusterLists& in = lists[assigned & 1];
+
+	if (lightsChanged)
+	{
+		unsigned int count = getLightCount();
+		std::vector<glm::vec4> packed(2 * std::max(count, 1u), glm::vec4(0.0f));
+		for (unsigned int l = 0; l < count; l++)
+		{
+			packed[2 * l] = glm::vec4(positionsX[l], positionsY[l], positionsZ[l], radii[l]);
+			packed[2 * l + 1] = glm::vec4(colors[l], 1.0f);
+		}
+		glState.bindBuffer(GL_TEXTURE_BUFFER, buffers[0]);
+		glBufferData(GL_TEXTURE_BUFFER, packed.size() * sizeof(glm::vec4), &packed[0], GL_STATIC_DRAW);
+		lightsChanged = false;
+	}
+
+	// a fresh store every frame, the GPU may still be reading last frame's
+	glState.bindBuffer(GL_TEXTURE_BUFFER, buffers[1]);
+	glBufferData(GL_TEXTURE_BUFFER, in.ranges.size() * sizeof(unsigned int), &in.ranges[0], GL_STREAM_DRAW);
+	glState.bindBuffer(GL_TEXTURE_BUFFER, buffers[2]);
+	if (in.indices.empty())
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(unsigned short), NULL, GL_STREAM_DRAW);
+	else
+		glBufferData(GL_TEXTURE_BUFFER, in.indices.size() * sizeof(unsigned short), &in.indices[0], GL_STREAM_DRAW);
+
+	for (int i = 0; i < 3; i++)
+		glState.bindTexture(CLUSTERED_FIRST_UNIT + i, GL_TEXTURE_BUFFER, textures[i]);
+
+	glUniform1i(glGetUniformLocation(program, "lightData"), CLUSTERED_FIRST_UNIT);
+	glUniform1i(glGetUniformLocation(program, "clusterData"), CLUSTERED_FIRST_UNIT + 1);
+	glUniform1i(glGetUniformLocation(program, "lightIndices"), CLUSTERED_FIRST_UNIT + 2);
+	glUniform2f(glGetUniformLocation(program, "clusterTileScale"), (float)CLUSTERED_TILES_X / renderWidth, (float)CLUSTERED_TILES_Y / renderHeight);
+	glUniform1f(glGetUniformLocation(program, "clusterDepthScale"), in.depthScale);
+	glUniform1f(glGetUniformLocation(program, "clusterDepthBias"), in.depthBias);
+	glUniform3f(glGetUniformLocation(program, "viewForward"), in.viewForward.x, in.viewForward.y, in.viewForward.z);
+}
+
+float ClusteredLighting::getAssignMs()
+{
+	return assignMs;
+}
+
+unsigned int ClusteredLighting::getVisibleLightCount()
+{
+	return visibleLights;
+}
+
+unsigned int ClusteredLighting::getIndexCount()
+{
+	return (unsigned int)lists[current].indices.size();
+}
+
+unsigned int ClusteredLighting::getMaxClusterLights()
+{
+	return maxClusterLights;
+}
+
+unsigned int ClusteredLighting::getOverflowCount()
+{
+	return overflowCount;
+}
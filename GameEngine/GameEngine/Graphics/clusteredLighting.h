@@ -0,0 +1,121 @@
+#pragma once
+
+#include <glew.h>
+#include <glm.hpp>
+#include <vector>
+#include "..\Camera\camera.h"
+
+// cluster grid: screen tiles times depth slices, the slices spaced exponentially from near to far
+#define CLUSTERED_TILES_X 16
+#define CLUSTERED_TILES_Y 9
+#define CLUSTERED_SLICES 24
+#define CLUSTERED_CLUSTER_COUNT (CLUSTERED_TILES_X * CLUSTERED_TILES_Y * CLUSTERED_SLICES)
+// light indices are uploaded as 16 bit
+#define CLUSTERED_MAX_LIGHTS 1024
+// lights past this many in one cluster are dropped from it and counted as overflow
+#define CLUSTERED_MAX_LIGHTS_PER_CLUSTER 128
+// below this many lights the assignment stays on the calling thread
+#define CLUSTERED_MIN_PARALLEL_LIGHTS 128
+// lights per job of the bounds pass
+#define CLUSTERED_BOUNDS_BATCH 256
+// the light, cluster and index buffers sit on these units, clear of the mesh textures
+#define CLUSTERED_FIRST_UNIT 4
+
+// Clustered forward lighting for point lights. Every frame the view frustum is cut into a
+// CLUSTERED_TILES_X x CLUSTERED_TILES_Y x CLUSTERED_SLICES grid and each light is put in the
+// clusters its sphere touches: per depth slice, the screen rectangle of the part of the sphere
+// inside that slice. The result is a compact list, per cluster an offset and a count into one
+// array of light indices. Lights, clusters and indices go to the shader as texture buffers
+// (GLSL 400 has no storage buffers), and every fragment only shades the lights of the cluster
+// it falls in.
+// assign() is CPU only, it runs on the worker threads and with SSE2 where available; bind()
+// does the uploads and needs the GL context.
+class ClusteredLighting
+{
+	private:
+		// what bind() uploads: offset and count per cluster, then the indices they point into,
+		// and the frame's depth mapping
+		struct ClusterLists
+		{
+			std::vector<unsigned int> ranges;
+			std::vector<unsigned short> indices;
+			float depthScale;
+			float depthBias;
+			glm::vec3 viewForward;
+		};
+
+		// a light in view space this frame, minSlice > maxSlice when it is not visible
+		struct LightBounds
+		{
+			float viewX;
+			float viewY;
+			float depth;
+			float radius;
+			int minSlice;
+			int maxSlice;
+		};
+
+		// lights one attribute after the other, so four of them fit in an SSE register
+		std::vector<float> positionsX;
+		std::vector<float> positionsY;
+		std::vector<float> positionsZ;
+		std::vector<float> radii;
+		std::vector<glm::vec3> colors;
+		bool lightsChanged;
+
+		std::vector<LightBounds> bounds;
+		// fixed room per cluster, each slice only writes its own clusters
+		std::vector<unsigned short> clusterLights;
+		std::vector<unsigned int> clusterCounts;
+		unsigned int sliceOverflows[CLUSTERED_SLICES];
+		// assign() alternates between the two, so it can fill one while the render thread
+		// still uploads the other
+		ClusterLists lists[2];
+		unsigned int current;
+
+		float depthScale;
+		float depthBias;
+		// view depth where each slice starts, the last entry is the far plane
+		float sliceDepths[CLUSTERED_SLICES + 1];
+		float scaleX;
+		float scaleY;
+		glm::vec3 viewForward;
+
+		GLuint buffers[3];
+		GLuint textures[3];
+
+		float assignMs;
+		unsigned int visibleLights;
+		unsigned int maxClusterLights;
+		unsigned int overflowCount;
+
+		void computeBounds(const CameraRenderState& camera, unsigned int first, unsigned int last);
+		void fillSlice(int slice);
+
+	public:
+		ClusteredLighting();
+
+		// only the texture buffers: lights can be added and assigned before there is a context
+		void init();
+		void shutdown();
+
+		void clearLights();
+		// false once CLUSTERED_MAX_LIGHTS lights were added
+		bool addLight(const glm::vec3& position, float radius, const glm::vec3& color);
+		unsigned int getLightCount();
+
+		// rebuilds the cluster lists for this frame's camera; returns which lists it wrote, for bind()
+		unsigned int assign(const CameraRenderState& camera);
+		// uploads the lists assign() returned and points program (already in use) at them;
+		// renderWidth x renderHeight is the viewport the scene is drawn at, gl_FragCoord is
+		// measured against it. The lists stay valid until the assign() after next
+		void bind(GLuint program, unsigned int assigned, int renderWidth, int renderHeight);
+
+		float getAssignMs();
+		unsigned int getVisibleLightCount();
+		unsigned int getIndexCount();
+		unsigned int getMaxClusterLights();
+		unsigned int getOverflowCount();
+};
+
+extern ClusteredLighting clusteredLighting;
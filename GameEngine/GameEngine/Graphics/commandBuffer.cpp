@@ -0,0 +1,145 @@
+#include "commandBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+CommandBuffer::CommandBuffer()
+{
+	this->used = 0;
+	this->packetCount = 0;
+}
+
+void CommandBuffer::reset()
+{
+	used = 0;
+	packetCount = 0;
+}
+
+void* CommandBuffer::append(RenderCommandType type, size_t size)
+{
+	size = (size + COMMAND_BUFFER_ALIGNMENT - 1) & ~(size_t)(COMMAND_BUFFER_ALIGNMENT - 1);
+	if (used + size > bytes.size())
+		bytes.resize(std::max(std::max(bytes.size() * 2, used + size), (size_t)COMMAND_BUFFER_INITIAL_BYTES));
+
+	RenderCommandHeader* header = (RenderCommandHeader*)&bytes[used];
+	header->type = type;
+	header->size = (unsigned int)size;
+	used += size;
+	packetCount++;
+	return header;
+}
+
+void CommandBuffer::beginFrame(unsigned long long frame)
+{
+	BeginFrameCommand* command = (BeginFrameCommand*)append(RENDER_COMMAND_BEGIN_FRAME, sizeof(BeginFrameCommand));
+	command->frame = frame;
+}
+
+void CommandBuffer::clear(bool color, bool depth)
+{
+	ClearCommand* command = (ClearCommand*)append(RENDER_COMMAND_CLEAR, sizeof(ClearCommand));
+	command->color = color;
+	command->depth = depth;
+}
+
+void CommandBuffer::useShader(Shader* shader)
+{
+	UseShaderCommand* command = (UseShaderCommand*)append(RENDER_COMMAND_USE_SHADER, sizeof(UseShaderCommand));
+	command->shader = shader;
+}
+
+void CommandBuffer::useProgram(unsigned int program)
+{
+	UseProgramCommand* command = (UseProgramCommand*)append(RENDER_COMMAND_USE_PROGRAM, sizeof(UseProgramCommand));
+	command->program = program;
+}
+
+void CommandBuffer::setDepthFunc(RenderDepthFunc func)
+{
+	DepthFuncCommand* command = (DepthFuncCommand*)append(RENDER_COMMAND_DEPTH_FUNC, sizeof(DepthFuncCommand));
+	command->func = func;
+}
+
+void CommandBuffer::setUniform(const char* name, const glm::mat4& value)
+{
+	UniformMat4Command* command = (UniformMat4Command*)append(RENDER_COMMAND_UNIFORM_MAT4, sizeof(UniformMat4Command));
+	command->name = name;
+	memcpy(command->value, &value[0][0], sizeof(command->value));
+}
+
+void CommandBuffer::setUniform(const char* name, const glm::vec3& value)
+{
+	UniformVec3Command* command = (UniformVec3Command*)append(RENDER_COMMAND_UNIFORM_VEC3, sizeof(UniformVec3Command));
+	command->name = name;
+	command->value[0] = value.x;
+	command->value[1] = value.y;
+	command->value[2] = value.z;
+}
+
+void CommandBuffer::bindTexture(unsigned int unit, RenderTextureTarget target, unsigned int texture)
+{
+	BindTextureCommand* command = (BindTextureCommand*)append(RENDER_COMMAND_BIND_TEXTURE, sizeof(BindTextureCommand));
+	command->unit = unit;
+	command->target = target;
+	command->texture = texture;
+}
+
+void CommandBuffer::drawMesh(Mesh* mesh)
+{
+	DrawMeshCommand* command = (DrawMeshCommand*)append(RENDER_COMMAND_DRAW_MESH, sizeof(DrawMeshCommand));
+	command->mesh = mesh;
+}
+
+void CommandBuffer::drawArrays(unsigned int vertexArray, unsigned int first, unsigned int count)
+{
+	DrawArraysCommand* command = (DrawArraysCommand*)append(RENDER_COMMAND_DRAW_ARRAYS, sizeof(DrawArraysCommand));
+	command->vertexArray = vertexArray;
+	command->first = first;
+	command->count = count;
+}
+
+void CommandBuffer::beginGpuScope(const char* name)
+{
+	GpuScopeCommand* command = (GpuScopeCommand*)append(RENDER_COMMAND_BEGIN_GPU_SCOPE, sizeof(GpuScopeCommand));
+	command->name = name;
+}
+
+void CommandBuffer::endGpuScope()
+{
+	append(RENDER_COMMAND_END_GPU_SCOPE, sizeof(RenderCommandHeader));
+}
+
+void CommandBuffer::call(RenderCallback function, const void* data, size_t size)
+{
+	CallbackCommand* command = (CallbackCommand*)append(RENDER_COMMAND_CALLBACK, sizeof(CallbackCommand) + size);
+	command->function = function;
+	command->dataSize = (unsigned int)size;
+	if (size > 0)
+		memcpy(command + 1, data, size);
+}
+
+void CommandBuffer::present(int width, int height)
+{
+	PresentCommand* command = (PresentCommand*)append(RENDER_COMMAND_PRESENT, sizeof(PresentCommand));
+	command->width = width;
+	command->height = height;
+}
+
+const RenderCommandHeader* CommandBuffer::read(size_t& offset) const
+{
+	if (offset >= used)
+		return NULL;
+
+	const RenderCommandHeader* header = (const RenderCommandHeader*)&bytes[offset];
+	offset += header->size;
+	return header;
+}
+
+size_t CommandBuffer::getSize()
+{
+	return used;
+}
+
+unsigned int CommandBuffer::getPacketCount()
+{
+	return packetCount;
+}
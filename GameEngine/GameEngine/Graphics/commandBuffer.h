@@ -0,0 +1,189 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <vector>
+#include "..\Shaders\shader.h"
+#include "..\Model Loading\mesh.h"
+
+// every packet starts on this boundary, so pointers and 64 bit values in them stay aligned
+#define COMMAND_BUFFER_ALIGNMENT 8
+// room reserved up front; a frame of the level records a few KB
+#define COMMAND_BUFFER_INITIAL_BYTES (64 * 1024)
+
+enum RenderCommandType
+{
+	RENDER_COMMAND_BEGIN_FRAME,
+	RENDER_COMMAND_CLEAR,
+	RENDER_COMMAND_USE_SHADER,
+	RENDER_COMMAND_USE_PROGRAM,
+	RENDER_COMMAND_DEPTH_FUNC,
+	RENDER_COMMAND_UNIFORM_MAT4,
+	RENDER_COMMAND_UNIFORM_VEC3,
+	RENDER_COMMAND_BIND_TEXTURE,
+	RENDER_COMMAND_DRAW_MESH,
+	RENDER_COMMAND_DRAW_ARRAYS,
+	RENDER_COMMAND_BEGIN_GPU_SCOPE,
+	RENDER_COMMAND_END_GPU_SCOPE,
+	RENDER_COMMAND_CALLBACK,
+	RENDER_COMMAND_PRESENT,
+	RENDER_COMMAND_TYPE_COUNT
+};
+
+enum RenderDepthFunc
+{
+	RENDER_DEPTH_LESS,
+	RENDER_DEPTH_LEQUAL
+};
+
+enum RenderTextureTarget
+{
+	RENDER_TEXTURE_2D,
+	RENDER_TEXTURE_2D_ARRAY,
+	RENDER_TEXTURE_CUBE_MAP
+};
+
+// runs on the thread that replays the buffer, data points at the copy made when it was recorded
+typedef void (*RenderCallback)(const void* data);
+
+struct RenderCommandHeader
+{
+	unsigned int type;
+	// header included, rounded up to COMMAND_BUFFER_ALIGNMENT
+	unsigned int size;
+};
+
+struct BeginFrameCommand
+{
+	RenderCommandHeader header;
+	unsigned long long frame;
+};
+
+struct ClearCommand
+{
+	RenderCommandHeader header;
+	bool color;
+	bool depth;
+};
+
+struct UseShaderCommand
+{
+	RenderCommandHeader header;
+	Shader* shader;
+};
+
+struct UseProgramCommand
+{
+	RenderCommandHeader header;
+	unsigned int program;
+};
+
+struct DepthFuncCommand
+{
+	RenderCommandHeader header;
+	RenderDepthFunc func;
+};
+
+// uniforms are set by name on the program in use; names must outlive the buffer (literals)
+struct UniformMat4Command
+{
+	RenderCommandHeader header;
+	const char* name;
+	float value[16];
+};
+
+struct UniformVec3Command
+{
+	RenderCommandHeader header;
+	const char* name;
+	float value[3];
+};
+
+struct BindTextureCommand
+{
+	RenderCommandHeader header;
+	unsigned int unit;
+	RenderTextureTarget target;
+	unsigned int texture;
+};
+
+// draws with the shader of the last USE_SHADER
+struct DrawMeshCommand
+{
+	RenderCommandHeader header;
+	Mesh* mesh;
+};
+
+struct DrawArraysCommand
+{
+	RenderCommandHeader header;
+	unsigned int vertexArray;
+	unsigned int first;
+	unsigned int count;
+};
+
+struct GpuScopeCommand
+{
+	RenderCommandHeader header;
+	const char* name;
+};
+
+// followed by dataSize bytes of data
+struct CallbackCommand
+{
+	RenderCommandHeader header;
+	RenderCallback function;
+	unsigned int dataSize;
+};
+
+struct PresentCommand
+{
+	RenderCommandHeader header;
+	int width;
+	int height;
+};
+
+// One frame of rendering as a list of packets: state changes, uniforms, draws, and callbacks
+// for the passes that own their GL objects (shadows, upscaling, queries). Nothing here calls
+// GL; the buffer is recorded on the main thread and replayed by the render thread (see
+// renderThread.h), so everything a packet needs is copied into it when it is recorded.
+// Packets sit back to back in one byte array that keeps its capacity across reset(), so
+// recording a frame does not allocate once the array has grown to the frame's size.
+class CommandBuffer
+{
+	private:
+		std::vector<unsigned char> bytes;
+		size_t used;
+		unsigned int packetCount;
+
+		void* append(RenderCommandType type, size_t size);
+
+	public:
+		CommandBuffer();
+
+		void reset();
+
+		// frame is the profiler's frame the GPU scopes that follow belong to
+		void beginFrame(unsigned long long frame);
+		void clear(bool color, bool depth);
+		void useShader(Shader* shader);
+		// a raw program, for shaders built outside the Shader class; DRAW_MESH needs a Shader
+		void useProgram(unsigned int program);
+		void setDepthFunc(RenderDepthFunc func);
+		void setUniform(const char* name, const glm::mat4& value);
+		void setUniform(const char* name, const glm::vec3& value);
+		void bindTexture(unsigned int unit, RenderTextureTarget target, unsigned int texture);
+		void drawMesh(Mesh* mesh);
+		void drawArrays(unsigned int vertexArray, unsigned int first, unsigned int count);
+		void beginGpuScope(const char* name);
+		void endGpuScope();
+		// size bytes at data are copied into the buffer and handed to function on replay
+		void call(RenderCallback function, const void* data, size_t size);
+		void present(int width, int height);
+
+		// walks the packets in recording order: start with offset 0, NULL after the last one
+		const RenderCommandHeader* read(size_t& offset) const;
+
+		size_t getSize();
+		unsigned int getPacketCount();
+};
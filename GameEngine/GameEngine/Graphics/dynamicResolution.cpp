@@ -0,0 +1,260 @@
+#include "dynamicResolution.h"
+#include "glState.h"
+#include "glStats.h"
+#include "..\imgui\imgui.h"
+#include <cmath>
+#include <iostream>
+
+DynamicResolution dynamicResolution;
+
+DynamicResolution::DynamicResolution()
+{
+	this->framebuffer = 0;
+	this->colorTexture = 0;
+	this->depthBuffer = 0;
+	this->targetWidth = 0;
+	this->targetHeight = 0;
+	this->targetsComplete = false;
+	this->offscreen = false;
+	this->emptyVertexArray = 0;
+	this->upscaleShader = NULL;
+
+	for (int i = 0; i <= DYNAMIC_RESOLUTION_LATENCY; i++)
+	{
+		this->queries[i][0] = 0;
+		this->queries[i][1] = 0;
+		this->issued[i] = false;
+		this->slotScales[i] = DYNAMIC_RESOLUTION_MAX_SCALE;
+	}
+	this->slot = 0;
+
+	this->enabled = true;
+	this->targetMs = DYNAMIC_RESOLUTION_TARGET_MS;
+	this->sharpness = DYNAMIC_RESOLUTION_SHARPNESS;
+	this->scale = DYNAMIC_RESOLUTION_MAX_SCALE;
+	this->renderWidth = 0;
+	this->renderHeight = 0;
+	this->lastGpuMs = 0.0f;
+	this->historyCount = 0;
+	this->historyNext = 0;
+}
+
+void DynamicResolution::init()
+{
+	glGenFramebuffers(1, &framebuffer);
+	glGenQueries(2 * (DYNAMIC_RESOLUTION_LATENCY + 1), &queries[0][0]);
+	// core profile draws need a vertex array even when the shader makes up the vertices
+	glGenVertexArrays(1, &emptyVertexArray);
+	upscaleShader = new Shader("Shaders/upscale_vertex_shader.glsl", "Shaders/upscale_fragment_shader.glsl");
+}
+
+void DynamicResolution::shutdown()
+{
+	if (framebuffer != 0)
+		glState.deleteFramebuffer(framebuffer);
+	if (colorTexture != 0)
+		glState.deleteTexture(colorTexture);
+	if (depthBuffer != 0)
+		glDeleteRenderbuffers(1, &depthBuffer);
+	if (emptyVertexArray != 0)
+		glState.deleteVertexArray(emptyVertexArray);
+	if (queries[0][0] != 0)
+		glDeleteQueries(2 * (DYNAMIC_RESOLUTION_LATENCY + 1), &queries[0][0]);
+	if (upscaleShader != NULL)
+	{
+		glDeleteProgram(upscaleShader->getId());
+		delete upscaleShader;
+	}
+
+	framebuffer = 0;
+	colorTexture = 0;
+	depthBuffer = 0;
+	emptyVertexArray = 0;
+	queries[0][0] = 0;
+	upscaleShader = NULL;
+}
+
+bool DynamicResolution::resize(int width, int height)
+{
+	if (colorTexture != 0)
+		glState.deleteTexture(colorTexture);
+	if (depthBuffer != 0)
+		glDeleteRenderbuffers(1, &depthBuffer);
+
+	glGenTextures(1, &colorTexture);
+	glState.bindTexture(GL_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+	glState.bindFramebuffer(framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	targetWidth = width;
+	targetHeight = height;
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		// tried again when the window size changes
+		std::cout << "Offscreen scene framebuffer is incomplete at " << width << "x" << height << ", rendering at window size" << std::endl;
+		glState.bindFramebuffer(0);
+		return false;
+	}
+	return true;
+}
+
+void DynamicResolution::readQueries()
+{
+	// the slot about to be reused was issued DYNAMIC_RESOLUTION_LATENCY frames ago, its
+	// result is almost always back and waiting for it is the exception
+	if (!issued[slot])
+		return;
+	issued[slot] = false;
+
+	GLuint64 start = 0, end = 0;
+	glGetQueryObjectui64v(queries[slot][0], GL_QUERY_RESULT, &start);
+	glGetQueryObjectui64v(queries[slot][1], GL_QUERY_RESULT, &end);
+	lastGpuMs = (float)((end - start) / 1000000.0);
+
+	if (enabled && lastGpuMs > 0.0f)
+	{
+		// measured at the scale that frame used, not the current one
+		float ideal = slotScales[slot] * sqrtf(targetMs / lastGpuMs);
+		scale += (ideal - scale) * DYNAMIC_RESOLUTION_DAMPING;
+		if (scale < DYNAMIC_RESOLUTION_MIN_SCALE)
+			scale = DYNAMIC_RESOLUTION_MIN_SCALE;
+		if (scale > DYNAMIC_RESOLUTION_MAX_SCALE)
+			scale = DYNAMIC_RESOLUTION_MAX_SCALE;
+	}
+}
+
+void DynamicResolution::beginScene(int windowWidth, int windowHeight)
+{
+	readQueries();
+
+	// a minimized window has a 0x0 framebuffer, there is nothing to allocate until it is back
+	bool visible = windowWidth > 0 && windowHeight > 0;
+	if (enabled && visible && (windowWidth != targetWidth || windowHeight != targetHeight))
+		targetsComplete = resize(windowWidth, windowHeight);
+	offscreen = enabled && visible && targetsComplete;
+
+	float used = offscreen ? scale : DYNAMIC_RESOLUTION_MAX_SCALE;
+	renderWidth = (int)(windowWidth * used + 0.5f);
+	renderHeight = (int)(windowHeight * used + 0.5f);
+	if (renderWidth < 1)
+		renderWidth = 1;
+	if (renderHeight < 1)
+		renderHeight = 1;
+
+	if (offscreen)
+	{
+		glState.bindFramebuffer(framebuffer);
+		glViewport(0, 0, renderWidth, renderHeight);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+	slotScales[slot] = used;
+
+	scaleHistory[historyNext] = used;
+	gpuHistory[historyNext] = lastGpuMs;
+	historyNext = (historyNext + 1) % DYNAMIC_RESOLUTION_HISTORY;
+	if (historyCount < DYNAMIC_RESOLUTION_HISTORY)
+		historyCount++;
+}
+
+void DynamicResolution::endScene()
+{
+	glQueryCounter(queries[slot][1], GL_TIMESTAMP);
+	issued[slot] = true;
+	slot = (slot + 1) % (DYNAMIC_RESOLUTION_LATENCY + 1);
+
+	if (!offscreen)
+		return;
+
+	int windowWidth = targetWidth;
+	int windowHeight = targetHeight;
+	glState.bindFramebuffer(0);
+	glViewport(0, 0, windowWidth, windowHeight);
+
+	// the blit covers every pixel, nothing to test against
+	glState.setDepthTest(false);
+	upscaleShader->use();
+	glState.bindTexture(0, GL_TEXTURE_2D, colorTexture);
+
+	GLuint program = upscaleShader->getId();
+	float u = (float)renderWidth / targetWidth;
+	float v = (float)renderHeight / targetHeight;
+	float texelU = 1.0f / targetWidth;
+	float texelV = 1.0f / targetHeight;
+	glUniform1i(glGetUniformLocation(program, "scene"), 0);
+	glUniform2f(glGetUniformLocation(program, "uvScale"), u, v);
+	glUniform2f(glGetUniformLocation(program, "uvMin"), texelU * 0.5f, texelV * 0.5f);
+	glUniform2f(glGetUniformLocation(program, "uvMax"), u - texelU * 0.5f, v - texelV * 0.5f);
+	glUniform2f(glGetUniformLocation(program, "texelSize"), texelU, texelV);
+	// at full resolution there is nothing to sharpen back
+	glUniform1f(glGetUniformLocation(program, "sharpness"), renderWidth < targetWidth ? sharpness : 0.0f);
+
+	glState.bindVertexArray(emptyVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glState.setDepthTest(true);
+}
+
+void DynamicResolution::setEnabled(bool enabled)
+{
+	this->enabled = enabled;
+	// no GL here, this is called between frames from the main thread, which may not have the
+	// context; endScene() already went back to the default framebuffer
+	if (!enabled)
+		scale = DYNAMIC_RESOLUTION_MAX_SCALE;
+	else
+		// reallocated and checked again on the next frame
+		targetWidth = 0;
+}
+
+void DynamicResolution::setTargetMs(float ms)
+{
+	if (ms > 0.0f)
+		targetMs = ms;
+}
+
+float DynamicResolution::getScale()
+{
+	return enabled ? scale : DYNAMIC_RESOLUTION_MAX_SCALE;
+}
+
+int DynamicResolution::getRenderWidth()
+{
+	return renderWidth;
+}
+
+int DynamicResolution::getRenderHeight()
+{
+	return renderHeight;
+}
+
+void DynamicResolution::drawOverlay()
+{
+	ImGui::Begin("Dynamic resolution");
+
+	bool on = enabled;
+	if (ImGui::Checkbox("Enabled", &on))
+		setEnabled(on);
+	ImGui::SliderFloat("Target GPU ms", &targetMs, 4.0f, 33.0f, "%.1f");
+	ImGui::SliderFloat("Sharpness", &sharpness, 0.0f, 1.0f, "%.2f");
+
+	ImGui::Text("Scale %.2f: %d x %d, scene GPU %.2f ms", getScale(), renderWidth, renderHeight, lastGpuMs);
+
+	int offset = historyCount < DYNAMIC_RESOLUTION_HISTORY ? 0 : historyNext;
+	ImGui::PlotLines("##scale", scaleHistory, historyCount, offset, "scale", DYNAMIC_RESOLUTION_MIN_SCALE, DYNAMIC_RESOLUTION_MAX_SCALE,
+		ImVec2(ImGui::GetContentRegionAvail().x, 50.0f));
+	ImGui::PlotLines("##scenegpu", gpuHistory, historyCount, offset, "scene GPU ms", 0.0f, targetMs * 2.0f,
+		ImVec2(ImGui::GetContentRegionAvail().x, 50.0f));
+	ImGui::End();
+}
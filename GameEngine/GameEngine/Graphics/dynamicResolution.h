@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glew.h>
+#include "..\Shaders\shader.h"
+
+// frames kept for the overlay graphs
+#define DYNAMIC_RESOLUTION_HISTORY 240
+// timestamp queries are read back this many frames after they were issued
+#define DYNAMIC_RESOLUTION_LATENCY 4
+#define DYNAMIC_RESOLUTION_MIN_SCALE 0.5f
+#define DYNAMIC_RESOLUTION_MAX_SCALE 1.0f
+// share of the gap to the ideal scale closed each frame; the GPU time is noisy
+#define DYNAMIC_RESOLUTION_DAMPING 0.1f
+// a little under 60 Hz, so the swap never misses a vertical blank
+#define DYNAMIC_RESOLUTION_TARGET_MS 14.0f
+#define DYNAMIC_RESOLUTION_SHARPNESS 0.3f
+
+// Renders the 3D scene into an offscreen framebuffer at a fraction of the window size and
+// upscales it to the window. The fraction follows the scene's GPU time, measured with a pair of
+// GL_TIMESTAMP queries around it (they do not clash with the profiler's GL_TIME_ELAPSED
+// scopes): pixel count scales with the square of the fraction, so the next scale is the last
+// one times sqrt(target / measured), damped. The targets are allocated at window size and the
+// scene is drawn into their lower left corner, so changing the scale never reallocates.
+class DynamicResolution
+{
+	private:
+		GLuint framebuffer;
+		GLuint colorTexture;
+		GLuint depthBuffer;
+		int targetWidth;
+		int targetHeight;
+		bool targetsComplete;
+		// whether the frame between beginScene() and endScene() goes through the targets
+		bool offscreen;
+
+		GLuint emptyVertexArray;
+		Shader* upscaleShader;
+
+		GLuint queries[DYNAMIC_RESOLUTION_LATENCY + 1][2];
+		bool issued[DYNAMIC_RESOLUTION_LATENCY + 1];
+		// the scale each in-flight frame was drawn at
+		float slotScales[DYNAMIC_RESOLUTION_LATENCY + 1];
+		int slot;
+
+		bool enabled;
+		float targetMs;
+		float sharpness;
+		float scale;
+		int renderWidth;
+		int renderHeight;
+		float lastGpuMs;
+
+		float scaleHistory[DYNAMIC_RESOLUTION_HISTORY];
+		float gpuHistory[DYNAMIC_RESOLUTION_HISTORY];
+		int historyCount;
+		int historyNext;
+
+		// false when the framebuffer came out incomplete at that size
+		bool resize(int width, int height);
+		void readQueries();
+
+	public:
+		DynamicResolution();
+
+		// what does not depend on the window; the targets are sized by the first beginScene()
+		void init();
+		void shutdown();
+
+		// binds the offscreen target at the current scale, viewport and clear included
+		void beginScene(int windowWidth, int windowHeight);
+		// back to the default framebuffer at window size, with the scene upscaled into it
+		void endScene();
+
+		void setEnabled(bool enabled);
+		void setTargetMs(float ms);
+		float getScale();
+		int getRenderWidth();
+		int getRenderHeight();
+
+		void drawOverlay();
+};
+
+extern DynamicResolution dynamicResolution;
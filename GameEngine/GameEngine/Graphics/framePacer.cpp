@@ -0,0 +1,252 @@
+#include "framePacer.h"
+#include "..\imgui\imgui.h"
+#include <glfw3.h>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+// timeBeginPeriod: without it a 1 ms sleep can take a whole 15.6 ms scheduler tick
+#pragma comment(lib, "winmm.lib")
+#endif
+
+FramePacer framePacer;
+
+static const char* modeNames[PACING_MODE_COUNT] = { "vsync", "off", "limit", "lowlatency" };
+static const char* modeLabels[PACING_MODE_COUNT] = { "Vsync", "Uncapped", "Fixed rate limiter", "Low latency (vsync + fence)" };
+
+const char* framePacingModeName(FramePacingMode mode)
+{
+	return mode < PACING_MODE_COUNT ? modeNames[mode] : "?";
+}
+
+bool parseFramePacingMode(const char* name, FramePacingMode& mode)
+{
+	for (int i = 0; i < PACING_MODE_COUNT; i++)
+	{
+		if (strcmp(name, modeNames[i]) == 0)
+		{
+			mode = (FramePacingMode)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+static double millisecondsBetween(std::chrono::high_resolution_clock::time_point from, std::chrono::high_resolution_clock::time_point to)
+{
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+FramePacer::FramePacer()
+{
+	this->mode = PACING_VSYNC;
+	this->targetFps = FRAME_PACER_DEFAULT_FPS;
+	this->fence = 0;
+	this->modeChanged = false;
+	this->presented = false;
+	this->currentWait = 0.0f;
+	resetStats();
+}
+
+void FramePacer::init(FramePacingMode mode)
+{
+#ifdef _WIN32
+	timeBeginPeriod(1);
+#endif
+	setMode(mode);
+}
+
+void FramePacer::shutdown()
+{
+	if (fence != 0)
+		glDeleteSync(fence);
+	fence = 0;
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::resetStats()
+{
+	count = 0;
+	next = 0;
+	presented = false;
+}
+
+void FramePacer::setMode(FramePacingMode mode)
+{
+	this->mode = mode;
+	// the swap interval and the old fence are dealt with by the next endFrame()
+	modeChanged = true;
+	deadline = std::chrono::high_resolution_clock::now();
+	resetStats();
+}
+
+FramePacingMode FramePacer::getMode()
+{
+	return mode;
+}
+
+void FramePacer::setTargetFps(float fps)
+{
+	if (fps > 0.0f)
+		targetFps = fps;
+}
+
+void FramePacer::waitUntil(std::chrono::high_resolution_clock::time_point time)
+{
+	std::chrono::duration<double, std::milli> spin(FRAME_PACER_SPIN_MS);
+	std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+
+	// sleep through most of it, the OS wakes us up late by up to a tick...
+	if (time - now > spin)
+		std::this_thread::sleep_for(time - now - spin);
+
+	// ...and spin the last stretch to hit the deadline exactly
+	while (std::chrono::high_resolution_clock::now() < time)
+		std::this_thread::yield();
+}
+
+void FramePacer::waitForFrame()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	if (mode == PACING_LIMITED)
+	{
+		std::chrono::high_resolution_clock::duration period = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+			std::chrono::duration<double>(1.0 / targetFps));
+		deadline += period;
+		// more than a frame behind: start counting again from now instead of rushing to catch up
+		if (deadline + period < start)
+			deadline = start;
+		waitUntil(deadline);
+	}
+	else if (mode == PACING_LOW_LATENCY && fence != 0)
+	{
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FRAME_PACER_FENCE_TIMEOUT_NS);
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	inputTime = std::chrono::high_resolution_clock::now();
+	currentWait = (float)millisecondsBetween(start, inputTime);
+}
+
+FrameTiming FramePacer::getFrameTiming()
+{
+	FrameTiming timing;
+	timing.inputTime = inputTime;
+	timing.wait = currentWait;
+	return timing;
+}
+
+void FramePacer::endFrame(const FrameTiming& timing)
+{
+	std::chrono::high_resolution_clock::time_point present = std::chrono::high_resolution_clock::now();
+
+	if (modeChanged)
+	{
+		glfwSwapInterval(mode == PACING_VSYNC || mode == PACING_LOW_LATENCY ? 1 : 0);
+		if (fence != 0)
+			glDeleteSync(fence);
+		fence = 0;
+		modeChanged = false;
+	}
+
+	if (mode == PACING_LOW_LATENCY)
+	{
+		if (fence != 0)
+			glDeleteSync(fence);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	if (presented)
+	{
+		latencies[next] = (float)millisecondsBetween(timing.inputTime, present);
+		frameTimes[next] = (float)millisecondsBetween(lastPresent, present);
+		waits[next] = timing.wait;
+		next = (next + 1) % FRAME_PACER_HISTORY;
+		if (count < FRAME_PACER_HISTORY)
+			count++;
+	}
+	lastPresent = present;
+	presented = true;
+}
+
+float FramePacer::getAverageLatencyMs()
+{
+	float sum = 0.0f;
+	for (int i = 0; i < count; i++)
+		sum += latencies[i];
+	return count > 0 ? sum / count : 0.0f;
+}
+
+float FramePacer::getMaxLatencyMs()
+{
+	float max = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		if (latencies[i] > max)
+			max = latencies[i];
+	}
+	return max;
+}
+
+float FramePacer::getAverageFrameMs()
+{
+	float sum = 0.0f;
+	for (int i = 0; i < count; i++)
+		sum += frameTimes[i];
+	return count > 0 ? sum / count : 0.0f;
+}
+
+float FramePacer::getFrameMsDeviation()
+{
+	if (count < 2)
+		return 0.0f;
+
+	float average = getAverageFrameMs();
+	float sum = 0.0f;
+	for (int i = 0; i < count; i++)
+		sum += (frameTimes[i] - average) * (frameTimes[i] - average);
+	return sqrtf(sum / (count - 1));
+}
+
+float FramePacer::getAverageWaitMs()
+{
+	float sum = 0.0f;
+	for (int i = 0; i < count; i++)
+		sum += waits[i];
+	return count > 0 ? sum / count : 0.0f;
+}
+
+void FramePacer::drawOverlay()
+{
+	ImGui::Begin("Frame pacing");
+
+	int selected = mode;
+	if (ImGui::Combo("Mode", &selected, modeLabels, PACING_MODE_COUNT))
+		setMode((FramePacingMode)selected);
+	if (mode == PACING_LIMITED)
+	{
+		float fps = targetFps;
+		if (ImGui::SliderFloat("Target FPS", &fps, 20.0f, 240.0f, "%.0f"))
+			setTargetFps(fps);
+	}
+
+	float average = getAverageFrameMs();
+	float deviation = getFrameMsDeviation();
+	ImGui::Text("Input to present: %.2f ms avg, %.2f ms max", getAverageLatencyMs(), getMaxLatencyMs());
+	ImGui::Text("Frame time: %.3f ms avg, %.3f ms std dev (variance %.3f)", average, deviation, deviation * deviation);
+	ImGui::Text("Pacing wait: %.2f ms avg", getAverageWaitMs());
+
+	// plotted in order, oldest first
+	ImGui::PlotLines("##pacedframes", frameTimes, count, count < FRAME_PACER_HISTORY ? 0 : next, "frame time (ms)", 0.0f, average * 2.0f + 1.0f,
+		ImVec2(ImGui::GetContentRegionAvail().x, 50.0f));
+	ImGui::PlotLines("##latency", latencies, count, count < FRAME_PACER_HISTORY ? 0 : next, "input to present (ms)", 0.0f, getMaxLatencyMs() * 1.2f + 1.0f,
+		ImVec2(ImGui::GetContentRegionAvail().x, 50.0f));
+	ImGui::End();
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <glew.h>
+#include <chrono>
+
+// frames kept for the latency and frame time statistics
+#define FRAME_PACER_HISTORY 240
+// the limiter sleeps until this close to the deadline and spins for the rest
+#define FRAME_PACER_SPIN_MS 2.0
+#define FRAME_PACER_DEFAULT_FPS 60.0f
+// a fence from the previous frame that takes longer than this is given up on
+#define FRAME_PACER_FENCE_TIMEOUT_NS 100000000ULL
+
+enum FramePacingMode
+{
+	// swap interval 1, the driver paces
+	PACING_VSYNC,
+	// swap interval 0, as fast as the GPU goes
+	PACING_UNCAPPED,
+	// swap interval 0, the CPU waits for a fixed rate with a sleep followed by a spin
+	PACING_LIMITED,
+	// swap interval 1, and input is not sampled until the GPU has finished the previous frame,
+	// so the CPU never runs a frame ahead of it
+	PACING_LOW_LATENCY,
+	PACING_MODE_COUNT
+};
+
+// what endFrame() needs to know about the frame it closes, taken at the end of waitForFrame()
+struct FrameTiming
+{
+	std::chrono::high_resolution_clock::time_point inputTime;
+	float wait;
+};
+
+// Paces the main loop and measures it. waitForFrame() blocks as the mode asks and is followed
+// by polling input; endFrame() comes right after the swap. Input-to-present latency is the
+// time from the end of waitForFrame to SwapBuffers returning.
+// The swap can happen on the render thread while the main thread already waits for the next
+// frame, so endFrame() gets that frame's timing passed in, and everything that needs the GL
+// context (the swap interval, the fence) is done in endFrame(), on the thread that swaps. The
+// fence wait of PACING_LOW_LATENCY is the exception: that mode needs the main thread to hold
+// the context.
+class FramePacer
+{
+	private:
+		FramePacingMode mode;
+		float targetFps;
+		std::chrono::high_resolution_clock::time_point deadline;
+		GLsync fence;
+		// setMode() ran since the last endFrame()
+		bool modeChanged;
+
+		std::chrono::high_resolution_clock::time_point inputTime;
+		std::chrono::high_resolution_clock::time_point lastPresent;
+		bool presented;
+
+		// ring of the last FRAME_PACER_HISTORY frames
+		float latencies[FRAME_PACER_HISTORY];
+		float frameTimes[FRAME_PACER_HISTORY];
+		float waits[FRAME_PACER_HISTORY];
+		int count;
+		int next;
+		float currentWait;
+
+		void resetStats();
+		void waitUntil(std::chrono::high_resolution_clock::time_point time);
+
+	public:
+		FramePacer();
+
+		// the fence and the swap interval need a current context, so they are set up separately
+		void init(FramePacingMode mode);
+		void shutdown();
+
+		void setMode(FramePacingMode mode);
+		FramePacingMode getMode();
+		void setTargetFps(float fps);
+
+		void waitForFrame();
+		FrameTiming getFrameTiming();
+		void endFrame(const FrameTiming& timing);
+
+		// over the frames in the history, in milliseconds
+		float getAverageLatencyMs();
+		float getMaxLatencyMs();
+		float getAverageFrameMs();
+		float getFrameMsDeviation();
+		float getAverageWaitMs();
+
+		void drawOverlay();
+};
+
+extern FramePacer framePacer;
+
+const char* framePacingModeName(FramePacingMode mode);
+// "vsync", "off", "limit" or "lowlatency"; returns false for anything else
+bool parseFramePacingMode(const char* name, FramePacingMode& mode);
@@ -0,0 +1,231 @@
+#include "glState.h"
+#include "glStats.h"
+
+GlState glState;
+
+GlState::GlState()
+{
+	invalidate();
+}
+
+void GlState::invalidate()
+{
+	program = -1;
+	vertexArray = -1;
+	arrayBuffer = -1;
+	elementBuffer = -1;
+	pixelUnpackBuffer = -1;
+	readFramebuffer = -1;
+	drawFramebuffer = -1;
+	activeUnit = -1;
+	for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++)
+	{
+		for (int slot = 0; slot < GL_STATE_TEXTURE_TARGETS; slot++)
+			textures[unit][slot] = -1;
+	}
+
+	depthTest = -1;
+	depthMask = -1;
+	depthFunc = -1;
+	blend = -1;
+	blendSource = -1;
+	blendDestination = -1;
+	cullFace = -1;
+	cullMode = -1;
+}
+
+int GlState::textureSlot(GLenum target)
+{
+	if (target == GL_TEXTURE_2D)
+		return 0;
+	if (target == GL_TEXTURE_2D_ARRAY)
+		return 1;
+	if (target == GL_TEXTURE_CUBE_MAP)
+		return 2;
+	if (target == GL_TEXTURE_BUFFER)
+		return 3;
+	return -1;
+}
+
+void GlState::setCapability(GLenum capability, int& shadow, bool enabled)
+{
+	if (shadow == (int)enabled)
+		return;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	shadow = enabled;
+}
+
+void GlState::useProgram(GLuint program)
+{
+	if (this->program == program)
+		return;
+	glUseProgram(program);
+	this->program = program;
+}
+
+void GlState::bindVertexArray(GLuint array)
+{
+	if (vertexArray == array)
+		return;
+	glBindVertexArray(array);
+	vertexArray = array;
+	elementBuffer = -1;
+}
+
+void GlState::bindBuffer(GLenum target, GLuint buffer)
+{
+	long long* bound = NULL;
+	if (target == GL_ARRAY_BUFFER)
+		bound = &arrayBuffer;
+	else if (target == GL_ELEMENT_ARRAY_BUFFER)
+		bound = &elementBuffer;
+	else if (target == GL_PIXEL_UNPACK_BUFFER)
+		bound = &pixelUnpackBuffer;
+
+	if (bound != NULL && *bound == buffer)
+		return;
+	glBindBuffer(target, buffer);
+	if (bound != NULL)
+		*bound = buffer;
+}
+
+void GlState::bindFramebuffer(GLuint framebuffer)
+{
+	if (readFramebuffer == framebuffer && drawFramebuffer == framebuffer)
+		return;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	readFramebuffer = framebuffer;
+	drawFramebuffer = framebuffer;
+}
+
+void GlState::bindReadFramebuffer(GLuint framebuffer)
+{
+	if (readFramebuffer == framebuffer)
+		return;
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	readFramebuffer = framebuffer;
+}
+
+void GlState::bindDrawFramebuffer(GLuint framebuffer)
+{
+	if (drawFramebuffer == framebuffer)
+		return;
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	drawFramebuffer = framebuffer;
+}
+
+void GlState::activeTexture(unsigned int unit)
+{
+	if (activeUnit == unit)
+		return;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	activeUnit = unit;
+}
+
+void GlState::bindTexture(unsigned int unit, GLenum target, GLuint texture)
+{
+	int slot = textureSlot(target);
+	bool tracked = slot >= 0 && unit < GL_STATE_TEXTURE_UNITS;
+	if (tracked && textures[unit][slot] == texture)
+		return;
+
+	activeTexture(unit);
+	glBindTexture(target, texture);
+	if (tracked)
+		textures[unit][slot] = texture;
+}
+
+void GlState::deleteVertexArray(GLuint array)
+{
+	glDeleteVertexArrays(1, &array);
+	if (vertexArray == array)
+	{
+		vertexArray = 0;
+		elementBuffer = -1;
+	}
+}
+
+void GlState::deleteBuffer(GLuint buffer)
+{
+	glDeleteBuffers(1, &buffer);
+	if (arrayBuffer == buffer)
+		arrayBuffer = 0;
+	// only detached from the bound vertex array, other vertex arrays may still hold it
+	if (elementBuffer == buffer)
+		elementBuffer = 0;
+	if (pixelUnpackBuffer == buffer)
+		pixelUnpackBuffer = 0;
+}
+
+void GlState::deleteTexture(GLuint texture)
+{
+	glDeleteTextures(1, &texture);
+	for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++)
+	{
+		for (int slot = 0; slot < GL_STATE_TEXTURE_TARGETS; slot++)
+		{
+			if (textures[unit][slot] == texture)
+				textures[unit][slot] = 0;
+		}
+	}
+}
+
+void GlState::deleteFramebuffer(GLuint framebuffer)
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	if (readFramebuffer == framebuffer)
+		readFramebuffer = 0;
+	if (drawFramebuffer == framebuffer)
+		drawFramebuffer = 0;
+}
+
+void GlState::setDepthTest(bool enabled)
+{
+	setCapability(GL_DEPTH_TEST, depthTest, enabled);
+}
+
+void GlState::setDepthMask(bool write)
+{
+	if (depthMask == (int)write)
+		return;
+	glDepthMask(write ? GL_TRUE : GL_FALSE);
+	depthMask = write;
+}
+
+void GlState::setDepthFunc(GLenum func)
+{
+	if (depthFunc == func)
+		return;
+	glDepthFunc(func);
+	depthFunc = func;
+}
+
+void GlState::setBlend(bool enabled)
+{
+	setCapability(GL_BLEND, blend, enabled);
+}
+
+void GlState::setBlendFunc(GLenum source, GLenum destination)
+{
+	if (blendSource == source && blendDestination == destination)
+		return;
+	glBlendFunc(source, destination);
+	blendSource = source;
+	blendDestination = destination;
+}
+
+void GlState::setCullFace(bool enabled)
+{
+	setCapability(GL_CULL_FACE, cullFace, enabled);
+}
+
+void GlState::setCullMode(GLenum mode)
+{
+	if (cullMode == mode)
+		return;
+	glCullFace(mode);
+	cullMode = mode;
+}
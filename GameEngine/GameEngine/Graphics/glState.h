@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glew.h>
+
+// texture units whose bindings are shadowed; binds on higher units always reach GL
+#define GL_STATE_TEXTURE_UNITS 16
+// 2D, 2D array, cube map and buffer textures are shadowed per unit
+#define GL_STATE_TEXTURE_TARGETS 4
+// unit the loaders bind to while they fill a texture
+#define GL_STATE_UPLOAD_UNIT 0
+
+// Shadow copy of the GL state the engine touches. Every bind and state change goes through
+// here and is only passed on to GL when it changes something, so nothing has to be put back
+// to 0 after a draw. All shadows start unknown, so the first call of each always reaches GL.
+// Code that changes this state behind the cache's back (the ImGui backend restores whatever
+// it changes) must either restore it or call invalidate().
+class GlState
+{
+	private:
+		// -1 is "unknown", anything else is the name or value last passed to GL
+		long long program;
+		long long vertexArray;
+		long long arrayBuffer;
+		// part of the vertex array's state, unknown again after every vertex array change
+		long long elementBuffer;
+		long long pixelUnpackBuffer;
+		long long readFramebuffer;
+		long long drawFramebuffer;
+		long long activeUnit;
+		long long textures[GL_STATE_TEXTURE_UNITS][GL_STATE_TEXTURE_TARGETS];
+
+		int depthTest;
+		int depthMask;
+		long long depthFunc;
+		int blend;
+		long long blendSource;
+		long long blendDestination;
+		int cullFace;
+		long long cullMode;
+
+		static int textureSlot(GLenum target);
+		void setCapability(GLenum capability, int& shadow, bool enabled);
+
+	public:
+		GlState();
+
+		void invalidate();
+
+		void useProgram(GLuint program);
+		void bindVertexArray(GLuint array);
+		void bindBuffer(GLenum target, GLuint buffer);
+		// GL_FRAMEBUFFER, both draw and read
+		void bindFramebuffer(GLuint framebuffer);
+		// one side only, for blits between two framebuffers
+		void bindReadFramebuffer(GLuint framebuffer);
+		void bindDrawFramebuffer(GLuint framebuffer);
+		void activeTexture(unsigned int unit);
+		void bindTexture(unsigned int unit, GLenum target, GLuint texture);
+
+		// a deleted object that is still bound reverts to 0, and GL may hand its name out again
+		void deleteVertexArray(GLuint array);
+		void deleteBuffer(GLuint buffer);
+		void deleteTexture(GLuint texture);
+		void deleteFramebuffer(GLuint framebuffer);
+
+		void setDepthTest(bool enabled);
+		void setDepthMask(bool write);
+		void setDepthFunc(GLenum func);
+		void setBlend(bool enabled);
+		void setBlendFunc(GLenum source, GLenum destination);
+		void setCullFace(bool enabled);
+		void setCullMode(GLenum mode);
+};
+
+extern GlState glState;
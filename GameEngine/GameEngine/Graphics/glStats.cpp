@@ -0,0 +1,333 @@
+#define GL_STATS_IMPLEMENTATION
+#include "glStats.h"
+#include <cstring>
+
+GlStats glStats;
+
+static const char* callNames[GL_STAT_CALL_COUNT] = {
+	"glDrawElements", "glDrawArrays", "glBindTexture", "glActiveTexture", "glBindVertexArray", "glBindBuffer",
+	"glUseProgram", "glUniform*", "glGetUniformLocation", "buffer uploads", "texture uploads"
+};
+
+bool glStatsCompiledIn()
+{
+#ifdef GL_STATS_ENABLED
+	return true;
+#else
+	return false;
+#endif
+}
+
+const char* glStatCallName(GlStatCall call)
+{
+	return call < GL_STAT_CALL_COUNT ? callNames[call] : "?";
+}
+
+GlStats::GlStats()
+{
+	memset(&this->current, 0, sizeof(GlFrameStats));
+	memset(&this->last, 0, sizeof(GlFrameStats));
+	memset(&this->totals, 0, sizeof(GlFrameStats));
+	this->totalFrames = 0;
+
+	this->vertexArray = -1;
+	this->program = -1;
+	this->arrayBuffer = -1;
+	this->elementBuffer = -1;
+	this->pixelUnpackBuffer = -1;
+	this->activeUnit = 0;
+	for (int unit = 0; unit < GL_STATS_TEXTURE_UNITS; unit++)
+	{
+		for (int slot = 0; slot < 3; slot++)
+			this->textures[unit][slot] = -1;
+	}
+}
+
+int GlStats::textureSlot(GLenum target)
+{
+	if (target == GL_TEXTURE_2D)
+		return 0;
+	if (target == GL_TEXTURE_2D_ARRAY)
+		return 1;
+	if (target == GL_TEXTURE_CUBE_MAP)
+		return 2;
+	return -1;
+}
+
+void GlStats::beginFrame()
+{
+	std::lock_guard<std::mutex> lock(totalsMutex);
+	for (int i = 0; i < GL_STAT_CALL_COUNT; i++)
+	{
+		totals.calls[i] += current.calls[i];
+		totals.redundant[i] += current.redundant[i];
+	}
+	totals.bytesUploaded += current.bytesUploaded;
+	totalFrames++;
+
+	last = current;
+	memset(&current, 0, sizeof(GlFrameStats));
+}
+
+void GlStats::resetTotals()
+{
+	std::lock_guard<std::mutex> lock(totalsMutex);
+	memset(&totals, 0, sizeof(GlFrameStats));
+	totalFrames = 0;
+}
+
+const GlFrameStats& GlStats::getTotals()
+{
+	return totals;
+}
+
+unsigned int GlStats::getTotalFrames()
+{
+	return totalFrames;
+}
+
+const GlFrameStats& GlStats::getLastFrame()
+{
+	return last;
+}
+
+unsigned long long GlStats::getLastFrameCalls()
+{
+	unsigned long long calls = 0;
+	for (int i = 0; i < GL_STAT_CALL_COUNT; i++)
+		calls += last.calls[i];
+	return calls;
+}
+
+void GlStats::countCall(GlStatCall call)
+{
+	current.calls[call]++;
+}
+
+void GlStats::countUpload(GlStatCall call, unsigned long long bytes)
+{
+	current.calls[call]++;
+	current.bytesUploaded += bytes;
+}
+
+void GlStats::bindVertexArray(GLuint array)
+{
+	current.calls[GL_STAT_BIND_VERTEX_ARRAY]++;
+	if (vertexArray == array)
+		current.redundant[GL_STAT_BIND_VERTEX_ARRAY]++;
+	else
+		// the element buffer binding belongs to the vertex array
+		elementBuffer = -1;
+	vertexArray = array;
+}
+
+void GlStats::bindBuffer(GLenum target, GLuint buffer)
+{
+	current.calls[GL_STAT_BIND_BUFFER]++;
+
+	long long* bound = NULL;
+	if (target == GL_ARRAY_BUFFER)
+		bound = &arrayBuffer;
+	else if (target == GL_ELEMENT_ARRAY_BUFFER)
+		bound = &elementBuffer;
+	else if (target == GL_PIXEL_UNPACK_BUFFER)
+		bound = &pixelUnpackBuffer;
+	if (bound == NULL)
+		return;
+
+	if (*bound == buffer)
+		current.redundant[GL_STAT_BIND_BUFFER]++;
+	*bound = buffer;
+}
+
+void GlStats::useProgram(GLuint program)
+{
+	current.calls[GL_STAT_USE_PROGRAM]++;
+	if (this->program == program)
+		current.redundant[GL_STAT_USE_PROGRAM]++;
+	this->program = program;
+}
+
+void GlStats::activeTexture(GLenum unit)
+{
+	current.calls[GL_STAT_ACTIVE_TEXTURE]++;
+	if (activeUnit == unit - GL_TEXTURE0)
+		current.redundant[GL_STAT_ACTIVE_TEXTURE]++;
+	activeUnit = unit - GL_TEXTURE0;
+}
+
+void GlStats::bindTexture(GLenum target, GLuint texture)
+{
+	current.calls[GL_STAT_BIND_TEXTURE]++;
+
+	int slot = textureSlot(target);
+	if (slot < 0 || activeUnit >= GL_STATS_TEXTURE_UNITS)
+		return;
+	if (textures[activeUnit][slot] == texture)
+		current.redundant[GL_STAT_BIND_TEXTURE]++;
+	textures[activeUnit][slot] = texture;
+}
+
+bool GlStats::pixelUnpackBufferBound()
+{
+	return pixelUnpackBuffer > 0;
+}
+
+// bytes per pixel of an uncompressed upload
+static unsigned int pixelSize(GLenum format, GLenum type)
+{
+	unsigned int components = 4;
+	if (format == GL_RED || format == GL_DEPTH_COMPONENT)
+		components = 1;
+	else if (format == GL_RG)
+		components = 2;
+	else if (format == GL_RGB || format == GL_BGR)
+		components = 3;
+
+	if (type == GL_FLOAT || type == GL_UNSIGNED_INT || type == GL_INT)
+		return components * 4;
+	if (type == GL_HALF_FLOAT || type == GL_UNSIGNED_SHORT || type == GL_SHORT)
+		return components * 2;
+	if (type == GL_UNSIGNED_BYTE || type == GL_BYTE)
+		return components;
+	// packed formats (GL_UNSIGNED_INT_8_8_8_8_REV and friends) fit a pixel in one word
+	return 4;
+}
+
+// texture storage allocated without data is not an upload
+static unsigned long long uploadBytes(const void* pixels, unsigned long long bytes)
+{
+	return pixels != NULL || glStats.pixelUnpackBufferBound() ? bytes : 0;
+}
+
+void GLAPIENTRY glStatsDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	glStats.countCall(GL_STAT_DRAW_ELEMENTS);
+	glDrawElements(mode, count, type, indices);
+}
+
+void GLAPIENTRY glStatsDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	glStats.countCall(GL_STAT_DRAW_ARRAYS);
+	glDrawArrays(mode, first, count);
+}
+
+void GLAPIENTRY glStatsBindTexture(GLenum target, GLuint texture)
+{
+	glStats.bindTexture(target, texture);
+	glBindTexture(target, texture);
+}
+
+void GLAPIENTRY glStatsActiveTexture(GLenum texture)
+{
+	glStats.activeTexture(texture);
+	glActiveTexture(texture);
+}
+
+void GLAPIENTRY glStatsBindVertexArray(GLuint array)
+{
+	glStats.bindVertexArray(array);
+	glBindVertexArray(array);
+}
+
+void GLAPIENTRY glStatsBindBuffer(GLenum target, GLuint buffer)
+{
+	glStats.bindBuffer(target, buffer);
+	glBindBuffer(target, buffer);
+}
+
+void GLAPIENTRY glStatsUseProgram(GLuint program)
+{
+	glStats.useProgram(program);
+	glUseProgram(program);
+}
+
+void GLAPIENTRY glStatsUniform1i(GLint location, GLint v0)
+{
+	glStats.countCall(GL_STAT_UNIFORM);
+	glUniform1i(location, v0);
+}
+
+void GLAPIENTRY glStatsUniform1f(GLint location, GLfloat v0)
+{
+	glStats.countCall(GL_STAT_UNIFORM);
+	glUniform1f(location, v0);
+}
+
+void GLAPIENTRY glStatsUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+	glStats.countCall(GL_STAT_UNIFORM);
+	glUniform3f(location, v0, v1, v2);
+}
+
+void GLAPIENTRY glStatsUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	glStats.countCall(GL_STAT_UNIFORM);
+	glUniformMatrix4fv(location, count, transpose, value);
+}
+
+GLint GLAPIENTRY glStatsGetUniformLocation(GLuint program, const GLchar* name)
+{
+	glStats.countCall(GL_STAT_GET_UNIFORM_LOCATION);
+	return glGetUniformLocation(program, name);
+}
+
+void GLAPIENTRY glStatsBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+	glStats.countUpload(GL_STAT_BUFFER_UPLOAD, data != NULL ? size : 0);
+	glBufferData(target, size, data, usage);
+}
+
+void GLAPIENTRY glStatsBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	glStats.countUpload(GL_STAT_BUFFER_UPLOAD, size);
+	glBufferSubData(target, offset, size, data);
+}
+
+void GLAPIENTRY glStatsTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	glStats.countUpload(GL_STAT_TEXTURE_UPLOAD, uploadBytes(pixels, (unsigned long long)width * height * pixelSize(format, type)));
+	glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+}
+
+void GLAPIENTRY glStatsTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	glStats.countUpload(GL_STAT_TEXTURE_UPLOAD, uploadBytes(pixels, (unsigned long long)width * height * pixelSize(format, type)));
+	glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+}
+
+void GLAPIENTRY glStatsTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	glStats.countUpload(GL_STAT_TEXTURE_UPLOAD, uploadBytes(pixels, (unsigned long long)width * height * depth * pixelSize(format, type)));
+	glTexImage3D(target, level, internalformat, width, height, depth, border, format, type, pixels);
+}
+
+void GLAPIENTRY glStatsTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+{
+	glStats.countUpload(GL_STAT_TEXTURE_UPLOAD, uploadBytes(pixels, (unsigned long long)width * height * depth * pixelSize(format, type)));
+	glTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+}
+
+void GLAPIENTRY glStatsCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data)
+{
+	glStats.countUpload(GL_STAT_TEXTURE_UPLOAD, uploadBytes(data, imageSize));
+	glCompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);
+}
+
+void GLAPIENTRY glStatsCompressedTexImage3D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLsizei imageSize, const void* data)
+{
+	glStats.countUpload(GL_STAT_TEXTURE_UPLOAD, uploadBytes(data, imageSize));
+	glCompressedTexImage3D(target, level, internalformat, width, height, depth, border, imageSize, data);
+}
+
+void GLAPIENTRY glStatsCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data)
+{
+	glStats.countUpload(GL_STAT_TEXTURE_UPLOAD, uploadBytes(data, imageSize));
+	glCompressedTexSubImage2D(target, level, xoffset, yoffset, width, height, format, imageSize, data);
+}
+
+void GLAPIENTRY glStatsCompressedTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei imageSize, const void* data)
+{
+	glStats.countUpload(GL_STAT_TEXTURE_UPLOAD, uploadBytes(data, imageSize));
+	glCompressedTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, imageSize, data);
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <glew.h>
+#include <mutex>
+
+// Counts the GL calls the engine makes, the binds that re-bind what is already bound and the
+// bytes handed to GL, per frame. Engine sources include this header after glew.h and the
+// entry points below are redirected through counting wrappers. On in debug builds (define
+// ENGINE_GL_STATS to keep it in a release build); otherwise the calls go straight to GL and
+// every counter stays zero.
+#if defined(_DEBUG) || defined(ENGINE_GL_STATS)
+#define GL_STATS_ENABLED
+#endif
+
+// texture units whose bindings are tracked
+#define GL_STATS_TEXTURE_UNITS 16
+
+enum GlStatCall
+{
+	GL_STAT_DRAW_ELEMENTS,
+	GL_STAT_DRAW_ARRAYS,
+	GL_STAT_BIND_TEXTURE,
+	GL_STAT_ACTIVE_TEXTURE,
+	GL_STAT_BIND_VERTEX_ARRAY,
+	GL_STAT_BIND_BUFFER,
+	GL_STAT_USE_PROGRAM,
+	GL_STAT_UNIFORM,
+	GL_STAT_GET_UNIFORM_LOCATION,
+	GL_STAT_BUFFER_UPLOAD,
+	GL_STAT_TEXTURE_UPLOAD,
+	GL_STAT_CALL_COUNT
+};
+
+struct GlFrameStats
+{
+	unsigned long long calls[GL_STAT_CALL_COUNT];
+	// binds of the object that was already bound
+	unsigned long long redundant[GL_STAT_CALL_COUNT];
+	unsigned long long bytesUploaded;
+};
+
+class GlStats
+{
+	private:
+		GlFrameStats current;
+		GlFrameStats last;
+		// reset from the main thread while the render thread rolls frames over
+		GlFrameStats totals;
+		unsigned int totalFrames;
+		std::mutex totalsMutex;
+
+		// what the wrappers last bound; -1 until the first bind
+		long long vertexArray;
+		long long program;
+		long long arrayBuffer;
+		long long elementBuffer;
+		long long pixelUnpackBuffer;
+		unsigned int activeUnit;
+		long long textures[GL_STATS_TEXTURE_UNITS][3];
+
+		static int textureSlot(GLenum target);
+
+	public:
+		GlStats();
+
+		void beginFrame();
+
+		// summed over every complete frame since the last reset
+		void resetTotals();
+		const GlFrameStats& getTotals();
+		unsigned int getTotalFrames();
+
+		// the last complete frame
+		const GlFrameStats& getLastFrame();
+		unsigned long long getLastFrameCalls();
+
+		// called by the wrappers
+		void countCall(GlStatCall call);
+		void countUpload(GlStatCall call, unsigned long long bytes);
+		void bindVertexArray(GLuint array);
+		void bindBuffer(GLenum target, GLuint buffer);
+		void useProgram(GLuint program);
+		void activeTexture(GLenum unit);
+		void bindTexture(GLenum target, GLuint texture);
+		bool pixelUnpackBufferBound();
+};
+
+extern GlStats glStats;
+
+bool glStatsCompiledIn();
+const char* glStatCallName(GlStatCall call);
+
+void GLAPIENTRY glStatsDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+void GLAPIENTRY glStatsDrawArrays(GLenum mode, GLint first, GLsizei count);
+void GLAPIENTRY glStatsBindTexture(GLenum target, GLuint texture);
+void GLAPIENTRY glStatsActiveTexture(GLenum texture);
+void GLAPIENTRY glStatsBindVertexArray(GLuint array);
+void GLAPIENTRY glStatsBindBuffer(GLenum target, GLuint buffer);
+void GLAPIENTRY glStatsUseProgram(GLuint program);
+void GLAPIENTRY glStatsUniform1i(GLint location, GLint v0);
+void GLAPIENTRY glStatsUniform1f(GLint location, GLfloat v0);
+void GLAPIENTRY glStatsUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+void GLAPIENTRY glStatsUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+GLint GLAPIENTRY glStatsGetUniformLocation(GLuint program, const GLchar* name);
+void GLAPIENTRY glStatsBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+void GLAPIENTRY glStatsBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+void GLAPIENTRY glStatsTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+void GLAPIENTRY glStatsTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+void GLAPIENTRY glStatsTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels);
+void GLAPIENTRY glStatsTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels);
+void GLAPIENTRY glStatsCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data);
+void GLAPIENTRY glStatsCompressedTexImage3D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLsizei imageSize, const void* data);
+void GLAPIENTRY glStatsCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data);
+void GLAPIENTRY glStatsCompressedTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei imageSize, const void* data);
+
+// glStats.cpp defines GL_STATS_IMPLEMENTATION so the wrappers reach the real entry points
+#if defined(GL_STATS_ENABLED) && !defined(GL_STATS_IMPLEMENTATION)
+#undef glDrawElements
+#undef glDrawArrays
+#undef glBindTexture
+#undef glActiveTexture
+#undef glBindVertexArray
+#undef glBindBuffer
+#undef glUseProgram
+#undef glUniform1i
+#undef glUniform1f
+#undef glUniform3f
+#undef glUniformMatrix4fv
+#undef glGetUniformLocation
+#undef glBufferData
+#undef glBufferSubData
+#undef glTexImage2D
+#undef glTexSubImage2D
+#undef glTexImage3D
+#undef glTexSubImage3D
+#undef glCompressedTexImage2D
+#undef glCompressedTexImage3D
+#undef glCompressedTexSubImage2D
+#undef glCompressedTexSubImage3D
+#define glDrawElements glStatsDrawElements
+#define glDrawArrays glStatsDrawArrays
+#define glBindTexture glStatsBindTexture
+#define glActiveTexture glStatsActiveTexture
+#define glBindVertexArray glStatsBindVertexArray
+#define glBindBuffer glStatsBindBuffer
+#define glUseProgram glStatsUseProgram
+#define glUniform1i glStatsUniform1i
+#define glUniform1f glStatsUniform1f
+#define glUniform3f glStatsUniform3f
+#define glUniformMatrix4fv glStatsUniformMatrix4fv
+#define glGetUniformLocation glStatsGetUniformLocation
+#define glBufferData glStatsBufferData
+#define glBufferSubData glStatsBufferSubData
+#define glTexImage2D glStatsTexImage2D
+#define glTexSubImage2D glStatsTexSubImage2D
+#define glTexImage3D glStatsTexImage3D
+#define glTexSubImage3D glStatsTexSubImage3D
+#define glCompressedTexImage2D glStatsCompressedTexImage2D
+#define glCompressedTexImage3D glStatsCompressedTexImage3D
+#define glCompressedTexSubImage2D glStatsCompressedTexSubImage2D
+#define glCompressedTexSubImage3D glStatsCompressedTexSubImage3D
+#endif
@@ -0,0 +1,359 @@
+#include "renderThread.h"
+#include "glState.h"
+#include "glStats.h"
+#include "..\Profiling\profiler.h"
+#include "..\Memory\allocationTracker.h"
+#include "..\imgui\imgui.h"
+#include "..\imgui\backends\imgui_impl_opengl3.h"
+#include <chrono>
+#include <cstring>
+
+RenderThread renderThread;
+
+static const GLenum textureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP };
+
+static float millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	return (float)std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// resize keeps the capacity, unlike ImVector's assignment, which frees and allocates again
+template <typename T>
+static void copyImVector(ImVector<T>& to, const ImVector<T>& from)
+{
+	to.resize(from.Size);
+	if (from.Size > 0)
+		memcpy(to.Data, from.Data, from.size_in_bytes());
+}
+
+RenderThread::RenderThread()
+{
+	this->window = NULL;
+	this->running = false;
+	this->enabled = true;
+	this->recording = 0;
+	this->pending = NULL;
+	this->stopping = false;
+	this->replayMs = 0.0f;
+	this->syncMs = 0.0f;
+	this->historyCount = 0;
+	this->historyNext = 0;
+
+	for (int i = 0; i < 2; i++)
+		imguiFrames[i].drawData = NULL;
+	for (int i = 0; i < RENDER_THREAD_HISTORY; i++)
+	{
+		replayHistory[i] = 0.0f;
+		syncHistory[i] = 0.0f;
+	}
+}
+
+void RenderThread::init(GLFWwindow* window)
+{
+	this->window = window;
+}
+
+void RenderThread::shutdown()
+{
+	stop();
+
+	for (int i = 0; i < 2; i++)
+	{
+		for (unsigned int l = 0; l < imguiFrames[i].lists.size(); l++)
+			IM_DELETE(imguiFrames[i].lists[l]);
+		imguiFrames[i].lists.clear();
+		if (imguiFrames[i].drawData != NULL)
+			IM_DELETE(imguiFrames[i].drawData);
+		imguiFrames[i].drawData = NULL;
+	}
+}
+
+void RenderThread::start()
+{
+	if (running || window == NULL)
+		return;
+
+	glfwMakeContextCurrent(NULL);
+	stopping = false;
+	running = true;
+	thread = std::thread(&RenderThread::threadLoop, this);
+}
+
+void RenderThread::stop()
+{
+	if (!running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	signal.notify_all();
+	thread.join();
+	running = false;
+	glfwMakeContextCurrent(window);
+}
+
+bool RenderThread::isRunning()
+{
+	return running;
+}
+
+void RenderThread::setEnabled(bool enabled)
+{
+	this->enabled = enabled;
+}
+
+bool RenderThread::isEnabled()
+{
+	return enabled;
+}
+
+void RenderThread::threadLoop()
+{
+	ALLOCATION_SCOPE(ALLOC_TAG_RENDER);
+	glfwMakeContextCurrent(window);
+
+	while (true)
+	{
+		CommandBuffer* commands = NULL;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			signal.wait(lock, [this]() { return pending != NULL || stopping; });
+			// a frame submitted before stop() is still drawn
+			if (pending == NULL)
+				break;
+			commands = pending;
+		}
+
+		replay(*commands);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending = NULL;
+		}
+		signal.notify_all();
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
+
+void RenderThread::replay(CommandBuffer& commands)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	Shader* shader = NULL;
+	GLuint program = 0;
+	size_t offset = 0;
+	while (const RenderCommandHeader* header = commands.read(offset))
+	{
+		switch (header->type)
+		{
+			case RENDER_COMMAND_BEGIN_FRAME:
+				glStats.beginFrame();
+				profiler.beginGpuFrame(((const BeginFrameCommand*)header)->frame);
+				break;
+
+			case RENDER_COMMAND_CLEAR:
+			{
+				const ClearCommand* command = (const ClearCommand*)header;
+				glClear((command->color ? GL_COLOR_BUFFER_BIT : 0) | (command->depth ? GL_DEPTH_BUFFER_BIT : 0));
+				break;
+			}
+
+			case RENDER_COMMAND_USE_SHADER:
+				shader = ((const UseShaderCommand*)header)->shader;
+				shader->use();
+				program = shader->getId();
+				break;
+
+			case RENDER_COMMAND_USE_PROGRAM:
+				shader = NULL;
+				program = ((const UseProgramCommand*)header)->program;
+				glState.useProgram(program);
+				break;
+
+			case RENDER_COMMAND_DEPTH_FUNC:
+				glState.setDepthFunc(((const DepthFuncCommand*)header)->func == RENDER_DEPTH_LEQUAL ? GL_LEQUAL : GL_LESS);
+				break;
+
+			case RENDER_COMMAND_UNIFORM_MAT4:
+			{
+				const UniformMat4Command* command = (const UniformMat4Command*)header;
+				glUniformMatrix4fv(glGetUniformLocation(program, command->name), 1, GL_FALSE, command->value);
+				break;
+			}
+
+			case RENDER_COMMAND_UNIFORM_VEC3:
+			{
+				const UniformVec3Command* command = (const UniformVec3Command*)header;
+				glUniform3f(glGetUniformLocation(program, command->name), command->value[0], command->value[1], command->value[2]);
+				break;
+			}
+
+			case RENDER_COMMAND_BIND_TEXTURE:
+			{
+				const BindTextureCommand* command = (const BindTextureCommand*)header;
+				glState.bindTexture(command->unit, textureTargets[command->target], command->texture);
+				break;
+			}
+
+			case RENDER_COMMAND_DRAW_MESH:
+				if (shader != NULL)
+					((const DrawMeshCommand*)header)->mesh->draw(*shader);
+				break;
+
+			case RENDER_COMMAND_DRAW_ARRAYS:
+			{
+				const DrawArraysCommand* command = (const DrawArraysCommand*)header;
+				glState.bindVertexArray(command->vertexArray);
+				glDrawArrays(GL_TRIANGLES, command->first, command->count);
+				break;
+			}
+
+			case RENDER_COMMAND_BEGIN_GPU_SCOPE:
+				profiler.beginGpuScope(((const GpuScopeCommand*)header)->name);
+				break;
+
+			case RENDER_COMMAND_END_GPU_SCOPE:
+				profiler.endGpuScope();
+				break;
+
+			case RENDER_COMMAND_CALLBACK:
+			{
+				const CallbackCommand* command = (const CallbackCommand*)header;
+				command->function(command + 1);
+				break;
+			}
+
+			case RENDER_COMMAND_PRESENT:
+			{
+				const PresentCommand* command = (const PresentCommand*)header;
+				glViewport(0, 0, command->width, command->height);
+				glfwSwapBuffers(window);
+				break;
+			}
+		}
+	}
+
+	replayMs = millisecondsSince(start);
+}
+
+CommandBuffer& RenderThread::getCommands()
+{
+	return buffers[recording];
+}
+
+void RenderThread::recordImGui(ImDrawData* source)
+{
+	ImGuiFrame& frame = imguiFrames[recording];
+	if (frame.drawData == NULL)
+		frame.drawData = IM_NEW(ImDrawData)();
+	while (frame.lists.size() < (size_t)source->CmdListsCount)
+		frame.lists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+
+	// the copies keep their buffers from frame to frame, so this stops allocating once they grew
+	ImDrawData* copy = frame.drawData;
+	copy->Valid = source->Valid;
+	copy->CmdListsCount = source->CmdListsCount;
+	copy->TotalIdxCount = source->TotalIdxCount;
+	copy->TotalVtxCount = source->TotalVtxCount;
+	copy->DisplayPos = source->DisplayPos;
+	copy->DisplaySize = source->DisplaySize;
+	copy->FramebufferScale = source->FramebufferScale;
+	copy->OwnerViewport = source->OwnerViewport;
+	copy->CmdLists.resize(source->CmdListsCount);
+	for (int i = 0; i < source->CmdListsCount; i++)
+	{
+		ImDrawList* list = frame.lists[i];
+		copyImVector(list->CmdBuffer, source->CmdLists[i]->CmdBuffer);
+		copyImVector(list->IdxBuffer, source->CmdLists[i]->IdxBuffer);
+		copyImVector(list->VtxBuffer, source->CmdLists[i]->VtxBuffer);
+		list->Flags = source->CmdLists[i]->Flags;
+		copy->CmdLists[i] = list;
+	}
+
+	buffers[recording].call(drawImGui, &copy, sizeof(copy));
+}
+
+void RenderThread::drawImGui(const void* data)
+{
+	ImGui_ImplOpenGL3_RenderDrawData(*(ImDrawData* const*)data);
+}
+
+void RenderThread::sync()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	if (running)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		signal.wait(lock, [this]() { return pending == NULL; });
+	}
+	syncMs = millisecondsSince(start);
+
+	replayHistory[historyNext] = replayMs;
+	syncHistory[historyNext] = syncMs;
+	historyNext = (historyNext + 1) % RENDER_THREAD_HISTORY;
+	if (historyCount < RENDER_THREAD_HISTORY)
+		historyCount++;
+}
+
+void RenderThread::submit()
+{
+	CommandBuffer& commands = buffers[recording];
+	if (running)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			signal.wait(lock, [this]() { return pending == NULL; });
+			pending = &commands;
+		}
+		signal.notify_all();
+	}
+	else
+		replay(commands);
+
+	// the other buffer was replayed before this one was handed over
+	recording = 1 - recording;
+	buffers[recording].reset();
+}
+
+float RenderThread::getReplayMs()
+{
+	return replayMs;
+}
+
+float RenderThread::getSyncMs()
+{
+	return syncMs;
+}
+
+void RenderThread::drawOverlay()
+{
+	ImGui::Begin("Render thread");
+
+	bool threaded = enabled;
+	if (ImGui::Checkbox("Replay on the render thread", &threaded))
+		enabled = threaded;
+	if (enabled && !running)
+		ImGui::Text("Replaying on the main thread while the pacing mode needs the context");
+
+	float replaySum = 0.0f;
+	float syncSum = 0.0f;
+	for (int i = 0; i < historyCount; i++)
+	{
+		replaySum += replayHistory[i];
+		syncSum += syncHistory[i];
+	}
+	float count = historyCount > 0 ? (float)historyCount : 1.0f;
+	// the buffer recorded last frame, it is the one not being recorded into
+	CommandBuffer& last = buffers[1 - recording];
+	ImGui::Text("Last frame: %u packets, %.1f KB", last.getPacketCount(), last.getSize() / 1024.0);
+	ImGui::Text("Replay: %.3f ms avg, main thread waited %.3f ms avg", replaySum / count, syncSum / count);
+
+	ImGui::PlotLines("##replay", replayHistory, historyCount, historyCount < RENDER_THREAD_HISTORY ? 0 : historyNext, "replay (ms)", 0.0f,
+		2.0f * replaySum / count + 1.0f, ImVec2(ImGui::GetContentRegionAvail().x, 50.0f));
+	ImGui::PlotLines("##sync", syncHistory, historyCount, historyCount < RENDER_THREAD_HISTORY ? 0 : historyNext, "main thread wait (ms)", 0.0f,
+		2.0f * syncSum / count + 1.0f, ImVec2(ImGui::GetContentRegionAvail().x, 50.0f));
+	ImGui::End();
+}
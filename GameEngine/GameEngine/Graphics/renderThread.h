@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glew.h>
+#include <glfw3.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "commandBuffer.h"
+
+struct ImDrawData;
+struct ImDrawList;
+
+// frames kept for the overlay graph
+#define RENDER_THREAD_HISTORY 240
+
+// Replays recorded frames (commandBuffer.h) on a thread that owns the GL context, so the
+// main thread simulates and records frame N+1 while frame N goes through the driver. There
+// are two command buffers: the main thread records into one while the other is replayed.
+// Anything the replay writes (query results, GPU timings, the pacer's present times) must
+// only be read by the main thread after sync(), which waits for the frame in flight; the
+// main loop reads its overlays between sync() and submit() for that reason.
+// When the thread is not running, submit() replays on the calling thread, which then needs
+// the context; start() and stop() move the context over and back.
+class RenderThread
+{
+	private:
+		// a copy of ImGui's draw lists, which the next ImGui::NewFrame() rebuilds
+		struct ImGuiFrame
+		{
+			ImDrawData* drawData;
+			std::vector<ImDrawList*> lists;
+		};
+
+		GLFWwindow* window;
+		std::thread thread;
+		bool running;
+		bool enabled;
+
+		CommandBuffer buffers[2];
+		ImGuiFrame imguiFrames[2];
+		int recording;
+
+		std::mutex mutex;
+		std::condition_variable signal;
+		// submitted and not replayed yet, NULL when the thread is idle
+		CommandBuffer* pending;
+		bool stopping;
+
+		// written by the replay, read after sync()
+		float replayMs;
+		float syncMs;
+		float replayHistory[RENDER_THREAD_HISTORY];
+		float syncHistory[RENDER_THREAD_HISTORY];
+		int historyCount;
+		int historyNext;
+
+		void threadLoop();
+		void replay(CommandBuffer& commands);
+		static void drawImGui(const void* data);
+
+	public:
+		RenderThread();
+
+		// window is what PRESENT swaps; the thread is not started yet
+		void init(GLFWwindow* window);
+		// stops the thread and frees the ImGui copies, before ImGui goes away
+		void shutdown();
+
+		// the calling thread gives up the context, the render thread takes it
+		void start();
+		// waits for the frame in flight, then hands the context back to the calling thread
+		void stop();
+		bool isRunning();
+		// whether the main loop wants the thread; it stops it anyway while it needs the context
+		void setEnabled(bool enabled);
+		bool isEnabled();
+
+		// buffer the next frame is recorded into, empty at the start of every frame
+		CommandBuffer& getCommands();
+		// records ImGui's current draw data (after ImGui::Render()) into getCommands()
+		void recordImGui(ImDrawData* drawData);
+		// waits until the previous frame was replayed, which it usually has been
+		void sync();
+		// hands the recorded frame over and switches to the other buffer; replays right here
+		// when the thread is not running
+		void submit();
+
+		float getReplayMs();
+		float getSyncMs();
+
+		void drawOverlay();
+};
+
+extern RenderThread renderThread;
@@ -0,0 +1,197 @@
+#include "shadowMap.h"
+#include "glState.h"
+#include "glStats.h"
+#include <gtc\matrix_transform.hpp>
+#include <cmath>
+#include <iostream>
+
+ShadowMap shadowMap;
+
+ShadowMap::ShadowMap()
+{
+	this->staticFramebuffer = 0;
+	this->staticDepth = 0;
+	this->framebuffer = 0;
+	this->depth = 0;
+	this->depthShader = NULL;
+	this->lightPosition = glm::vec3(0.0f);
+	this->sceneMin = glm::vec3(0.0f);
+	this->sceneMax = glm::vec3(0.0f);
+	this->lightSpace = glm::mat4(1.0f);
+	this->staticValid = false;
+	this->staticPass = false;
+	this->staticDraws = 0;
+	this->dynamicDraws = 0;
+	this->staticRebuilds = 0;
+}
+
+GLuint ShadowMap::createDepthTarget(GLuint& texture)
+{
+	glGenTextures(1, &texture);
+	glState.bindTexture(GL_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+	// sampled with a depth comparison, linear filtering gives 2x2 PCF for free
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+	GLuint target = 0;
+	glGenFramebuffers(1, &target);
+	glState.bindFramebuffer(target);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Shadow map framebuffer is incomplete" << std::endl;
+	return target;
+}
+
+void ShadowMap::init()
+{
+	staticFramebuffer = createDepthTarget(staticDepth);
+	framebuffer = createDepthTarget(depth);
+	glState.bindFramebuffer(0);
+	depthShader = new Shader("Shaders/shadow_vertex_shader.glsl", "Shaders/shadow_fragment_shader.glsl");
+	staticValid = false;
+}
+
+void ShadowMap::shutdown()
+{
+	if (staticFramebuffer != 0)
+		glState.deleteFramebuffer(staticFramebuffer);
+	if (framebuffer != 0)
+		glState.deleteFramebuffer(framebuffer);
+	if (staticDepth != 0)
+		glState.deleteTexture(staticDepth);
+	if (depth != 0)
+		glState.deleteTexture(depth);
+	if (depthShader != NULL)
+	{
+		glDeleteProgram(depthShader->getId());
+		delete depthShader;
+	}
+
+	staticFramebuffer = 0;
+	framebuffer = 0;
+	staticDepth = 0;
+	depth = 0;
+	depthShader = NULL;
+}
+
+void ShadowMap::setLight(const glm::vec3& position, const glm::vec3& sceneMin, const glm::vec3& sceneMax)
+{
+	if (staticValid && position == lightPosition && sceneMin == this->sceneMin && sceneMax == this->sceneMax)
+		return;
+
+	lightPosition = position;
+	this->sceneMin = sceneMin;
+	this->sceneMax = sceneMax;
+
+	// looking from the sun at the middle of the scene, just wide and deep enough for its bounding sphere
+	glm::vec3 center = (sceneMin + sceneMax) * 0.5f;
+	float radius = glm::length(sceneMax - sceneMin) * 0.5f;
+	float distance = glm::length(center - position);
+	glm::vec3 direction = distance > 0.0f ? (center - position) / distance : glm::vec3(0.0f, -1.0f, 0.0f);
+	glm::vec3 up = fabsf(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+	// glm here takes degrees; a sun inside the sphere gets a wide view instead
+	float fov = distance > radius ? glm::degrees(2.0f * asinf(radius / distance)) : 120.0f;
+	float nearPlane = distance > radius ? distance - radius : 0.1f;
+	lightSpace = glm::perspective(fov, 1.0f, nearPlane, distance + radius) * glm::lookAt(position, position + direction, up);
+
+	staticValid = false;
+}
+
+void ShadowMap::invalidateStatic()
+{
+	staticValid = false;
+}
+
+bool ShadowMap::beginStaticPass()
+{
+	staticDraws = 0;
+	if (staticValid)
+		return false;
+
+	glState.bindFramebuffer(staticFramebuffer);
+	glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+	glState.setDepthTest(true);
+	glState.setDepthMask(true);
+	glState.setDepthFunc(GL_LESS);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	depthShader->use();
+	staticPass = true;
+	return true;
+}
+
+void ShadowMap::endStaticPass()
+{
+	staticPass = false;
+	staticValid = true;
+	staticRebuilds++;
+}
+
+void ShadowMap::beginDynamicPass()
+{
+	dynamicDraws = 0;
+
+	// the cached static depth is the starting point every frame
+	glState.bindReadFramebuffer(staticFramebuffer);
+	glState.bindDrawFramebuffer(framebuffer);
+	glBlitFramebuffer(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	glState.bindFramebuffer(framebuffer);
+	glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+	glState.setDepthTest(true);
+	glState.setDepthMask(true);
+	glState.setDepthFunc(GL_LESS);
+	depthShader->use();
+}
+
+void ShadowMap::endDynamicPass(int windowWidth, int windowHeight)
+{
+	glState.bindFramebuffer(0);
+	glViewport(0, 0, windowWidth, windowHeight);
+}
+
+void ShadowMap::drawCaster(Mesh& mesh, const glm::mat4& model)
+{
+	glm::mat4 lightSpaceModel = lightSpace * model;
+	glUniformMatrix4fv(glGetUniformLocation(depthShader->getId(), "lightSpaceModel"), 1, GL_FALSE, &lightSpaceModel[0][0]);
+	mesh.draw(*depthShader);
+
+	if (staticPass)
+		staticDraws++;
+	else
+		dynamicDraws++;
+}
+
+void ShadowMap::bind(GLuint program)
+{
+	glState.bindTexture(SHADOW_MAP_UNIT, GL_TEXTURE_2D, depth);
+	glUniform1i(glGetUniformLocation(program, "shadowMap"), SHADOW_MAP_UNIT);
+	glUniformMatrix4fv(glGetUniformLocation(program, "lightSpace"), 1, GL_FALSE, &lightSpace[0][0]);
+}
+
+const glm::mat4& ShadowMap::getLightSpace()
+{
+	return lightSpace;
+}
+
+unsigned int ShadowMap::getStaticDraws()
+{
+	return staticDraws;
+}
+
+unsigned int ShadowMap::getDynamicDraws()
+{
+	return dynamicDraws;
+}
+
+unsigned int ShadowMap::getStaticRebuilds()
+{
+	return staticRebuilds;
+}
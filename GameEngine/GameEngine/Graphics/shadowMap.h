@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glew.h>
+#include <glm.hpp>
+#include "..\Shaders\shader.h"
+#include "..\Model Loading\mesh.h"
+
+#define SHADOW_MAP_SIZE 2048
+// sampled from this unit, after the clustered lighting buffers
+#define SHADOW_MAP_UNIT 7
+
+// Shadow map for the sun. Static casters (the batched labyrinth) are drawn once into a cached
+// depth map that is only drawn again after invalidateStatic() or when the sun or the scene
+// bounds move. Every frame the cached depth is blitted into the map the shader samples and the
+// dynamic casters (the player) are drawn on top of it, so in steady state the static geometry
+// costs one copy and no draws.
+// The sun is a point light, so the map is a perspective view from it fitted around the
+// bounding sphere of the scene.
+class ShadowMap
+{
+	private:
+		GLuint staticFramebuffer;
+		GLuint staticDepth;
+		GLuint framebuffer;
+		GLuint depth;
+		Shader* depthShader;
+
+		glm::vec3 lightPosition;
+		glm::vec3 sceneMin;
+		glm::vec3 sceneMax;
+		glm::mat4 lightSpace;
+		bool staticValid;
+
+		bool staticPass;
+		unsigned int staticDraws;
+		unsigned int dynamicDraws;
+		unsigned int staticRebuilds;
+
+		GLuint createDepthTarget(GLuint& texture);
+
+	public:
+		ShadowMap();
+
+		void init();
+		void shutdown();
+
+		// the cached map is only thrown away when one of these actually changed
+		void setLight(const glm::vec3& position, const glm::vec3& sceneMin, const glm::vec3& sceneMax);
+		// static casters were added, moved or removed
+		void invalidateStatic();
+
+		// true when the cached map has to be drawn again: draw every static caster with
+		// drawCaster(), then call endStaticPass(). False means there is nothing to draw
+		bool beginStaticPass();
+		void endStaticPass();
+		// copies the cached map into the sampled one; draw the dynamic casters, then call
+		// endDynamicPass(), which goes back to the default framebuffer at window size
+		void beginDynamicPass();
+		void endDynamicPass(int windowWidth, int windowHeight);
+		void drawCaster(Mesh& mesh, const glm::mat4& model);
+
+		// points program (already in use) at the map and the light's matrix
+		void bind(GLuint program);
+
+		const glm::mat4& getLightSpace();
+		// draws of the last static and dynamic passes; static is 0 while the cache holds
+		unsigned int getStaticDraws();
+		unsigned int getDynamicDraws();
+		unsigned int getStaticRebuilds();
+};
+
+extern ShadowMap shadowMap;
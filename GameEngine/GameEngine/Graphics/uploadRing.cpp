@@ -0,0 +1,168 @@
+#include "uploadRing.h"
+#include "glState.h"
+#include "glStats.h"
+#include <chrono>
+#include <iostream>
+
+// a wait this long means the fence was lost rather than the GPU being busy
+#define UPLOAD_RING_TIMEOUT_NS 1000000000ULL
+
+UploadRing uploadRing;
+
+UploadRing::UploadRing()
+{
+	this->buffer = 0;
+	this->mapped = NULL;
+	this->next = 0;
+	this->uploads = 0;
+	this->stalls = 0;
+	this->stallMs = 0.0;
+
+	for (int i = 0; i < UPLOAD_RING_SLOTS; i++)
+	{
+		slots[i].fence = 0;
+		slots[i].acquired = false;
+	}
+}
+
+UploadRing::~UploadRing()
+{
+}
+
+void UploadRing::init()
+{
+	if (!GLEW_VERSION_4_4 && !GLEW_ARB_buffer_storage)
+	{
+		std::cout << "Persistent buffer mapping not supported, textures upload from client memory" << std::endl;
+		return;
+	}
+
+	GLsizeiptr size = (GLsizeiptr)UPLOAD_RING_SLOTS * UPLOAD_RING_SLOT_SIZE;
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &buffer);
+	glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, flags);
+	mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+	glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (mapped == NULL)
+	{
+		std::cout << "Could not map the texture upload ring, textures upload from client memory" << std::endl;
+		glState.deleteBuffer(buffer);
+		buffer = 0;
+	}
+}
+
+void UploadRing::shutdown()
+{
+	for (int i = 0; i < UPLOAD_RING_SLOTS; i++)
+	{
+		if (slots[i].fence != 0)
+			glDeleteSync(slots[i].fence);
+		slots[i].fence = 0;
+		slots[i].acquired = false;
+	}
+
+	if (buffer != 0)
+	{
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glState.deleteBuffer(buffer);
+	}
+	buffer = 0;
+	mapped = NULL;
+}
+
+bool UploadRing::isReady()
+{
+	return mapped != NULL;
+}
+
+void UploadRing::waitForSlot(Slot& slot)
+{
+	if (slot.fence == 0)
+		return;
+
+	// poll first; only a real wait counts as a stall, and it flushes so the fence reaches the GPU
+	GLenum result = glClientWaitSync(slot.fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, UPLOAD_RING_TIMEOUT_NS);
+		stallMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		stalls++;
+
+		if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+			std::cout << "Texture upload ring: fence wait failed, reusing the slot anyway" << std::endl;
+	}
+
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+}
+
+UploadSlot UploadRing::acquire(size_t size)
+{
+	UploadSlot result = { NULL, 0, 0, -1 };
+	if (mapped == NULL || size > UPLOAD_RING_SLOT_SIZE)
+		return result;
+
+	// oldest slot first; ones still being filled are skipped
+	for (int i = 0; i < UPLOAD_RING_SLOTS; i++)
+	{
+		int index = (next + i) % UPLOAD_RING_SLOTS;
+		if (slots[index].acquired)
+			continue;
+
+		waitForSlot(slots[index]);
+		slots[index].acquired = true;
+		next = (index + 1) % UPLOAD_RING_SLOTS;
+		uploads++;
+
+		result.offset = (size_t)index * UPLOAD_RING_SLOT_SIZE;
+		result.data = mapped + result.offset;
+		result.size = size;
+		result.index = index;
+		return result;
+	}
+
+	return result;
+}
+
+void UploadRing::release(const UploadSlot& slot)
+{
+	if (slot.index < 0)
+		return;
+
+	Slot& entry = slots[slot.index];
+	if (entry.fence != 0)
+		glDeleteSync(entry.fence);
+	entry.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	entry.acquired = false;
+}
+
+void UploadRing::bind()
+{
+	glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+}
+
+// not cleanup: with the ring still bound, client memory pointers would be read as ring offsets
+void UploadRing::unbind()
+{
+	glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+unsigned int UploadRing::getUploadCount()
+{
+	return uploads;
+}
+
+unsigned int UploadRing::getStallCount()
+{
+	return stalls;
+}
+
+double UploadRing::getStallMs()
+{
+	return stallMs;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <glew.h>
+#include <vector>
+
+// slots are sized for one 1024x1024 RGB skybox face or BMP with room to spare, and there are
+// enough of them for a whole cubemap to be in flight at once
+#define UPLOAD_RING_SLOTS 8
+#define UPLOAD_RING_SLOT_SIZE (6 * 1024 * 1024)
+
+// one reserved region of the ring; data is written by the CPU (from any thread), offset is
+// what the GL calls read from while the ring is bound to GL_PIXEL_UNPACK_BUFFER
+struct UploadSlot
+{
+	unsigned char* data;
+	size_t offset;
+	size_t size;
+	int index;
+};
+
+// Persistently mapped pixel unpack buffer split into fixed-size slots. A slot is handed out by
+// acquire(), filled by the CPU, read by glTex(Sub)Image calls issued between bind() and
+// unbind(), and returned with release(), which fences it. acquire() only blocks when the GPU
+// has not finished reading the slot it is about to reuse.
+// Needs GL 4.4 or ARB_buffer_storage; without them isReady() is false and callers upload from
+// client memory instead.
+class UploadRing
+{
+	private:
+		struct Slot
+		{
+			GLsync fence;
+			bool acquired;
+		};
+
+		GLuint buffer;
+		unsigned char* mapped;
+		Slot slots[UPLOAD_RING_SLOTS];
+		int next;
+
+		unsigned int uploads;
+		unsigned int stalls;
+		double stallMs;
+
+		void waitForSlot(Slot& slot);
+
+	public:
+		UploadRing();
+		~UploadRing();
+
+		// the buffer needs a current context, so it is created separately
+		void init();
+		void shutdown();
+		bool isReady();
+
+		// main thread only; index is -1 when the request is larger than a slot or every slot
+		// is still acquired
+		UploadSlot acquire(size_t size);
+		void release(const UploadSlot& slot);
+
+		void bind();
+		void unbind();
+
+		// slots handed out and how often acquire() had to wait on the GPU
+		unsigned int getUploadCount();
+		unsigned int getStallCount();
+		double getStallMs();
+};
+
+extern UploadRing uploadRing;
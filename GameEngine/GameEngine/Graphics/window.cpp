@@ -44,6 +44,8 @@ void Window::init()
 	}
 
 	glfwMakeContextCurrent(window);
+	// the driver default varies, the frame pacer changes it later as its mode asks
+	glfwSwapInterval(1);
 
 	//callbacks for user input
 	//glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -64,9 +66,17 @@ void Window::init()
 	std::cout << "Open GL " << glGetString(GL_VERSION) << std::endl;
 }
 
-void Window::update()
+// input is polled at the start of a frame, after any frame pacing wait, so it is as fresh as it
+// can be when the simulation reads it
+void Window::pollEvents()
 {
 	glfwPollEvents();
+	// the swap may happen on the render thread, the size is kept up to date from here
+	glfwGetFramebufferSize(window, &width, &height);
+}
+
+void Window::update()
+{
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 	glfwSwapBuffers(window);
@@ -77,6 +87,12 @@ void Window::clear()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+// 0 = vsync off, 1 = wait for one vertical blank per swap
+void Window::setSwapInterval(int interval)
+{
+	glfwSwapInterval(interval);
+}
+
 GLFWwindow* Window::getWindow()
 {
 	return window;
@@ -126,6 +142,25 @@ bool Window::isMousePressed(int button)
 	return mouseButtons[button];
 }
 
+InputQueue& Window::getInputQueue()
+{
+	return inputQueue;
+}
+
+static void queueInput(GLFWwindow* window, InputEventType type, int code, int action, double x, double y)
+{
+	Window* wind = (Window*)glfwGetWindowUserPointer(window);
+
+	InputEvent event;
+	event.time = glfwGetTime();
+	event.type = type;
+	event.code = code;
+	event.action = action;
+	event.x = x;
+	event.y = y;
+	wind->getInputQueue().push(event);
+}
+
 //Handling keyboard actions
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
@@ -135,6 +170,8 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		wind->setKey(key, true);
 	else
 		wind->setKey(key, false);
+
+	queueInput(window, INPUT_KEY, key, action, 0.0, 0.0);
 }
 
 //Handling mouse actions
@@ -146,6 +183,8 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 		wind->setMouseButton(button, true);
 	else
 		wind->setMouseButton(button, false);
+
+	queueInput(window, INPUT_MOUSE_BUTTON, button, action, 0.0, 0.0);
 }
 
 //Handling cursor position
@@ -153,4 +192,6 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
 {
 	Window* wind = (Window*)glfwGetWindowUserPointer(window);
 	wind->setMousePos(xpos, ypos);
+
+	queueInput(window, INPUT_CURSOR, 0, 0, xpos, ypos);
 }
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <glew.h>
 #include <glfw3.h>
+#include "..\Input\inputQueue.h"
 
 #pragma once
 
@@ -22,6 +23,9 @@ class Window
 		bool mouseButtons[MAX_MOUSE];
 		double xpos;
 		double ypos;
+
+		// every callback also queues a timestamped event for the simulation
+		InputQueue inputQueue;
 	
 	public:
 		Window(char* name, int width, int height);
@@ -29,8 +33,10 @@ class Window
 		GLFWwindow* getWindow();
 
 		void init();
+		void pollEvents();
 		void update();
 		void clear();
+		void setSwapInterval(int interval);
 
 		void setKey(int key, bool ok);
 		void setMouseButton(int button, bool ok);
@@ -38,6 +44,7 @@ class Window
 		void getMousePos(double &xpos, double &ypos);
 		bool isPressed(int key);
 		bool isMousePressed(int button);
+		InputQueue& getInputQueue();
 
 		int getWidth();
 		int getHeight();
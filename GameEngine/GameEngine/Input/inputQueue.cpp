@@ -0,0 +1,157 @@
+#include "inputQueue.h"
+#include <glfw3.h>
+
+InputQueue::InputQueue()
+{
+	this->head = 0;
+	this->tail = 0;
+	this->dropped = 0;
+}
+
+bool InputQueue::push(const InputEvent& event)
+{
+	unsigned int t = tail.load(std::memory_order_relaxed);
+	if (t - head.load(std::memory_order_acquire) >= INPUT_QUEUE_CAPACITY)
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	events[t & (INPUT_QUEUE_CAPACITY - 1)] = event;
+	// publishes the event written above
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputQueue::peek(InputEvent& event)
+{
+	unsigned int h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire))
+		return false;
+
+	event = events[h & (INPUT_QUEUE_CAPACITY - 1)];
+	return true;
+}
+
+bool InputQueue::pop(InputEvent& event)
+{
+	if (!peek(event))
+		return false;
+
+	// hands the slot back to the producer
+	head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	return true;
+}
+
+unsigned int InputQueue::size()
+{
+	return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+}
+
+unsigned int InputQueue::getDroppedCount()
+{
+	return dropped.load(std::memory_order_relaxed);
+}
+
+InputState::InputState()
+{
+	for (int i = 0; i < INPUT_MAX_KEYS; i++)
+	{
+		this->keys[i] = false;
+		this->pressedKeys[i] = false;
+	}
+	for (int i = 0; i < INPUT_MAX_BUTTONS; i++)
+	{
+		this->buttons[i] = false;
+		this->pressedButtons[i] = false;
+	}
+	this->cursorX = 0.0;
+	this->cursorY = 0.0;
+	this->events = 0;
+	this->latencySum = 0.0;
+	this->lastLatency = 0.0;
+}
+
+void InputState::apply(const InputEvent& event)
+{
+	bool down = event.action != GLFW_RELEASE;
+
+	if (event.type == INPUT_KEY && event.code >= 0 && event.code < INPUT_MAX_KEYS)
+	{
+		keys[event.code] = down;
+		if (event.action == GLFW_PRESS)
+			pressedKeys[event.code] = true;
+	}
+	else if (event.type == INPUT_MOUSE_BUTTON && event.code >= 0 && event.code < INPUT_MAX_BUTTONS)
+	{
+		buttons[event.code] = down;
+		if (event.action == GLFW_PRESS)
+			pressedButtons[event.code] = true;
+	}
+	else if (event.type == INPUT_CURSOR)
+	{
+		cursorX = event.x;
+		cursorY = event.y;
+	}
+}
+
+unsigned int InputState::consume(InputQueue& queue, double stepEnd, double now)
+{
+	unsigned int applied = 0;
+	InputEvent event;
+	while (queue.peek(event) && event.time < stepEnd)
+	{
+		queue.pop(event);
+		apply(event);
+
+		lastLatency = now - event.time;
+		latencySum += lastLatency;
+		events++;
+		applied++;
+	}
+	return applied;
+}
+
+void InputState::endStep()
+{
+	for (int i = 0; i < INPUT_MAX_KEYS; i++)
+		pressedKeys[i] = false;
+	for (int i = 0; i < INPUT_MAX_BUTTONS; i++)
+		pressedButtons[i] = false;
+}
+
+bool InputState::isDown(int key)
+{
+	return key >= 0 && key < INPUT_MAX_KEYS && (keys[key] || pressedKeys[key]);
+}
+
+bool InputState::wasPressed(int key)
+{
+	return key >= 0 && key < INPUT_MAX_KEYS && pressedKeys[key];
+}
+
+bool InputState::isMouseDown(int button)
+{
+	return button >= 0 && button < INPUT_MAX_BUTTONS && (buttons[button] || pressedButtons[button]);
+}
+
+void InputState::getCursor(double& x, double& y)
+{
+	x = cursorX;
+	y = cursorY;
+}
+
+double InputState::getAverageLatencyMs()
+{
+	return events > 0 ? latencySum / events * 1000.0 : 0.0;
+}
+
+double InputState::getLastLatencyMs()
+{
+	return lastLatency * 1000.0;
+}
+
+unsigned int InputState::getEventCount()
+{
+	return events;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+
+// power of two; a frame of very fast mouse movement is a few dozen events
+#define INPUT_QUEUE_CAPACITY 1024
+// matches the Window key and button arrays
+#define INPUT_MAX_KEYS 512
+#define INPUT_MAX_BUTTONS 8
+
+enum InputEventType
+{
+	INPUT_KEY,
+	INPUT_MOUSE_BUTTON,
+	INPUT_CURSOR
+};
+
+// time is glfwGetTime() when GLFW delivered the event; code is the key or button, action
+// GLFW_PRESS, GLFW_REPEAT or GLFW_RELEASE; x and y are only set for INPUT_CURSOR
+struct InputEvent
+{
+	double time;
+	InputEventType type;
+	int code;
+	int action;
+	double x;
+	double y;
+};
+
+// Lock-free single producer, single consumer ring of input events. The GLFW callbacks are the
+// producer and the simulation the consumer; either side can move to its own thread without
+// changing anything. When the ring is full new events are dropped and counted.
+class InputQueue
+{
+	private:
+		InputEvent events[INPUT_QUEUE_CAPACITY];
+		// head is only written by the consumer, tail only by the producer
+		std::atomic<unsigned int> head;
+		std::atomic<unsigned int> tail;
+		std::atomic<unsigned int> dropped;
+
+	public:
+		InputQueue();
+
+		// producer side
+		bool push(const InputEvent& event);
+
+		// consumer side; peek leaves the event in the queue
+		bool peek(InputEvent& event);
+		bool pop(InputEvent& event);
+		unsigned int size();
+
+		unsigned int getDroppedCount();
+};
+
+// Key and button state as the simulation sees it, rebuilt one fixed step at a time from the
+// queue. A press that is released again within the same step still reads as down for that
+// step, so no press is shorter than a step.
+class InputState
+{
+	private:
+		bool keys[INPUT_MAX_KEYS];
+		bool buttons[INPUT_MAX_BUTTONS];
+		// pressed at some point during the current step
+		bool pressedKeys[INPUT_MAX_KEYS];
+		bool pressedButtons[INPUT_MAX_BUTTONS];
+		double cursorX;
+		double cursorY;
+
+		unsigned int events;
+		double latencySum;
+		double lastLatency;
+
+		void apply(const InputEvent& event);
+
+	public:
+		InputState();
+
+		// applies every queued event stamped before stepEnd; now is the time the step runs at,
+		// for the latency figures. Returns how many events were applied
+		unsigned int consume(InputQueue& queue, double stepEnd, double now);
+		// clears the per-step press latches, call after the step has run
+		void endStep();
+
+		bool isDown(int key);
+		bool wasPressed(int key);
+		bool isMouseDown(int button);
+		void getCursor(double& x, double& y);
+
+		// time from GLFW delivering an event to the step that applied it running
+		double getAverageLatencyMs();
+		double getLastLatencyMs();
+		unsigned int getEventCount();
+};
@@ -0,0 +1,302 @@
+#include "level.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static size_t alignLevelOffset(size_t offset)
+{
+	return (offset + LEVEL_FILE_ALIGNMENT - 1) & ~(size_t)(LEVEL_FILE_ALIGNMENT - 1);
+}
+
+bool compileLevel(const char* sourcePath, const char* binaryPath)
+{
+	std::ifstream source(sourcePath);
+	if (!source.is_open())
+	{
+		std::cout << "Could not open level " << sourcePath << std::endl;
+		return false;
+	}
+
+	std::vector<std::string> materialNames;
+	std::vector<std::string> materialPaths;
+	std::vector<int> ids;
+	std::vector<float> positions;
+	std::vector<float> sizes;
+	std::vector<unsigned int> materials;
+	std::vector<unsigned char> flags;
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(source, line))
+	{
+		lineNumber++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+
+		std::istringstream words(line);
+		std::string keyword;
+		if (!(words >> keyword))
+			continue;
+
+		if (keyword == "material")
+		{
+			std::string name, path;
+			if (!(words >> name >> path) || path.size() >= LEVEL_MATERIAL_PATH || materialNames.size() == LEVEL_MAX_MATERIALS)
+			{
+				printf("%s:%d: expected material <name> <image path>, at most %d materials\n", sourcePath, lineNumber, LEVEL_MAX_MATERIALS);
+				return false;
+			}
+			materialNames.push_back(name);
+			materialPaths.push_back(path);
+		}
+		else if (keyword == "object")
+		{
+			int id;
+			std::string material, kind;
+			float box[6];
+			if (!(words >> id >> material >> kind >> box[0] >> box[1] >> box[2] >> box[3] >> box[4] >> box[5]) || (kind != "static" && kind != "dynamic"))
+			{
+				printf("%s:%d: expected object <id> <material> static|dynamic <x> <y> <z> <width> <height> <depth>\n", sourcePath, lineNumber);
+				return false;
+			}
+
+			unsigned int index = 0;
+			while (index < materialNames.size() && materialNames[index] != material)
+				index++;
+			if (index == materialNames.size())
+			{
+				printf("%s:%d: unknown material %s\n", sourcePath, lineNumber, material.c_str());
+				return false;
+			}
+
+			ids.push_back(id);
+			positions.insert(positions.end(), box, box + 3);
+			sizes.insert(sizes.end(), box + 3, box + 6);
+			materials.push_back(index);
+			flags.push_back(kind == "dynamic" ? LEVEL_OBJECT_DYNAMIC : 0);
+		}
+		else
+		{
+			printf("%s:%d: unknown statement %s\n", sourcePath, lineNumber, keyword.c_str());
+			return false;
+		}
+	}
+
+	unsigned int count = (unsigned int)ids.size();
+	LevelFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = LEVEL_FILE_MAGIC;
+	header.version = LEVEL_FILE_VERSION;
+	header.objectCount = count;
+	header.materialCount = (unsigned int)materialPaths.size();
+	for (unsigned int i = 0; i < materialPaths.size(); i++)
+		memcpy(header.materials[i], materialPaths[i].c_str(), materialPaths[i].size() + 1);
+
+	size_t offset = alignLevelOffset(sizeof(LevelFileHeader));
+	header.idsOffset = (unsigned int)offset;
+	offset = alignLevelOffset(offset + count * sizeof(int));
+	header.positionsOffset = (unsigned int)offset;
+	offset = alignLevelOffset(offset + count * 3 * sizeof(float));
+	header.sizesOffset = (unsigned int)offset;
+	offset = alignLevelOffset(offset + count * 3 * sizeof(float));
+	header.materialsOffset = (unsigned int)offset;
+	offset = alignLevelOffset(offset + count * sizeof(unsigned int));
+	header.flagsOffset = (unsigned int)offset;
+	offset += count;
+
+	std::vector<unsigned char> bytes(offset, 0);
+	memcpy(&bytes[0], &header, sizeof(header));
+	if (count > 0)
+	{
+		memcpy(&bytes[header.idsOffset], &ids[0], count * sizeof(int));
+		memcpy(&bytes[header.positionsOffset], &positions[0], count * 3 * sizeof(float));
+		memcpy(&bytes[header.sizesOffset], &sizes[0], count * 3 * sizeof(float));
+		memcpy(&bytes[header.materialsOffset], &materials[0], count * sizeof(unsigned int));
+		memcpy(&bytes[header.flagsOffset], &flags[0], count);
+	}
+
+	FILE* file;
+	errno_t err = fopen_s(&file, binaryPath, "wb");
+	if (err)
+	{
+		std::cout << "Could not write level " << binaryPath << std::endl;
+		return false;
+	}
+	size_t written = fwrite(&bytes[0], 1, bytes.size(), file);
+	fclose(file);
+
+	return written == bytes.size();
+}
+
+bool validateLevelFile(const unsigned char* bytes, size_t size)
+{
+	if (bytes == NULL || size < sizeof(LevelFileHeader))
+		return false;
+
+	const LevelFileHeader* header = (const LevelFileHeader*)bytes;
+	if (header->magic != LEVEL_FILE_MAGIC || header->version != LEVEL_FILE_VERSION)
+		return false;
+	if (header->materialCount > LEVEL_MAX_MATERIALS)
+		return false;
+	for (unsigned int i = 0; i < header->materialCount; i++)
+	{
+		if (memchr(header->materials[i], 0, LEVEL_MATERIAL_PATH) == NULL)
+			return false;
+	}
+
+	size_t count = header->objectCount;
+	if ((size_t)header->idsOffset + count * sizeof(int) > size ||
+		(size_t)header->positionsOffset + count * 3 * sizeof(float) > size ||
+		(size_t)header->sizesOffset + count * 3 * sizeof(float) > size ||
+		(size_t)header->materialsOffset + count * sizeof(unsigned int) > size ||
+		(size_t)header->flagsOffset + count > size)
+		return false;
+
+	const unsigned int* materials = (const unsigned int*)(bytes + header->materialsOffset);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (materials[i] >= header->materialCount)
+			return false;
+	}
+	return true;
+}
+
+Level::Level()
+{
+	this->header = NULL;
+}
+
+bool Level::load(const char* sourcePath, const char* binaryPath)
+{
+	header = NULL;
+	file.close();
+
+	long long sourceTime = fileModifiedTime(sourcePath);
+	long long binaryTime = fileModifiedTime(binaryPath);
+	bool fresh = binaryTime != 0 && binaryTime >= sourceTime && file.open(binaryPath) && validateLevelFile(file.data(), file.size());
+
+	if (!fresh)
+	{
+		file.close();
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		if (!compileLevel(sourcePath, binaryPath) || !file.open(binaryPath) || !validateLevelFile(file.data(), file.size()))
+		{
+			std::cout << "Could not compile level " << sourcePath << std::endl;
+			file.close();
+			return false;
+		}
+		printf("Compiled %s in %.2f ms\n", binaryPath, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+
+	header = (const LevelFileHeader*)file.data();
+	return true;
+}
+
+unsigned int Level::getObjectCount()
+{
+	return header != NULL ? header->objectCount : 0;
+}
+
+const int* Level::getIds()
+{
+	return (const int*)(file.data() + header->idsOffset);
+}
+
+const glm::vec3* Level::getPositions()
+{
+	return (const glm::vec3*)(file.data() + header->positionsOffset);
+}
+
+const glm::vec3* Level::getSizes()
+{
+	return (const glm::vec3*)(file.data() + header->sizesOffset);
+}
+
+const unsigned int* Level::getMaterials()
+{
+	return (const unsigned int*)(file.data() + header->materialsOffset);
+}
+
+const unsigned char* Level::getFlags()
+{
+	return file.data() + header->flagsOffset;
+}
+
+unsigned int Level::getMaterialCount()
+{
+	return header != NULL ? header->materialCount : 0;
+}
+
+const char* Level::getMaterialPath(unsigned int material)
+{
+	return header->materials[material];
+}
+
+void appendBoxGeometry(const glm::vec3& position, const glm::vec3& size, float layer, std::vector<Vertex>& vertices, std::vector<int>& indices)
+{
+	float x = position.x;
+	float y = position.y;
+	float z = position.z;
+
+	float w = size.x;
+	float h = size.y;
+	float d = size.z;
+
+	Vertex box[24] = {
+
+		// Front face
+		Vertex(x,       y,       z + d,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f),
+		Vertex(x + w,   y,       z + d,   0.0f, 0.0f, 1.0f,   1.0f, 0.0f),
+		Vertex(x + w,   y + h,   z + d,   0.0f, 0.0f, 1.0f,   1.0f, 1.0f),
+		Vertex(x,       y + h,   z + d,   0.0f, 0.0f, 1.0f,   0.0f, 1.0f),
+
+		// Back face
+		Vertex(x,       y,       z,      0.0f, 0.0f, -1.0f,  1.0f, 0.0f),
+		Vertex(x + w,   y,       z,      0.0f, 0.0f, -1.0f,  0.0f, 0.0f),
+		Vertex(x + w,   y + h,   z,      0.0f, 0.0f, -1.0f,  0.0f, 1.0f),
+		Vertex(x,       y + h,   z,      0.0f, 0.0f, -1.0f,  1.0f, 1.0f),
+
+		// Left face
+		Vertex(x,       y,       z,      -1.0f, 0.0f, 0.0f,  0.0f, 0.0f),
+		Vertex(x,       y,       z + d,  -1.0f, 0.0f, 0.0f,  1.0f, 0.0f),
+		Vertex(x,       y + h,   z + d,  -1.0f, 0.0f, 0.0f,  1.0f, 1.0f),
+		Vertex(x,       y + h,   z,      -1.0f, 0.0f, 0.0f,  0.0f, 1.0f),
+
+		// Right face
+		Vertex(x + w,   y,       z,      1.0f, 0.0f, 0.0f,   0.0f, 0.0f),
+		Vertex(x + w,   y,       z + d,  1.0f, 0.0f, 0.0f,   1.0f, 0.0f),
+		Vertex(x + w,   y + h,   z + d,  1.0f, 0.0f, 0.0f,   1.0f, 1.0f),
+		Vertex(x + w,   y + h,   z,      1.0f, 0.0f, 0.0f,   0.0f, 1.0f),
+
+		// Top face
+		Vertex(x,       y + h,   z,      0.0f, 1.0f, 0.0f,   0.0f, 0.0f),
+		Vertex(x + w,   y + h,   z,      0.0f, 1.0f, 0.0f,   1.0f, 0.0f),
+		Vertex(x + w,   y + h,   z + d,  0.0f, 1.0f, 0.0f,   1.0f, 1.0f),
+		Vertex(x,       y + h,   z + d,  0.0f, 1.0f, 0.0f,   0.0f, 1.0f),
+
+		// Bottom face
+		Vertex(x,       y,       z,      0.0f, -1.0f, 0.0f,  0.0f, 0.0f),
+		Vertex(x + w,   y,       z,      0.0f, -1.0f, 0.0f,  1.0f, 0.0f),
+		Vertex(x + w,   y,       z + d,  0.0f, -1.0f, 0.0f,  1.0f, 1.0f),
+		Vertex(x,       y,       z + d,  0.0f, -1.0f, 0.0f,  0.0f, 1.0f)
+	};
+
+	// two triangles per face, offset to where this box starts in the batch
+	static const int faceIndices[6] = { 0, 1, 2, 2, 3, 0 };
+	int base = (int)vertices.size();
+	for (int face = 0; face < 6; face++)
+	{
+		for (int i = 0; i < 6; i++)
+			indices.push_back(base + face * 4 + faceIndices[i]);
+	}
+
+	for (int i = 0; i < 24; i++)
+	{
+		box[i].textureLayer = layer;
+		vertices.push_back(box[i]);
+	}
+}
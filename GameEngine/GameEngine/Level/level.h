@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glm.hpp>
+#include <string>
+#include <vector>
+#include "..\Model Loading\mappedFile.h"
+#include "..\Model Loading\mesh.h"
+
+// Levels are written as text (.level) and compiled to a flat binary (.glvl) that is used
+// straight from a memory mapping:
+//
+//   LevelFileHeader (material table included)
+//   ids        int[objectCount]
+//   positions  float[3][objectCount]   corner with the smallest coordinates, as in collision.h
+//   sizes      float[3][objectCount]
+//   materials  unsigned int[objectCount]  index into the material table
+//   flags      unsigned char[objectCount] LEVEL_OBJECT_DYNAMIC
+//
+// Arrays start on LEVEL_FILE_ALIGNMENT boundaries. Objects keep the order of the source file,
+// so their index is also their EntityId once loaded.
+//
+// Text syntax, one statement per line, '#' starts a comment:
+//   material <name> <image path>
+//   object <id> <material name> static|dynamic <x> <y> <z> <width> <height> <depth>
+
+#define LEVEL_FILE_MAGIC 0x4C564C47u	// "GLVL"
+#define LEVEL_FILE_VERSION 1
+#define LEVEL_FILE_ALIGNMENT 16
+#define LEVEL_MAX_MATERIALS 16
+#define LEVEL_MATERIAL_PATH 128
+
+// static objects are batched into one mesh and the collision grid, dynamic ones keep their own
+#define LEVEL_OBJECT_DYNAMIC 1
+
+struct LevelFileHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int objectCount;
+	unsigned int materialCount;
+	unsigned int idsOffset;
+	unsigned int positionsOffset;
+	unsigned int sizesOffset;
+	unsigned int materialsOffset;
+	unsigned int flagsOffset;
+	unsigned int reserved[3];
+	char materials[LEVEL_MAX_MATERIALS][LEVEL_MATERIAL_PATH];
+};
+
+// parses the text form and writes the binary one; errors name the offending line
+bool compileLevel(const char* sourcePath, const char* binaryPath);
+
+bool validateLevelFile(const unsigned char* bytes, size_t size);
+
+// Read-only view of a compiled level
+class Level
+{
+	private:
+		MappedFile file;
+		const LevelFileHeader* header;
+
+	public:
+		Level();
+
+		// maps binaryPath, compiling sourcePath first when the binary is missing or older
+		bool load(const char* sourcePath, const char* binaryPath);
+
+		unsigned int getObjectCount();
+		const int* getIds();
+		const glm::vec3* getPositions();
+		const glm::vec3* getSizes();
+		const unsigned int* getMaterials();
+		const unsigned char* getFlags();
+
+		unsigned int getMaterialCount();
+		const char* getMaterialPath(unsigned int material);
+};
+
+// the 24 vertices / 36 indices of a textured box, appended to a batch
+void appendBoxGeometry(const glm::vec3& position, const glm::vec3& size, float layer, std::vector<Vertex>& vertices, std::vector<int>& indices);
@@ -0,0 +1,355 @@
+#include "allocationTracker.h"
+#include "..\imgui\imgui.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <dbghelp.h>
+#pragma comment(lib, "dbghelp.lib")
+#else
+#include <dlfcn.h>
+#include <execinfo.h>
+#endif
+
+AllocationTracker allocationTracker;
+
+static const char* tagNames[ALLOC_TAG_COUNT] = { "other", "loader", "mesh", "render", "collision", "ui" };
+
+static thread_local AllocationTag currentTag;
+// set while the tracker itself runs, so whatever it allocates (stack capture, symbol lookup)
+// is counted but does not come back into it
+static thread_local bool trackerBusy;
+
+const char* allocationTagName(AllocationTag tag)
+{
+	return tag < ALLOC_TAG_COUNT ? tagNames[tag] : "?";
+}
+
+AllocationTag currentAllocationTag()
+{
+	return currentTag;
+}
+
+AllocationScope::AllocationScope(AllocationTag tag)
+{
+	this->previous = currentTag;
+	currentTag = tag;
+}
+
+AllocationScope::~AllocationScope()
+{
+	currentTag = previous;
+}
+
+static unsigned int captureStack(void** frames)
+{
+#ifdef _WIN32
+	return CaptureStackBackTrace(ALLOCATION_TRACKER_SKIP_FRAMES, ALLOCATION_TRACKER_STACK_DEPTH, frames, NULL);
+#else
+	void* buffer[ALLOCATION_TRACKER_STACK_DEPTH + ALLOCATION_TRACKER_SKIP_FRAMES];
+	int depth = backtrace(buffer, ALLOCATION_TRACKER_STACK_DEPTH + ALLOCATION_TRACKER_SKIP_FRAMES) - ALLOCATION_TRACKER_SKIP_FRAMES;
+	if (depth <= 0)
+		return 0;
+	memcpy(frames, buffer + ALLOCATION_TRACKER_SKIP_FRAMES, depth * sizeof(void*));
+	return depth;
+#endif
+}
+
+// function name and source line of one return address
+static void describeFrame(void* address, char* text, size_t size)
+{
+#ifdef _WIN32
+	static bool symbolsReady = false;
+	HANDLE process = GetCurrentProcess();
+	if (!symbolsReady)
+	{
+		SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS | SYMOPT_LOAD_LINES);
+		SymInitialize(process, NULL, TRUE);
+		symbolsReady = true;
+	}
+
+	char symbolBuffer[sizeof(SYMBOL_INFO) + 256];
+	SYMBOL_INFO* symbol = (SYMBOL_INFO*)symbolBuffer;
+	symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+	symbol->MaxNameLen = 255;
+	DWORD64 displacement = 0;
+	if (!SymFromAddr(process, (DWORD64)address, &displacement, symbol))
+	{
+		snprintf(text, size, "%p", address);
+		return;
+	}
+
+	IMAGEHLP_LINE64 line;
+	line.SizeOfStruct = sizeof(line);
+	DWORD lineDisplacement = 0;
+	if (SymGetLineFromAddr64(process, (DWORD64)address, &lineDisplacement, &line))
+	{
+		const char* file = strrchr(line.FileName, '\\');
+		snprintf(text, size, "%s (%s:%lu)", symbol->Name, file != NULL ? file + 1 : line.FileName, line.LineNumber);
+	}
+	else
+		snprintf(text, size, "%s", symbol->Name);
+#else
+	Dl_info info;
+	if (dladdr(address, &info) && info.dli_sname != NULL)
+		snprintf(text, size, "%s", info.dli_sname);
+	else
+		snprintf(text, size, "%p", address);
+#endif
+}
+
+// frames inside the standard library and the hooks say little about who allocated
+static bool isLibraryFrame(const char* name)
+{
+	return strncmp(name, "std::", 5) == 0 || strncmp(name, "operator new", 12) == 0 || strncmp(name, "heap", 4) == 0;
+}
+
+void AllocationTracker::setEnabled(bool enabled)
+{
+	this->enabled = enabled;
+}
+
+bool AllocationTracker::isEnabled()
+{
+	return enabled;
+}
+
+void AllocationTracker::recordAllocation(size_t size, AllocationTag tag)
+{
+	counts[tag]++;
+	bytes[tag] += size;
+
+	long long live = liveBytes[tag] += (long long)size;
+	long long peak = peakLiveBytes[tag];
+	while (live > peak && !peakLiveBytes[tag].compare_exchange_weak(peak, live)) {}
+
+	long long total = totalLiveBytes += (long long)size;
+	long long totalPeak = totalPeakLiveBytes;
+	while (total > totalPeak && !totalPeakLiveBytes.compare_exchange_weak(totalPeak, total)) {}
+
+	if (!trackerBusy)
+	{
+		trackerBusy = true;
+		recordCallSite(size, tag);
+		trackerBusy = false;
+	}
+}
+
+void AllocationTracker::recordFree(size_t size, AllocationTag tag)
+{
+	liveBytes[tag] -= (long long)size;
+	totalLiveBytes -= (long long)size;
+}
+
+void AllocationTracker::recordCallSite(size_t size, AllocationTag tag)
+{
+	void* frames[ALLOCATION_TRACKER_STACK_DEPTH];
+	unsigned int depth = captureStack(frames);
+
+	// FNV-1a over the return addresses and the tag
+	unsigned int hash = 2166136261u ^ (unsigned int)tag;
+	for (unsigned int i = 0; i < depth; i++)
+	{
+		size_t address = (size_t)frames[i];
+		for (unsigned int b = 0; b < sizeof(size_t); b++)
+			hash = (hash ^ (unsigned int)((address >> (b * 8)) & 0xFF)) * 16777619u;
+	}
+
+	while (sitesLock.exchange(true, std::memory_order_acquire)) {}
+
+	unsigned int slot = hash % ALLOCATION_TRACKER_CALL_SITES;
+	for (unsigned int probe = 0; probe < ALLOCATION_TRACKER_CALL_SITES; probe++)
+	{
+		AllocationCallSite& site = sites[slot];
+		if (site.count == 0)
+		{
+			memcpy(site.frames, frames, depth * sizeof(void*));
+			site.depth = depth;
+			site.hash = hash;
+			site.tag = tag;
+			site.name[0] = '\0';
+			siteCount++;
+		}
+		if (site.hash == hash && site.tag == tag && site.depth == depth && memcmp(site.frames, frames, depth * sizeof(void*)) == 0)
+		{
+			site.count++;
+			site.bytes += size;
+			sitesLock.store(false, std::memory_order_release);
+			return;
+		}
+		slot = (slot + 1) % ALLOCATION_TRACKER_CALL_SITES;
+	}
+
+	droppedSites++;
+	sitesLock.store(false, std::memory_order_release);
+}
+
+// the first frame outside the standard library, resolved once per site
+void AllocationTracker::describeSite(AllocationCallSite& site)
+{
+	if (site.name[0] != '\0')
+		return;
+
+	bool wasBusy = trackerBusy;
+	trackerBusy = true;
+	snprintf(site.name, sizeof(site.name), "?");
+	for (unsigned int i = 0; i < site.depth; i++)
+	{
+		describeFrame(site.frames[i], site.name, sizeof(site.name));
+		if (!isLibraryFrame(site.name))
+			break;
+	}
+	trackerBusy = wasBusy;
+}
+
+unsigned int AllocationTracker::topSites(AllocationCallSite** top, unsigned int max, bool byBytes)
+{
+	unsigned int found = 0;
+	while (sitesLock.exchange(true, std::memory_order_acquire)) {}
+	for (unsigned int i = 0; i < ALLOCATION_TRACKER_CALL_SITES; i++)
+	{
+		if (sites[i].count == 0)
+			continue;
+
+		// insertion into the short sorted list, the smallest entry drops off the end
+		unsigned long long key = byBytes ? sites[i].bytes : sites[i].count;
+		if (found == max && key <= (byBytes ? top[max - 1]->bytes : top[max - 1]->count))
+			continue;
+		unsigned int position = found < max ? found : max - 1;
+		while (position > 0 && (byBytes ? top[position - 1]->bytes : top[position - 1]->count) < key)
+		{
+			top[position] = top[position - 1];
+			position--;
+		}
+		top[position] = &sites[i];
+		if (found < max)
+			found++;
+	}
+	sitesLock.store(false, std::memory_order_release);
+	return found;
+}
+
+void AllocationTracker::beginFrame()
+{
+	for (int t = 0; t < ALLOC_TAG_COUNT; t++)
+	{
+		unsigned long long count = counts[t];
+		unsigned long long total = bytes[t];
+		if (frames > 0)
+		{
+			frameCounts[t] = count - frameStartCounts[t];
+			frameBytes[t] = total - frameStartBytes[t];
+		}
+		frameStartCounts[t] = count;
+		frameStartBytes[t] = total;
+	}
+	frames++;
+}
+
+AllocationTagStats AllocationTracker::getTagStats(AllocationTag tag)
+{
+	AllocationTagStats stats;
+	stats.count = counts[tag];
+	stats.bytes = bytes[tag];
+	stats.liveBytes = liveBytes[tag];
+	stats.peakLiveBytes = peakLiveBytes[tag];
+	stats.frameCount = frameCounts[tag];
+	stats.frameBytes = frameBytes[tag];
+	return stats;
+}
+
+long long AllocationTracker::getLiveBytes()
+{
+	return totalLiveBytes;
+}
+
+long long AllocationTracker::getPeakLiveBytes()
+{
+	return totalPeakLiveBytes;
+}
+
+void AllocationTracker::drawOverlay()
+{
+	if (!enabled)
+		return;
+
+	ImGui::Begin("Allocations");
+	ImGui::Text("Live %.2f MB, peak %.2f MB", getLiveBytes() / (1024.0 * 1024.0), getPeakLiveBytes() / (1024.0 * 1024.0));
+
+	ImGui::Columns(5, "tags");
+	ImGui::Text("subsystem"); ImGui::NextColumn();
+	ImGui::Text("frame allocs"); ImGui::NextColumn();
+	ImGui::Text("frame KB"); ImGui::NextColumn();
+	ImGui::Text("total allocs"); ImGui::NextColumn();
+	ImGui::Text("live MB"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (int t = 0; t < ALLOC_TAG_COUNT; t++)
+	{
+		AllocationTagStats stats = getTagStats((AllocationTag)t);
+		ImGui::TextUnformatted(tagNames[t]); ImGui::NextColumn();
+		ImGui::Text("%llu", stats.frameCount); ImGui::NextColumn();
+		ImGui::Text("%.1f", stats.frameBytes / 1024.0); ImGui::NextColumn();
+		ImGui::Text("%llu", stats.count); ImGui::NextColumn();
+		ImGui::Text("%.2f", stats.liveBytes / (1024.0 * 1024.0)); ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+	ImGui::Separator();
+
+	AllocationCallSite* top[ALLOCATION_TRACKER_TOP_SITES];
+	unsigned int found = topSites(top, ALLOCATION_TRACKER_TOP_SITES, false);
+	ImGui::Text("Top call sites (%u distinct)", siteCount);
+	for (unsigned int i = 0; i < found; i++)
+	{
+		describeSite(*top[i]);
+		ImGui::Text("%8llu  %8.1f KB  %-9s %s", top[i]->count, top[i]->bytes / 1024.0, tagNames[top[i]->tag], top[i]->name);
+	}
+	ImGui::End();
+}
+
+bool AllocationTracker::writeReport(const char* path)
+{
+	bool wasBusy = trackerBusy;
+	trackerBusy = true;
+
+	FILE* file;
+	if (fopen_s(&file, path, "w"))
+	{
+		printf("Could not open %s for writing\n", path);
+		trackerBusy = wasBusy;
+		return false;
+	}
+
+	fprintf(file, "Allocation report, %llu frames\n", frames);
+	fprintf(file, "live %lld bytes, peak live %lld bytes\n\n", getLiveBytes(), getPeakLiveBytes());
+	fprintf(file, "%-10s %14s %16s %14s %14s %12s %14s\n", "subsystem", "allocations", "bytes", "live", "peak live", "last frame", "last frame B");
+	for (int t = 0; t < ALLOC_TAG_COUNT; t++)
+	{
+		AllocationTagStats stats = getTagStats((AllocationTag)t);
+		fprintf(file, "%-10s %14llu %16llu %14lld %14lld %12llu %14llu\n", tagNames[t], stats.count, stats.bytes, stats.liveBytes,
+			stats.peakLiveBytes, stats.frameCount, stats.frameBytes);
+	}
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		AllocationCallSite* top[ALLOCATION_TRACKER_TOP_SITES];
+		unsigned int found = topSites(top, ALLOCATION_TRACKER_TOP_SITES, pass == 1);
+		fprintf(file, "\nTop %u call sites by %s (%u distinct, %u not recorded)\n", found, pass == 0 ? "count" : "bytes", siteCount, droppedSites);
+		for (unsigned int i = 0; i < found; i++)
+		{
+			fprintf(file, "\n%llu allocations, %llu bytes, %s\n", top[i]->count, top[i]->bytes, tagNames[top[i]->tag]);
+			for (unsigned int f = 0; f < top[i]->depth; f++)
+			{
+				char frame[256];
+				describeFrame(top[i]->frames[f], frame, sizeof(frame));
+				fprintf(file, "    %s\n", frame);
+			}
+		}
+	}
+
+	fclose(file);
+	printf("Allocation report written to %s\n", path);
+	trackerBusy = wasBusy;
+	return true;
+}
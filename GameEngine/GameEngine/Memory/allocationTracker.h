@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// subsystem an allocation is charged to, set with ALLOCATION_SCOPE on the allocating thread
+enum AllocationTag
+{
+	ALLOC_TAG_OTHER,
+	ALLOC_TAG_LOADER,
+	ALLOC_TAG_MESH,
+	ALLOC_TAG_RENDER,
+	ALLOC_TAG_COLLISION,
+	ALLOC_TAG_UI,
+	ALLOC_TAG_COUNT
+};
+
+// call sites are kept in a fixed open-addressing table, the hooks cannot allocate
+#define ALLOCATION_TRACKER_CALL_SITES 4096
+#define ALLOCATION_TRACKER_STACK_DEPTH 8
+// frames of the hooks themselves at the top of every captured stack
+#define ALLOCATION_TRACKER_SKIP_FRAMES 3
+#define ALLOCATION_TRACKER_TOP_SITES 10
+#define ALLOCATION_TRACKER_SYMBOL_NAME 96
+
+struct AllocationTagStats
+{
+	unsigned long long count;
+	unsigned long long bytes;
+	long long liveBytes;
+	long long peakLiveBytes;
+	// during the last complete frame
+	unsigned long long frameCount;
+	unsigned long long frameBytes;
+};
+
+struct AllocationCallSite
+{
+	void* frames[ALLOCATION_TRACKER_STACK_DEPTH];
+	unsigned int depth;
+	unsigned int hash;
+	AllocationTag tag;
+	unsigned long long count;
+	unsigned long long bytes;
+	// filled in when the site is first shown, see describeSite
+	char name[ALLOCATION_TRACKER_SYMBOL_NAME];
+};
+
+// Opt-in (--track-allocations) breakdown of the heap traffic that heapCounter.cpp already
+// counts: per subsystem tag, per frame, live and peak bytes, and a histogram of call stacks.
+// Only allocations made while tracking is on are charged, so enabling it late is safe.
+// Every member is zero-initialised static storage, so the hooks can use it before main.
+class AllocationTracker
+{
+	private:
+		std::atomic<bool> enabled;
+
+		std::atomic<unsigned long long> counts[ALLOC_TAG_COUNT];
+		std::atomic<unsigned long long> bytes[ALLOC_TAG_COUNT];
+		std::atomic<long long> liveBytes[ALLOC_TAG_COUNT];
+		std::atomic<long long> peakLiveBytes[ALLOC_TAG_COUNT];
+		std::atomic<long long> totalLiveBytes;
+		std::atomic<long long> totalPeakLiveBytes;
+
+		unsigned long long frameStartCounts[ALLOC_TAG_COUNT];
+		unsigned long long frameStartBytes[ALLOC_TAG_COUNT];
+		unsigned long long frameCounts[ALLOC_TAG_COUNT];
+		unsigned long long frameBytes[ALLOC_TAG_COUNT];
+		unsigned long long frames;
+
+		std::atomic<bool> sitesLock;
+		AllocationCallSite sites[ALLOCATION_TRACKER_CALL_SITES];
+		unsigned int siteCount;
+		unsigned int droppedSites;
+
+		void recordCallSite(size_t size, AllocationTag tag);
+		void describeSite(AllocationCallSite& site);
+		unsigned int topSites(AllocationCallSite** top, unsigned int max, bool byBytes);
+
+	public:
+		void setEnabled(bool enabled);
+		bool isEnabled();
+
+		// called by the heap hooks for every allocation and free they serve
+		void recordAllocation(size_t size, AllocationTag tag);
+		void recordFree(size_t size, AllocationTag tag);
+
+		void beginFrame();
+		AllocationTagStats getTagStats(AllocationTag tag);
+		long long getLiveBytes();
+		long long getPeakLiveBytes();
+
+		void drawOverlay();
+		bool writeReport(const char* path);
+};
+
+extern AllocationTracker allocationTracker;
+
+const char* allocationTagName(AllocationTag tag);
+AllocationTag currentAllocationTag();
+
+class AllocationScope
+{
+	private:
+		AllocationTag previous;
+
+	public:
+		AllocationScope(AllocationTag tag);
+		~AllocationScope();
+};
+
+#define ALLOCATION_CONCAT_INNER(a, b) a##b
+#define ALLOCATION_CONCAT(a, b) ALLOCATION_CONCAT_INNER(a, b)
+#define ALLOCATION_SCOPE(tag) AllocationScope ALLOCATION_CONCAT(allocationScope, __LINE__)(tag)
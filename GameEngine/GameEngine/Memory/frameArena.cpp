@@ -0,0 +1,131 @@
+#include "frameArena.h"
+#include "heapCounter.h"
+#include "..\imgui\imgui.h"
+#include <cstdint>
+
+FrameArena frameArena(FRAME_ARENA_SIZE);
+
+// heap allocations made during the last complete frame, measured from beginFrame to beginFrame
+static unsigned long long frameStartAllocations = 0;
+static unsigned long long lastFrameAllocations = 0;
+static unsigned long long allocatingFrames = 0;
+
+FrameArena::FrameArena(size_t capacity)
+{
+	this->capacity = capacity;
+	this->current = 0;
+	this->overflowBytes = 0;
+	this->peak = 0;
+	this->frame = 0;
+
+	for (int i = 0; i < 2; i++)
+	{
+		this->buffers[i] = (char*)heapMalloc(capacity);
+		this->used[i] = 0;
+		// the overflow lists never need to grow in a frame that fits
+		this->overflow[i].reserve(16);
+	}
+}
+
+FrameArena::~FrameArena()
+{
+	for (int i = 0; i < 2; i++)
+	{
+		rewind(i);
+		heapFree(buffers[i]);
+	}
+}
+
+void FrameArena::rewind(int buffer)
+{
+	for (unsigned int i = 0; i < overflow[buffer].size(); i++)
+		heapFree(overflow[buffer][i]);
+	overflow[buffer].clear();
+	used[buffer] = 0;
+}
+
+void FrameArena::beginFrame()
+{
+	unsigned long long allocations = heapAllocationCount();
+	if (frame > 0)
+	{
+		lastFrameAllocations = allocations - frameStartAllocations;
+		if (lastFrameAllocations > 0)
+			allocatingFrames++;
+	}
+	frameStartAllocations = allocations;
+
+	// the buffer being rewound was filled two frames ago
+	current = 1 - current;
+	rewind(current);
+	frame++;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	uintptr_t base = (uintptr_t)buffers[current];
+	uintptr_t start = (base + used[current] + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	size_t end = (size_t)(start - base) + size;
+
+	if (buffers[current] == NULL || end > capacity)
+	{
+		// too big for what is left: heap block with enough slack to align it
+		void* block = heapMalloc(size + alignment);
+		if (block == NULL)
+			return NULL;
+		overflow[current].push_back(block);
+		overflowBytes += size;
+		return (void*)(((uintptr_t)block + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	}
+
+	used[current] = end;
+	if (end > peak)
+		peak = end;
+	return (void*)start;
+}
+
+size_t FrameArena::getUsed()
+{
+	return used[current];
+}
+
+size_t FrameArena::getPeak()
+{
+	return peak;
+}
+
+size_t FrameArena::getCapacity()
+{
+	return capacity;
+}
+
+size_t FrameArena::getOverflowBytes()
+{
+	return overflowBytes;
+}
+
+unsigned long long FrameArena::getFrame()
+{
+	return frame;
+}
+
+unsigned long long FrameArena::getLastFrameHeapAllocations()
+{
+	return lastFrameAllocations;
+}
+
+unsigned long long FrameArena::getAllocatingFrames()
+{
+	return allocatingFrames;
+}
+
+void FrameArena::drawOverlay()
+{
+	ImGui::Begin("Memory");
+	ImGui::Text("Frame arena: %.1f KB used, %.1f KB peak of %.0f KB", used[current] / 1024.0, peak / 1024.0, capacity / 1024.0);
+	if (overflowBytes > 0)
+		ImGui::Text("Overflowed to the heap: %.1f KB", overflowBytes / 1024.0);
+	ImGui::Text("Heap allocations last frame: %llu", lastFrameAllocations);
+	ImGui::Text("Frames that allocated: %llu of %llu", allocatingFrames, frame > 0 ? frame - 1 : 0);
+	ImGui::End();
+}
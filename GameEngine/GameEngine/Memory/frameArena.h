@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// bytes per frame buffer; the level's culling lists, draw lists and overlay data fit many times over
+#define FRAME_ARENA_SIZE (4 * 1024 * 1024)
+#define FRAME_ARENA_ALIGNMENT 16
+
+// Bump allocator for data that only lives for a frame. There are two buffers: beginFrame()
+// switches to the other one and rewinds it, so whatever was allocated during the previous
+// frame stays valid until the end of this one. Nothing is freed individually; requests that
+// do not fit go to the heap and are released on the buffer's next rewind.
+class FrameArena
+{
+	private:
+		char* buffers[2];
+		size_t capacity;
+		size_t used[2];
+		int current;
+
+		// heap blocks handed out when a buffer was full, freed with it
+		std::vector<void*> overflow[2];
+		size_t overflowBytes;
+
+		size_t peak;
+		unsigned long long frame;
+
+		void rewind(int buffer);
+
+	public:
+		FrameArena(size_t capacity);
+		~FrameArena();
+
+		void beginFrame();
+
+		void* allocate(size_t size, size_t alignment = FRAME_ARENA_ALIGNMENT);
+		template <typename T>
+		T* allocateArray(size_t count)
+		{
+			return (T*)allocate(count * sizeof(T), alignof(T) > FRAME_ARENA_ALIGNMENT ? alignof(T) : FRAME_ARENA_ALIGNMENT);
+		}
+
+		size_t getUsed();
+		size_t getPeak();
+		size_t getCapacity();
+		// bytes that did not fit since start-up
+		size_t getOverflowBytes();
+		unsigned long long getFrame();
+
+		// heap allocations (heapCounter.h) between the last two beginFrame calls
+		unsigned long long getLastFrameHeapAllocations();
+		unsigned long long getAllocatingFrames();
+
+		void drawOverlay();
+};
+
+extern FrameArena frameArena;
+
+// STL allocator on top of frameArena, for containers that are built and thrown away within
+// a frame (or the next one). deallocate does nothing; the memory comes back with the buffer.
+template <typename T>
+class FrameAllocator
+{
+	public:
+		typedef T value_type;
+
+		FrameAllocator() {}
+		template <typename U>
+		FrameAllocator(const FrameAllocator<U>&) {}
+
+		T* allocate(size_t count)
+		{
+			return frameArena.allocateArray<T>(count);
+		}
+
+		void deallocate(T*, size_t) {}
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&)
+{
+	return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&)
+{
+	return false;
+}
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T> >;
@@ -0,0 +1,144 @@
+#include "heapCounter.h"
+#include "allocationTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+static std::atomic<unsigned long long> allocationCount(0);
+static std::atomic<unsigned long long> allocatedBytes(0);
+
+// in front of every block, so a free knows what it is releasing and who it was charged to;
+// 16 bytes keep the block after it at malloc's alignment
+struct alignas(16) HeapBlockHeader
+{
+	size_t size;
+	unsigned int tag;
+	unsigned int tracked;
+};
+
+static void* countedMalloc(size_t size, AllocationTag tag)
+{
+	HeapBlockHeader* header = (HeapBlockHeader*)malloc(sizeof(HeapBlockHeader) + size);
+	if (header == NULL)
+		return NULL;
+
+	allocationCount++;
+	allocatedBytes += size;
+
+	header->size = size;
+	header->tag = tag;
+	header->tracked = allocationTracker.isEnabled();
+	if (header->tracked)
+		allocationTracker.recordAllocation(size, tag);
+	return header + 1;
+}
+
+static void countedFree(void* ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	HeapBlockHeader* header = (HeapBlockHeader*)ptr - 1;
+	if (header->tracked)
+		allocationTracker.recordFree(header->size, (AllocationTag)header->tag);
+	free(header);
+}
+
+unsigned long long heapAllocationCount()
+{
+	return allocationCount.load();
+}
+
+unsigned long long heapAllocatedBytes()
+{
+	return allocatedBytes.load();
+}
+
+void* heapMalloc(size_t size)
+{
+	return countedMalloc(size, currentAllocationTag());
+}
+
+void* heapRealloc(void* ptr, size_t size)
+{
+	if (ptr == NULL)
+		return heapMalloc(size);
+
+	// a new block rather than realloc, so the tracker sees the old one freed and the new one made
+	void* block = heapMalloc(size);
+	if (block == NULL)
+		return NULL;
+	size_t oldSize = ((HeapBlockHeader*)ptr - 1)->size;
+	memcpy(block, ptr, oldSize < size ? oldSize : size);
+	countedFree(ptr);
+	return block;
+}
+
+void heapFree(void* ptr)
+{
+	countedFree(ptr);
+}
+
+void* heapCounterImGuiAlloc(size_t size, void* userData)
+{
+	return countedMalloc(size, ALLOC_TAG_UI);
+}
+
+void heapCounterImGuiFree(void* ptr, void* userData)
+{
+	countedFree(ptr);
+}
+
+void* operator new(size_t size)
+{
+	void* ptr = countedMalloc(size, currentAllocationTag());
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return countedMalloc(size, currentAllocationTag());
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return countedMalloc(size, currentAllocationTag());
+}
+
+void operator delete(void* ptr) noexcept
+{
+	countedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	countedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	countedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	countedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	countedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	countedFree(ptr);
+}
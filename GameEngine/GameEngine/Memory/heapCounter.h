@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+// The game replaces the global operator new/delete (heapCounter.cpp) and hands ImGui and
+// stb_image the allocator below, so every heap allocation made through them is counted.
+// Loading is expected to allocate; a steady-state frame should not. The per-subsystem
+// breakdown is in allocationTracker.h.
+unsigned long long heapAllocationCount();
+unsigned long long heapAllocatedBytes();
+
+// malloc family with the same counting (and tracking, when it is enabled)
+void* heapMalloc(size_t size);
+void* heapRealloc(void* ptr, size_t size);
+void heapFree(void* ptr);
+
+// for ImGui::SetAllocatorFunctions; charged to ALLOC_TAG_UI
+void* heapCounterImGuiAlloc(size_t size, void* userData);
+void heapCounterImGuiFree(void* ptr, void* userData);
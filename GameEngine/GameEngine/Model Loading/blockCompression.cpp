@@ -0,0 +1,700 @@
+#include "blockCompression.h"
+#include "..\Threading\parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_COMPRESSION_SSE2
+#include <emmintrin.h>
+#endif
+
+// below this many blocks an image is encoded on the calling thread only
+#define BLOCK_COMPRESSION_MIN_PARALLEL_BLOCKS 256
+
+// a 4x4 block stored one channel after the other, so four pixels fit in an SSE register
+struct Block
+{
+	float channels[4][16];
+};
+
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+unsigned int compressedBlockBytes(GLenum format)
+{
+	switch (format)
+	{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			return 8;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+size_t compressedImageSize(GLenum format, unsigned int width, unsigned int height)
+{
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * compressedBlockBytes(format);
+}
+
+static float clampColour(float value)
+{
+	return value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+}
+
+static void loadBlock(const unsigned char* rgba, unsigned int width, unsigned int height, unsigned int blockX, unsigned int blockY, Block& block)
+{
+	for (unsigned int y = 0; y < 4; y++)
+	{
+		unsigned int py = std::min(blockY * 4 + y, height - 1);
+		for (unsigned int x = 0; x < 4; x++)
+		{
+			unsigned int px = std::min(blockX * 4 + x, width - 1);
+			const unsigned char* p = rgba + (py * width + px) * 4;
+			for (int c = 0; c < 4; c++)
+				block.channels[c][y * 4 + x] = p[c];
+		}
+	}
+}
+
+// nearest palette entry for every pixel over the first `channels` channels; returns the summed squared error
+static float chooseIndices(const Block& block, const float palette[][4], int paletteSize, int channels, unsigned char indices[16])
+{
+#ifdef BLOCK_COMPRESSION_SSE2
+	__m128 total = _mm_setzero_ps();
+	for (int group = 0; group < 16; group += 4)
+	{
+		__m128 best = _mm_set1_ps(1e30f);
+		__m128 bestIndex = _mm_setzero_ps();
+		for (int e = 0; e < paletteSize; e++)
+		{
+			__m128 distance = _mm_setzero_ps();
+			for (int c = 0; c < channels; c++)
+			{
+				__m128 d = _mm_sub_ps(_mm_loadu_ps(&block.channels[c][group]), _mm_set1_ps(palette[e][c]));
+				distance = _mm_add_ps(distance, _mm_mul_ps(d, d));
+			}
+			__m128 closer = _mm_cmplt_ps(distance, best);
+			best = _mm_min_ps(distance, best);
+			bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)e)), _mm_andnot_ps(closer, bestIndex));
+		}
+		total = _mm_add_ps(total, best);
+
+		float lanes[4];
+		_mm_storeu_ps(lanes, bestIndex);
+		for (int i = 0; i < 4; i++)
+			indices[group + i] = (unsigned char)lanes[i];
+	}
+
+	float sums[4];
+	_mm_storeu_ps(sums, total);
+	return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+	float total = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		float best = 1e30f;
+		for (int e = 0; e < paletteSize; e++)
+		{
+			float distance = 0.0f;
+			for (int c = 0; c < channels; c++)
+			{
+				float d = block.channels[c][i] - palette[e][c];
+				distance += d * d;
+			}
+			if (distance < best)
+			{
+				best = distance;
+				indices[i] = (unsigned char)e;
+			}
+		}
+		total += best;
+	}
+	return total;
+#endif
+}
+
+// mean and principal axis (power iteration on the covariance) of the first `channels` channels
+static void principalAxis(const Block& block, int channels, float mean[4], float axis[4])
+{
+	for (int c = 0; c < 4; c++)
+	{
+		mean[c] = 0.0f;
+		axis[c] = 0.0f;
+		if (c >= channels)
+			continue;
+		for (int i = 0; i < 16; i++)
+			mean[c] += block.channels[c][i];
+		mean[c] /= 16.0f;
+	}
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		for (int a = 0; a < channels; a++)
+		{
+			for (int b = 0; b < channels; b++)
+				covariance[a][b] += (block.channels[a][i] - mean[a]) * (block.channels[b][i] - mean[b]);
+		}
+	}
+
+	// start from the channel with the largest spread
+	int start = 0;
+	for (int c = 1; c < channels; c++)
+	{
+		if (covariance[c][c] > covariance[start][start])
+			start = c;
+	}
+	if (covariance[start][start] <= 0.0f)
+		return;
+	for (int c = 0; c < channels; c++)
+		axis[c] = covariance[start][c];
+
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4] = {};
+		float largest = 0.0f;
+		for (int a = 0; a < channels; a++)
+		{
+			for (int b = 0; b < channels; b++)
+				next[a] += covariance[a][b] * axis[b];
+			largest = std::max(largest, fabsf(next[a]));
+		}
+		if (largest == 0.0f)
+			return;
+		for (int c = 0; c < channels; c++)
+			axis[c] = next[c] / largest;
+	}
+
+	float length = 0.0f;
+	for (int c = 0; c < channels; c++)
+		length += axis[c] * axis[c];
+	length = sqrtf(length);
+	for (int c = 0; c < channels; c++)
+		axis[c] /= length;
+}
+
+// end points of the block's extent along the axis, pulled in by `inset` of the range
+static void axisEndpoints(const Block& block, int channels, const float mean[4], const float axis[4], float inset, float e0[4], float e1[4])
+{
+	float lowest = 0.0f;
+	float highest = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		float t = 0.0f;
+		for (int c = 0; c < channels; c++)
+			t += (block.channels[c][i] - mean[c]) * axis[c];
+		lowest = std::min(lowest, t);
+		highest = std::max(highest, t);
+	}
+
+	float range = (highest - lowest) * inset;
+	highest -= range;
+	lowest += range;
+
+	for (int c = 0; c < 4; c++)
+	{
+		e0[c] = clampColour(mean[c] + axis[c] * highest);
+		e1[c] = clampColour(mean[c] + axis[c] * lowest);
+	}
+}
+
+// least-squares end points for fixed indices; weights[index] is how much of e0 that index takes
+static bool fitEndpoints(const Block& block, int channels, const unsigned char indices[16], const float weights[], float e0[4], float e1[4])
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = {}, bx[4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float a = weights[indices[i]];
+		float b = 1.0f - a;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < channels; c++)
+		{
+			ax[c] += a * block.channels[c][i];
+			bx[c] += b * block.channels[c][i];
+		}
+	}
+
+	float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f)
+		return false;
+
+	for (int c = 0; c < channels; c++)
+	{
+		e0[c] = clampColour((bb * ax[c] - ab * bx[c]) / determinant);
+		e1[c] = clampColour((aa * bx[c] - ab * ax[c]) / determinant);
+	}
+	return true;
+}
+
+// BC1
+
+static unsigned short packRGB565(const float colour[4])
+{
+	int r = (int)(colour[0] * 31.0f / 255.0f + 0.5f);
+	int g = (int)(colour[1] * 63.0f / 255.0f + 0.5f);
+	int b = (int)(colour[2] * 31.0f / 255.0f + 0.5f);
+	return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+static void unpackRGB565(unsigned short packed, int rgb[3])
+{
+	int r = (packed >> 11) & 31;
+	int g = (packed >> 5) & 63;
+	int b = packed & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// BC3 colour blocks always use four colours; BC1 switches to three colours and black when c0 <= c1
+static void colourPalette(unsigned short c0, unsigned short c1, bool fourColourOnly, int palette[4][4])
+{
+	int a[3], b[3];
+	unpackRGB565(c0, a);
+	unpackRGB565(c1, b);
+
+	for (int c = 0; c < 3; c++)
+	{
+		palette[0][c] = a[c];
+		palette[1][c] = b[c];
+		if (fourColourOnly || c0 > c1)
+		{
+			palette[2][c] = (2 * a[c] + b[c]) / 3;
+			palette[3][c] = (a[c] + 2 * b[c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (a[c] + b[c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	for (int i = 0; i < 4; i++)
+		palette[i][3] = 255;
+}
+
+static float evaluateColourBlock(const Block& block, const float e0[4], const float e1[4], bool fourColourOnly, unsigned short& c0, unsigned short& c1, unsigned char indices[16])
+{
+	c0 = packRGB565(e0);
+	c1 = packRGB565(e1);
+	if (c0 < c1)
+		std::swap(c0, c1);
+
+	int palette[4][4];
+	colourPalette(c0, c1, fourColourOnly, palette);
+
+	float paletteValues[4][4];
+	for (int i = 0; i < 4; i++)
+	{
+		for (int c = 0; c < 4; c++)
+			paletteValues[i][c] = (float)palette[i][c];
+	}
+	return chooseIndices(block, paletteValues, 4, 3, indices);
+}
+
+static void encodeColourBlock(const Block& block, bool fourColourOnly, unsigned char* out)
+{
+	static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+	float mean[4], axis[4], e0[4], e1[4];
+	principalAxis(block, 3, mean, axis);
+	axisEndpoints(block, 3, mean, axis, 1.0f / 16.0f, e0, e1);
+
+	unsigned short c0, c1;
+	unsigned char indices[16];
+	float error = evaluateColourBlock(block, e0, e1, fourColourOnly, c0, c1, indices);
+
+	for (int iteration = 0; iteration < 2 && error > 0.0f; iteration++)
+	{
+		// the palette may have been swapped while packing, so refit against the packed order
+		int packed0[3], packed1[3];
+		unpackRGB565(c0, packed0);
+		unpackRGB565(c1, packed1);
+		for (int c = 0; c < 3; c++)
+		{
+			e0[c] = (float)packed0[c];
+			e1[c] = (float)packed1[c];
+		}
+		if (c0 == c1 || !fitEndpoints(block, 3, indices, weights, e0, e1))
+			break;
+
+		unsigned short r0, r1;
+		unsigned char refined[16];
+		float refinedError = evaluateColourBlock(block, e0, e1, fourColourOnly, r0, r1, refined);
+		if (refinedError >= error)
+			break;
+
+		error = refinedError;
+		c0 = r0;
+		c1 = r1;
+		memcpy(indices, refined, 16);
+	}
+
+	unsigned int bits = 0;
+	for (int i = 0; i < 16; i++)
+		bits |= (unsigned int)indices[i] << (2 * i);
+
+	out[0] = (unsigned char)(c0 & 0xFF);
+	out[1] = (unsigned char)(c0 >> 8);
+	out[2] = (unsigned char)(c1 & 0xFF);
+	out[3] = (unsigned char)(c1 >> 8);
+	for (int i = 0; i < 4; i++)
+		out[4 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+static void decodeColourBlock(const unsigned char* in, bool fourColourOnly, unsigned char pixels[16][4])
+{
+	unsigned short c0 = (unsigned short)(in[0] | (in[1] << 8));
+	unsigned short c1 = (unsigned short)(in[2] | (in[3] << 8));
+	unsigned int bits = in[4] | (in[5] << 8) | (in[6] << 16) | ((unsigned int)in[7] << 24);
+
+	int palette[4][4];
+	colourPalette(c0, c1, fourColourOnly, palette);
+
+	for (int i = 0; i < 16; i++)
+	{
+		int index = (bits >> (2 * i)) & 3;
+		for (int c = 0; c < 3; c++)
+			pixels[i][c] = (unsigned char)palette[index][c];
+	}
+}
+
+// BC3 alpha (the BC4 layout)
+
+static void alphaPalette(int a0, int a1, int palette[8])
+{
+	palette[0] = a0;
+	palette[1] = a1;
+	if (a0 > a1)
+	{
+		for (int i = 2; i < 8; i++)
+			palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+	}
+	else
+	{
+		for (int i = 2; i < 6; i++)
+			palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static void encodeAlphaBlock(const Block& block, unsigned char* out)
+{
+	int lowest = 255;
+	int highest = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		lowest = std::min(lowest, (int)block.channels[3][i]);
+		highest = std::max(highest, (int)block.channels[3][i]);
+	}
+
+	int palette[8];
+	alphaPalette(highest, lowest, palette);
+
+	unsigned long long bits = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int value = (int)block.channels[3][i];
+		int best = 0;
+		for (int e = 1; e < 8; e++)
+		{
+			if (abs(palette[e] - value) < abs(palette[best] - value))
+				best = e;
+		}
+		bits |= (unsigned long long)best << (3 * i);
+	}
+
+	out[0] = (unsigned char)highest;
+	out[1] = (unsigned char)lowest;
+	for (int i = 0; i < 6; i++)
+		out[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+static void decodeAlphaBlock(const unsigned char* in, unsigned char pixels[16][4])
+{
+	int palette[8];
+	alphaPalette(in[0], in[1], palette);
+
+	unsigned long long bits = 0;
+	for (int i = 0; i < 6; i++)
+		bits |= (unsigned long long)in[2 + i] << (8 * i);
+
+	for (int i = 0; i < 16; i++)
+		pixels[i][3] = (unsigned char)palette[(bits >> (3 * i)) & 7];
+}
+
+// BC7 mode 6
+
+static void putBits(unsigned char* out, int& position, int count, int value)
+{
+	for (int i = 0; i < count; i++, position++)
+	{
+		if ((value >> i) & 1)
+			out[position >> 3] |= (unsigned char)(1 << (position & 7));
+	}
+}
+
+static int getBits(const unsigned char* in, int& position, int count)
+{
+	int value = 0;
+	for (int i = 0; i < count; i++, position++)
+		value |= ((in[position >> 3] >> (position & 7)) & 1) << i;
+	return value;
+}
+
+// 7-bit end point plus the p-bit shared by its channels, whichever p-bit lands closer
+static void quantizeBC7Endpoint(const float endpoint[4], int quantized[4], int& pbit)
+{
+	float bestError = 1e30f;
+	for (int p = 0; p < 2; p++)
+	{
+		int candidate[4];
+		float error = 0.0f;
+		for (int c = 0; c < 4; c++)
+		{
+			candidate[c] = std::min(127, std::max(0, (int)floorf((endpoint[c] - p) / 2.0f + 0.5f)));
+			float d = (float)((candidate[c] << 1) | p) - endpoint[c];
+			error += d * d;
+		}
+		if (error < bestError)
+		{
+			bestError = error;
+			pbit = p;
+			memcpy(quantized, candidate, sizeof(candidate));
+		}
+	}
+}
+
+static float evaluateBC7Block(const Block& block, const float e0[4], const float e1[4], int q0[4], int q1[4], int& p0, int& p1, unsigned char indices[16])
+{
+	quantizeBC7Endpoint(e0, q0, p0);
+	quantizeBC7Endpoint(e1, q1, p1);
+
+	float palette[16][4];
+	for (int c = 0; c < 4; c++)
+	{
+		int a = (q0[c] << 1) | p0;
+		int b = (q1[c] << 1) | p1;
+		for (int i = 0; i < 16; i++)
+			palette[i][c] = (float)(((64 - bc7Weights[i]) * a + bc7Weights[i] * b + 32) >> 6);
+	}
+	return chooseIndices(block, palette, 16, 4, indices);
+}
+
+static void encodeBC7Block(const Block& block, unsigned char* out)
+{
+	float weights[16];
+	for (int i = 0; i < 16; i++)
+		weights[i] = 1.0f - bc7Weights[i] / 64.0f;
+
+	float mean[4], axis[4], e0[4], e1[4];
+	principalAxis(block, 4, mean, axis);
+	axisEndpoints(block, 4, mean, axis, 0.0f, e0, e1);
+
+	int q0[4], q1[4], p0, p1;
+	unsigned char indices[16];
+	float error = evaluateBC7Block(block, e0, e1, q0, q1, p0, p1, indices);
+
+	for (int iteration = 0; iteration < 2 && error > 0.0f; iteration++)
+	{
+		if (!fitEndpoints(block, 4, indices, weights, e0, e1))
+			break;
+
+		int r0[4], r1[4], rp0, rp1;
+		unsigned char refined[16];
+		float refinedError = evaluateBC7Block(block, e0, e1, r0, r1, rp0, rp1, refined);
+		if (refinedError >= error)
+			break;
+
+		error = refinedError;
+		memcpy(q0, r0, sizeof(r0));
+		memcpy(q1, r1, sizeof(r1));
+		p0 = rp0;
+		p1 = rp1;
+		memcpy(indices, refined, 16);
+	}
+
+	// the first index is stored with its top bit implied zero
+	if (indices[0] & 8)
+	{
+		for (int c = 0; c < 4; c++)
+			std::swap(q0[c], q1[c]);
+		std::swap(p0, p1);
+		for (int i = 0; i < 16; i++)
+			indices[i] = (unsigned char)(15 - indices[i]);
+	}
+
+	memset(out, 0, 16);
+	int position = 0;
+	putBits(out, position, 7, 1 << 6);
+	for (int c = 0; c < 4; c++)
+	{
+		putBits(out, position, 7, q0[c]);
+		putBits(out, position, 7, q1[c]);
+	}
+	putBits(out, position, 1, p0);
+	putBits(out, position, 1, p1);
+	for (int i = 0; i < 16; i++)
+		putBits(out, position, i == 0 ? 3 : 4, indices[i]);
+}
+
+// only mode 6 is decoded, other modes come out magenta
+static void decodeBC7Block(const unsigned char* in, unsigned char pixels[16][4])
+{
+	if ((in[0] & 0x7F) != 0x40)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			pixels[i][0] = 255;
+			pixels[i][1] = 0;
+			pixels[i][2] = 255;
+			pixels[i][3] = 255;
+		}
+		return;
+	}
+
+	int position = 7;
+	int q0[4], q1[4];
+	for (int c = 0; c < 4; c++)
+	{
+		q0[c] = getBits(in, position, 7);
+		q1[c] = getBits(in, position, 7);
+	}
+	int p0 = getBits(in, position, 1);
+	int p1 = getBits(in, position, 1);
+
+	for (int i = 0; i < 16; i++)
+	{
+		int weight = bc7Weights[getBits(in, position, i == 0 ? 3 : 4)];
+		for (int c = 0; c < 4; c++)
+		{
+			int a = (q0[c] << 1) | p0;
+			int b = (q1[c] << 1) | p1;
+			pixels[i][c] = (unsigned char)(((64 - weight) * a + weight * b + 32) >> 6);
+		}
+	}
+}
+
+static void encodeBlock(GLenum format, const Block& block, unsigned char* out)
+{
+	switch (format)
+	{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			encodeColourBlock(block, false, out);
+			break;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			encodeAlphaBlock(block, out);
+			encodeColourBlock(block, true, out + 8);
+			break;
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			encodeBC7Block(block, out);
+			break;
+	}
+}
+
+static void decodeBlock(GLenum format, const unsigned char* in, unsigned char pixels[16][4])
+{
+	for (int i = 0; i < 16; i++)
+		pixels[i][3] = 255;
+
+	switch (format)
+	{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			decodeColourBlock(in, false, pixels);
+			break;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			decodeAlphaBlock(in, pixels);
+			decodeColourBlock(in + 8, true, pixels);
+			break;
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			decodeBC7Block(in, pixels);
+			break;
+	}
+}
+
+void compressImage(GLenum format, const unsigned char* rgba, unsigned int width, unsigned int height, std::vector<unsigned char>& blocks)
+{
+	unsigned int blockBytes = compressedBlockBytes(format);
+	unsigned int blocksX = (width + 3) / 4;
+	unsigned int blocksY = (height + 3) / 4;
+	blocks.resize(compressedImageSize(format, width, height));
+
+	unsigned char* out = &blocks[0];
+	auto encodeRows = [=](unsigned int firstRow, unsigned int lastRow) {
+		Block block;
+		for (unsigned int by = firstRow; by < lastRow; by++)
+		{
+			for (unsigned int bx = 0; bx < blocksX; bx++)
+			{
+				loadBlock(rgba, width, height, bx, by, block);
+				encodeBlock(format, block, out + (by * blocksX + bx) * blockBytes);
+			}
+		}
+	};
+
+	unsigned int bandCount = std::min(workerCount(), blocksY);
+	if (blocksX * blocksY < BLOCK_COMPRESSION_MIN_PARALLEL_BLOCKS)
+		bandCount = 1;
+
+	if (bandCount == 1)
+	{
+		encodeRows(0, blocksY);
+		return;
+	}
+
+	// contiguous bands of block rows, one per worker
+	unsigned int rowsPerBand = (blocksY + bandCount - 1) / bandCount;
+	parallelFor(bandCount, [&](unsigned int band) {
+		unsigned int firstRow = band * rowsPerBand;
+		unsigned int lastRow = std::min(blocksY, firstRow + rowsPerBand);
+		if (firstRow < lastRow)
+			encodeRows(firstRow, lastRow);
+	});
+}
+
+void decompressImage(GLenum format, const unsigned char* blocks, unsigned int width, unsigned int height, std::vector<unsigned char>& rgba)
+{
+	unsigned int blockBytes = compressedBlockBytes(format);
+	unsigned int blocksX = (width + 3) / 4;
+	unsigned int blocksY = (height + 3) / 4;
+	rgba.resize(width * height * 4);
+
+	unsigned char pixels[16][4];
+	for (unsigned int by = 0; by < blocksY; by++)
+	{
+		for (unsigned int bx = 0; bx < blocksX; bx++)
+		{
+			decodeBlock(format, blocks + (by * blocksX + bx) * blockBytes, pixels);
+			for (unsigned int y = 0; y < 4 && by * 4 + y < height; y++)
+			{
+				for (unsigned int x = 0; x < 4 && bx * 4 + x < width; x++)
+					memcpy(&rgba[((by * 4 + y) * width + bx * 4 + x) * 4], pixels[y * 4 + x], 4);
+			}
+		}
+	}
+}
+
+double computePSNR(const unsigned char* rgbaA, const unsigned char* rgbaB, size_t pixelCount)
+{
+	double squaredError = 0.0;
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			double d = (double)rgbaA[i * 4 + c] - (double)rgbaB[i * 4 + c];
+			squaredError += d * d;
+		}
+	}
+
+	if (squaredError == 0.0)
+		return 100.0;
+	double meanSquaredError = squaredError / (pixelCount * 3);
+	return std::min(100.0, 10.0 * log10(255.0 * 255.0 / meanSquaredError));
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <glew.h>
+#include <vector>
+
+// CPU encoders/decoders for the block-compressed texture formats we bake:
+//   BC1 (GL_COMPRESSED_RGB_S3TC_DXT1_EXT)   4 bpp, opaque colour
+//   BC3 (GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)  8 bpp, BC1 colour + 8-level alpha
+//   BC7 (GL_COMPRESSED_RGBA_BPTC_UNORM)     8 bpp, mode 6 only (single subset, 16 index levels)
+// Images are tightly packed RGBA8; edge blocks of sizes that are not a multiple of 4 repeat
+// the last row/column. Encoding runs on all hardware threads and uses SSE2 where available.
+
+// bytes per 4x4 block, 0 if format is not one of the formats above
+unsigned int compressedBlockBytes(GLenum format);
+size_t compressedImageSize(GLenum format, unsigned int width, unsigned int height);
+
+void compressImage(GLenum format, const unsigned char* rgba, unsigned int width, unsigned int height, std::vector<unsigned char>& blocks);
+void decompressImage(GLenum format, const unsigned char* blocks, unsigned int width, unsigned int height, std::vector<unsigned char>& rgba);
+
+// peak signal-to-noise ratio of the colour channels in dB, capped at 100 for identical images
+double computePSNR(const unsigned char* rgbaA, const unsigned char* rgbaB, size_t pixelCount);
@@ -0,0 +1,129 @@
+#include "mappedFile.h"
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	bytes = NULL;
+	length = 0;
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+#else
+	descriptor = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const char* path)
+{
+	close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL)
+	{
+		close();
+		return false;
+	}
+
+	bytes = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	descriptor = ::open(path, O_RDONLY);
+	if (descriptor < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+	{
+		close();
+		return false;
+	}
+	length = (size_t)info.st_size;
+
+	void* mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	bytes = mapping == MAP_FAILED ? NULL : (const unsigned char*)mapping;
+#endif
+
+	if (bytes == NULL)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (bytes != NULL)
+		UnmapViewOfFile(bytes);
+	if (mappingHandle != NULL)
+		CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+	mappingHandle = NULL;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (bytes != NULL)
+		munmap((void*)bytes, length);
+	if (descriptor >= 0)
+		::close(descriptor);
+	descriptor = -1;
+#endif
+	bytes = NULL;
+	length = 0;
+}
+
+bool MappedFile::isOpen()
+{
+	return bytes != NULL;
+}
+
+const unsigned char* MappedFile::data()
+{
+	return bytes;
+}
+
+size_t MappedFile::size()
+{
+	return length;
+}
+
+long long fileModifiedTime(const char* path)
+{
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(path, &info) != 0)
+		return 0;
+#else
+	struct stat info;
+	if (stat(path, &info) != 0)
+		return 0;
+#endif
+	return (long long)info.st_mtime;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. Baked assets are laid out so they can be
+// used straight from the mapping without parsing or copying.
+class MappedFile
+{
+	private:
+		const unsigned char* bytes;
+		size_t length;
+#ifdef _WIN32
+		void* fileHandle;
+		void* mappingHandle;
+#else
+		int descriptor;
+#endif
+
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool open(const char* path);
+		void close();
+
+		bool isOpen();
+		const unsigned char* data();
+		size_t size();
+};
+
+// last modification time of a file, 0 if it does not exist
+long long fileModifiedTime(const char* path);
@@ -0,0 +1,41 @@
+#include "materialArray.h"
+
+MaterialArray::MaterialArray()
+{
+}
+
+float MaterialArray::addMaterial(const std::string& imagepath)
+{
+	for (unsigned int i = 0; i < layers.size(); i++)
+	{
+		if (canonicalAssetPath(layers[i]) == canonicalAssetPath(imagepath))
+			return (float)i;
+	}
+
+	layers.push_back(imagepath);
+	return (float)(layers.size() - 1);
+}
+
+bool MaterialArray::build(const char* cachePath)
+{
+	texture = assetRegistry.textureArray(layers, cachePath);
+	return texture.get() != NULL;
+}
+
+GLuint MaterialArray::getId()
+{
+	return texture.isLoaded() ? texture->id : 0;
+}
+
+int MaterialArray::getLayerCount()
+{
+	return (int)layers.size();
+}
+
+Texture MaterialArray::getTexture()
+{
+	Texture result;
+	result.id = getId();
+	result.type = "texture_array";
+	return result;
+}
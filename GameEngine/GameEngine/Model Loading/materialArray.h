@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "mesh.h"
+#include "texture.h"
+#include "..\Assets\assetRegistry.h"
+
+// The diffuse textures of every scene material as layers of one GL_TEXTURE_2D_ARRAY. Meshes
+// carry their layer in Vertex::textureLayer, so any set of them draws with a single bind.
+class MaterialArray
+{
+	private:
+		std::vector<std::string> layers;
+		AssetHandle<Texture> texture;
+
+	public:
+		MaterialArray();
+
+		// layer holding the image, added on the first request for it
+		float addMaterial(const std::string& imagepath);
+		// a NULL cachePath builds the array in memory without writing a container
+		bool build(const char* cachePath);
+
+		GLuint getId();
+		int getLayerCount();
+		// what a Mesh binds for this array
+		Texture getTexture();
+};
@@ -1,4 +1,7 @@
 #include "mesh.h"
+#include "..\Graphics\glState.h"
+#include "..\Graphics\glStats.h"
+#include <cstdio>
 
 Mesh::Mesh() {}
 
@@ -20,7 +23,7 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices, std::vector<T
 }
 
 // render the mesh
-void Mesh::draw(Shader shader)
+void Mesh::draw(Shader& shader)
 {
 	unsigned int diffuseNr = 1;
 	unsigned int specularNr = 1;
@@ -29,28 +32,35 @@ void Mesh::draw(Shader shader)
 
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i); 
-											
-		std::string number;
-		std::string name = textures[i].type;
+		// uniform name built on the stack, this runs for every draw
+		const std::string& name = textures[i].type;
+		unsigned int number = 0;
 		if (name == "texture_diffuse")
-			number = std::to_string(diffuseNr++);
+			number = diffuseNr++;
 		else if (name == "texture_specular")
-			number = std::to_string(specularNr++); 
+			number = specularNr++;
 		else if (name == "texture_normal")
-			number = std::to_string(normalNr++);
+			number = normalNr++;
 		else if (name == "texture_height")
-			number = std::to_string(heightNr++); 
-
-		glUniform1i(glGetUniformLocation(shader.getId(), (name + number).c_str()), i);
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
+			number = heightNr++;
+
+		char uniformName[64];
+		bool isArray = name == "texture_array";
+		// the material array is sampled as "materials" in fragment_shader.glsl
+		if (isArray)
+			snprintf(uniformName, sizeof(uniformName), "materials");
+		else if (number > 0)
+			snprintf(uniformName, sizeof(uniformName), "%s%u", name.c_str(), number);
+		else
+			snprintf(uniformName, sizeof(uniformName), "%s", name.c_str());
+
+		glUniform1i(glGetUniformLocation(shader.getId(), uniformName), i);
+		glState.bindTexture(i, isArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, textures[i].id);
 	}
 
-	glBindVertexArray(vao);
+	// whatever this leaves bound stays bound until something else needs the unit or the vertex array
+	glState.bindVertexArray(vao);
 	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
-
-	glActiveTexture(GL_TEXTURE0);
 }
 
 void Mesh::setup()
@@ -61,11 +71,11 @@ void Mesh::setup()
 	glGenBuffers(1, &ibo);
 
 	//bind buffers
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glState.bindVertexArray(vao);
+	glState.bindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
 	glEnableVertexAttribArray(0);
@@ -77,7 +87,8 @@ void Mesh::setup()
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, textureCoords));
 
-	glBindVertexArray(0);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, textureLayer));
 }
 
 //no textures yet
@@ -87,18 +98,16 @@ void Mesh::setup2()
 	glGenBuffers(1, &vbo);
 	glGenBuffers(1, &ibo);
 
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glState.bindVertexArray(vao);
+	glState.bindBuffer(GL_ARRAY_BUFFER, vbo);
 
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-
-	glBindVertexArray(0);
 }
 
 void Mesh::setTextures(std::vector<Texture> textures)
@@ -12,6 +12,8 @@ struct Vertex
 	glm::vec3 pos;
 	glm::vec3 normals;
 	glm::vec2 textureCoords;
+	// layer in the material texture array
+	float textureLayer = 0.0f;
 
 	Vertex() {}
 
@@ -81,6 +83,6 @@ class Mesh
 		void setTextures(std::vector<Texture> textures);
 		void setup();
 		void setup2();
-		void draw(Shader shader);
+		void draw(Shader& shader);
 };
 
@@ -12,6 +12,8 @@ class MeshLoaderObj
 {
 	public:
 		MeshLoaderObj();
+		// CPU side only: fills vertices/indices without touching GL
+		bool parseObj(const std::string &filename, std::vector<Vertex> &vertices, std::vector<int> &indices);
 		Mesh loadObj(const std::string &filename, std::vector<Texture> textures);
 		Mesh loadObj(const std::string &filename);
 };
@@ -1,37 +1,42 @@
 #include "texture.h"
+#include "textureContainer.h"
+#include "..\Graphics\uploadRing.h"
+#include "..\Graphics\glState.h"
+#include "..\Graphics\glStats.h"
+#include "..\Threading\parallel.h"
+#include "..\stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 
-GLuint loadBMP(const char * imagepath) {
-
-	printf("Reading image %s\n", imagepath);
+// parses the header and leaves file positioned at the pixel data
+static bool openBMP(const char * imagepath, FILE * &file, unsigned int &width, unsigned int &height, unsigned int &imageSize) {
 
 	unsigned char header[54];
 	unsigned int dataPos;
-	unsigned int imageSize;
-	unsigned int width, height;
-
-	unsigned char * data;
 
-	FILE * file;
 	errno_t err = fopen_s(&file, imagepath, "rb");
 	if (err)
 	{
-		printf("%s could not be opened.", imagepath); getchar(); return 0;
+		printf("%s could not be opened.", imagepath); return false;
 	}
 
 	if (fread(header, 1, 54, file) != 54) {
 		printf("Not a correct BMP file\n");
-		return 0;
+		fclose(file);
+		return false;
 	}
 
 	// Parsing BMP file
 	if (header[0] != 'B' || header[1] != 'M') {
 		printf("Not a correct BMP file\n");
-		return 0;
+		fclose(file);
+		return false;
 	}
 
-	if (*(int*)&(header[0x1E]) != 0) { printf("Not a correct BMP file\n");    return 0; }
-	if (*(int*)&(header[0x1C]) != 24) { printf("Not a correct BMP file\n");    return 0; }
+	if (*(int*)&(header[0x1E]) != 0) { printf("Not a correct BMP file\n");    fclose(file); return false; }
+	if (*(int*)&(header[0x1C]) != 24) { printf("Not a correct BMP file\n");    fclose(file); return false; }
 
 	dataPos = *(int*)&(header[0x0A]);
 	imageSize = *(int*)&(header[0x22]);
@@ -41,23 +46,65 @@ GLuint loadBMP(const char * imagepath) {
 	if (imageSize == 0)    imageSize = width*height * 3; 
 	if (dataPos == 0)      dataPos = 54; 
 
-										
-	data = new unsigned char[imageSize];
+	fseek(file, dataPos, SEEK_SET);
+
+	return true;
+}
+
+bool readBMP(const char * imagepath, unsigned int &width, unsigned int &height, std::vector<unsigned char> &data) {
+
+	FILE * file;
+	unsigned int imageSize;
+	if (!openBMP(imagepath, file, width, height, imageSize))
+		return false;
+
+	data.resize(imageSize);
 
 	// Read data into buffer
-	fread(data, 1, imageSize, file);
+	fread(&data[0], 1, imageSize, file);
+
+	fclose(file);
+
+	return true;
+}
+
+GLuint loadBMP(const char * imagepath) {
+
+	printf("Reading image %s\n", imagepath);
+
+	FILE * file;
+	unsigned int width, height, imageSize;
+	if (!openBMP(imagepath, file, width, height, imageSize))
+		return 0;
 
+	// read straight into the upload ring when the image fits a slot
+	UploadSlot slot = uploadRing.acquire(imageSize);
+	std::vector<unsigned char> data;
+	unsigned char * pixels = slot.data;
+	if (slot.index < 0)
+	{
+		data.resize(imageSize);
+		pixels = &data[0];
+	}
+	fread(pixels, 1, imageSize, file);
 	fclose(file);
 
 	// Create OpenGL texture
 	GLuint textureID;
 	glGenTextures(1, &textureID);
 
-	glBindTexture(GL_TEXTURE_2D, textureID);
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
+	glState.bindTexture(GL_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, textureID);
 
-	delete[] data;
+	if (slot.index >= 0)
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, NULL);
+		uploadRing.bind();
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_BGR, GL_UNSIGNED_BYTE, (const void*)slot.offset);
+		uploadRing.unbind();
+		uploadRing.release(slot);
+	}
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, &data[0]);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -67,4 +114,411 @@ GLuint loadBMP(const char * imagepath) {
 
 	// Return the ID of the texture
 	return textureID;
-}
\ No newline at end of file
+}
+
+GLenum textureFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+// BMP rows are padded to 4 bytes
+static unsigned int bmpStride(unsigned int width)
+{
+	return (width * 3 + 3) & ~3u;
+}
+
+// FNV-1a over the file names only, so the game and AssetBaker agree whatever root they run from
+static unsigned int sourceListHash(const std::vector<std::string> &sources)
+{
+	unsigned int hash = 2166136261u;
+	for (unsigned int i = 0; i < sources.size(); i++)
+	{
+		size_t slash = sources[i].find_last_of("/\\");
+		std::string name = slash == std::string::npos ? sources[i] : sources[i].substr(slash + 1);
+		for (unsigned int c = 0; c <= name.size(); c++)
+		{
+			hash ^= c < name.size() ? (unsigned char)name[c] : 0u;
+			hash *= 16777619u;
+		}
+	}
+	return hash;
+}
+
+std::string textureCachePath(const char * imagepath)
+{
+	std::string path = imagepath;
+	size_t dot = path.find_last_of('.');
+	if (dot != std::string::npos && path.find_first_of("/\\", dot) == std::string::npos)
+		path.erase(dot);
+	return path + ".gtex";
+}
+
+bool readBMPAsRGBA(const char * imagepath, bool topDown, unsigned int &width, unsigned int &height, std::vector<unsigned char> &rgba)
+{
+	std::vector<unsigned char> data;
+	if (!readBMP(imagepath, width, height, data))
+		return false;
+
+	unsigned int stride = bmpStride(width);
+	if (topDown)
+	{
+		std::vector<unsigned char> flipped(stride * height);
+		for (unsigned int y = 0; y < height; y++)
+			memcpy(&flipped[y * stride], &data[(height - 1 - y) * stride], width * 3);
+		data.swap(flipped);
+	}
+
+	expandToRGBA(&data[0], width, height, stride, true, rgba);
+	return true;
+}
+
+bool bakeTexture(const char * imagepath, const char * cachePath, GLenum internalFormat)
+{
+	// rows stay bottom-up, matching what loadBMP uploads
+	unsigned int width, height;
+	std::vector<unsigned char> rgba;
+	if (!readBMPAsRGBA(imagepath, false, width, height, rgba))
+		return false;
+
+	BakedTexture baked;
+	baked.target = GL_TEXTURE_2D;
+	baked.sourceHash = sourceListHash(std::vector<std::string>(1, imagepath));
+	baked.internalFormat = GL_RGBA8;
+	baked.format = GL_RGBA;
+	baked.type = GL_UNSIGNED_BYTE;
+	baked.faces.resize(1);
+	buildMipChain(rgba, width, height, baked.faces[0]);
+	compressTexture(baked, internalFormat);
+
+	std::vector<unsigned char> bytes;
+	serializeTextureContainer(baked, bytes);
+	return writeTextureContainer(cachePath, bytes);
+}
+
+bool bakeCubemap(const std::vector<std::string> &faces, const char * cachePath, GLenum internalFormat)
+{
+	BakedTexture baked;
+	baked.target = GL_TEXTURE_CUBE_MAP;
+	baked.sourceHash = sourceListHash(faces);
+	baked.internalFormat = GL_RGBA8;
+	baked.format = GL_RGBA;
+	baked.type = GL_UNSIGNED_BYTE;
+	baked.faces.resize(faces.size());
+
+	// faces decode and filter independently, one per worker
+	std::vector<char> decoded(faces.size(), 0);
+	parallelFor((unsigned int)faces.size(), [&](unsigned int i) {
+		// cubemap faces are uploaded top-down, as stb_image returns them
+		unsigned int width, height;
+		std::vector<unsigned char> rgba;
+		if (!readBMPAsRGBA(faces[i].c_str(), true, width, height, rgba))
+			return;
+
+		buildMipChain(rgba, width, height, baked.faces[i]);
+		decoded[i] = 1;
+	});
+
+	for (unsigned int i = 0; i < faces.size(); i++)
+	{
+		if (!decoded[i])
+			return false;
+
+		if (baked.faces[i][0].width != baked.faces[0][0].width || baked.faces[i][0].height != baked.faces[0][0].height)
+		{
+			std::cout << "Cubemap face " << faces[i] << " does not match the size of the other faces" << std::endl;
+			return false;
+		}
+	}
+	compressTexture(baked, internalFormat);
+
+	std::vector<unsigned char> bytes;
+	serializeTextureContainer(baked, bytes);
+	return writeTextureContainer(cachePath, bytes);
+}
+
+// every layer is resized to the largest source dimension, rounded up to a power of two
+static bool buildTextureArray(const std::vector<std::string> &layers, GLenum internalFormat, std::vector<unsigned char> &bytes)
+{
+	std::vector<std::vector<unsigned char> > images(layers.size());
+	std::vector<unsigned int> widths(layers.size()), heights(layers.size());
+	unsigned int largest = 1;
+	for (unsigned int i = 0; i < layers.size(); i++)
+	{
+		if (!readBMPAsRGBA(layers[i].c_str(), false, widths[i], heights[i], images[i]))
+			return false;
+		largest = std::max(largest, std::max(widths[i], heights[i]));
+	}
+
+	unsigned int size = 1;
+	while (size < largest && size < TEXTURE_ARRAY_MAX_SIZE)
+		size *= 2;
+
+	BakedTexture baked;
+	baked.target = GL_TEXTURE_2D_ARRAY;
+	baked.sourceHash = sourceListHash(layers);
+	baked.internalFormat = GL_RGBA8;
+	baked.format = GL_RGBA;
+	baked.type = GL_UNSIGNED_BYTE;
+	baked.faces.resize(layers.size());
+
+	for (unsigned int i = 0; i < layers.size(); i++)
+	{
+		std::vector<unsigned char> resized;
+		if (widths[i] != size || heights[i] != size)
+			resizeImage(images[i], widths[i], heights[i], size, size, resized);
+		else
+			resized.swap(images[i]);
+		buildMipChain(resized, size, size, baked.faces[i]);
+	}
+	compressTexture(baked, internalFormat);
+
+	serializeTextureContainer(baked, bytes);
+	return true;
+}
+
+bool bakeTextureArray(const std::vector<std::string> &layers, const char * cachePath, GLenum internalFormat)
+{
+	std::vector<unsigned char> bytes;
+	return buildTextureArray(layers, internalFormat, bytes) && writeTextureContainer(cachePath, bytes);
+}
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool isTextureContainerFresh(GLenum target, const std::vector<std::string> &sources, const char * cachePath, GLenum internalFormat, MappedFile &file)
+{
+	long long baked = fileModifiedTime(cachePath);
+	for (unsigned int i = 0; i < sources.size(); i++)
+	{
+		if (fileModifiedTime(sources[i].c_str()) > baked)
+			return false;
+	}
+
+	if (!file.open(cachePath) || !validateTextureContainer(file.data(), file.size()))
+		return false;
+
+	const TextureContainerHeader* header = (const TextureContainerHeader*)file.data();
+	return header->target == target && header->internalFormat == internalFormat && header->sourceHash == sourceListHash(sources);
+}
+
+// maps the container at cachePath, baking it first if it is missing, stale or from an older version
+static GLuint loadContainer(GLenum target, const std::vector<std::string> &sources, const char * cachePath)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	MappedFile file;
+	bool fresh = isTextureContainerFresh(target, sources, cachePath, textureFormat, file);
+	double bakeMs = 0.0;
+
+	if (!fresh)
+	{
+		file.close();
+		std::chrono::high_resolution_clock::time_point bakeStart = std::chrono::high_resolution_clock::now();
+		bool baked;
+		if (target == GL_TEXTURE_CUBE_MAP)
+			baked = bakeCubemap(sources, cachePath, textureFormat);
+		else if (target == GL_TEXTURE_2D_ARRAY)
+			baked = bakeTextureArray(sources, cachePath, textureFormat);
+		else
+			baked = bakeTexture(sources[0].c_str(), cachePath, textureFormat);
+		bakeMs = elapsedMs(bakeStart);
+
+		if (!baked || !file.open(cachePath) || !validateTextureContainer(file.data(), file.size()))
+		{
+			std::cout << "Could not bake " << cachePath << std::endl;
+			return 0;
+		}
+	}
+
+	double mapMs = elapsedMs(start) - bakeMs;
+	std::chrono::high_resolution_clock::time_point uploadStart = std::chrono::high_resolution_clock::now();
+	GLuint textureID = uploadTextureContainer(file.data());
+	double uploadMs = elapsedMs(uploadStart);
+
+	const TextureContainerHeader* header = (const TextureContainerHeader*)file.data();
+	if (bakeMs > 0.0)
+		printf("Baked %s in %.2f ms\n", cachePath, bakeMs);
+	printf("Loaded %s: %ux%u %s, %u levels, %zu KB in VRAM (RGB8: %zu KB), %.2f ms map + %.2f ms upload\n", cachePath, header->width, header->height,
+		textureFormatName(header->internalFormat), header->levelCount, textureContainerVideoMemory(file.data()) / 1024, textureContainerRGB8Memory(file.data()) / 1024, mapMs, uploadMs);
+
+	return textureID;
+}
+
+GLuint loadTexture(const char * imagepath) {
+
+	std::string cachePath = textureCachePath(imagepath);
+	GLuint textureID = loadContainer(GL_TEXTURE_2D, std::vector<std::string>(1, imagepath), cachePath.c_str());
+	if (textureID == 0)
+		return loadBMP(imagepath);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+	return textureID;
+}
+
+// decodes every face on the worker pool straight into upload ring slots (or one system memory
+// block when the ring is unavailable), then uploads the six faces back-to-back from there
+GLuint loadCubemap(const std::vector<std::string> &faces) {
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	// headers only, so every face knows its size before decoding starts
+	std::vector<int> widths(faces.size()), heights(faces.size());
+	std::vector<size_t> offsets(faces.size() + 1, 0);
+	for (unsigned int i = 0; i < faces.size(); i++) {
+		int channels;
+		if (!stbi_info(faces[i].c_str(), &widths[i], &heights[i], &channels)) {
+			std::cerr << "Failed to load cubemap texture at " << faces[i] << ": " << stbi_failure_reason() << std::endl;
+			widths[i] = heights[i] = 0;
+		}
+		offsets[i + 1] = offsets[i] + (size_t)widths[i] * heights[i] * 3;
+	}
+	size_t stagingSize = offsets[faces.size()];
+	if (stagingSize == 0)
+		return 0;
+
+	// a face that does not get a ring slot goes through the system memory block
+	std::vector<UploadSlot> slots(faces.size());
+	std::vector<unsigned char*> destinations(faces.size());
+	std::vector<unsigned char> stagingMemory;
+	unsigned int ringFaces = 0;
+	for (unsigned int i = 0; i < faces.size(); i++) {
+		slots[i] = uploadRing.acquire(offsets[i + 1] - offsets[i]);
+		ringFaces += slots[i].index >= 0;
+	}
+	if (ringFaces < faces.size())
+		stagingMemory.resize(stagingSize);
+	for (unsigned int i = 0; i < faces.size(); i++)
+		destinations[i] = slots[i].index >= 0 ? slots[i].data : &stagingMemory[0] + offsets[i];
+	double stageMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// workers only touch their own face; no GL calls happen off the main thread
+	std::chrono::high_resolution_clock::time_point decodeStart = std::chrono::high_resolution_clock::now();
+	std::vector<char> decoded(faces.size(), 0);
+	parallelFor((unsigned int)faces.size(), [&](unsigned int i) {
+		int width, height, channels;
+		unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &channels, 3);
+		if (data == NULL)
+			return;
+		if (width == widths[i] && height == heights[i]) {
+			memcpy(destinations[i], data, offsets[i + 1] - offsets[i]);
+			decoded[i] = 1;
+		}
+		stbi_image_free(data);
+	});
+	double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - decodeStart).count();
+
+	std::chrono::high_resolution_clock::time_point uploadStart = std::chrono::high_resolution_clock::now();
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	glState.bindTexture(GL_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (unsigned int i = 0; i < faces.size(); i++) {
+		if (!decoded[i]) {
+			std::cerr << "Failed to load cubemap texture at " << faces[i] << std::endl;
+			uploadRing.release(slots[i]);
+			continue;
+		}
+
+		if (slots[i].index >= 0) {
+			// the copy out of the ring runs on the driver's side; the fence guards the slot
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, widths[i], heights[i], 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+			uploadRing.bind();
+			glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, widths[i], heights[i], GL_RGB, GL_UNSIGNED_BYTE, (const void*)slots[i].offset);
+			uploadRing.unbind();
+			uploadRing.release(slots[i]);
+		}
+		else
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, widths[i], heights[i], 0, GL_RGB, GL_UNSIGNED_BYTE, destinations[i]);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - uploadStart).count();
+
+	printf("Loaded cubemap: %zu faces, %zu KB, %u/%zu faces through the upload ring, %.2f ms headers + %.2f ms decode (%u workers) + %.2f ms upload\n", faces.size(),
+		stagingSize / 1024, ringFaces, faces.size(), stageMs, decodeMs, std::min(workerCount(), (unsigned int)faces.size()), uploadMs);
+
+	return textureID;
+}
+
+GLuint loadCubemapTexture(const std::vector<std::string> &faces, const char * cachePath) {
+
+	GLuint textureID = loadContainer(GL_TEXTURE_CUBE_MAP, faces, cachePath);
+	if (textureID == 0)
+		return 0;
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	return textureID;
+}
+
+GLuint loadTextureArray(const std::vector<std::string> &layers, const char * cachePath) {
+
+	GLuint textureID;
+	if (cachePath != NULL)
+	{
+		textureID = loadContainer(GL_TEXTURE_2D_ARRAY, layers, cachePath);
+	}
+	else
+	{
+		std::vector<unsigned char> bytes;
+		if (!buildTextureArray(layers, textureFormat, bytes))
+			return 0;
+		textureID = uploadTextureContainer(&bytes[0]);
+	}
+	if (textureID == 0)
+		return 0;
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+	return textureID;
+}
+
+size_t textureVideoMemory(GLenum target, GLuint textureID) {
+
+	// cube faces are queried through +X and counted six times
+	GLenum levelTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+	size_t faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+
+	glState.bindTexture(GL_STATE_UPLOAD_UNIT, target, textureID);
+	size_t bytes = 0;
+	for (GLint level = 0; level < 16; level++)
+	{
+		GLint width = 0, height = 0, depth = 0, compressed = 0;
+		glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_WIDTH, &width);
+		if (width == 0)
+			break;
+		glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_DEPTH, &depth);
+		glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED, &compressed);
+
+		if (compressed)
+		{
+			GLint size = 0;
+			glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+			bytes += (size_t)size * faces;
+			continue;
+		}
+
+		GLint red = 0, green = 0, blue = 0, alpha = 0;
+		glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_RED_SIZE, &red);
+		glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_GREEN_SIZE, &green);
+		glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_BLUE_SIZE, &blue);
+		glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_ALPHA_SIZE, &alpha);
+		bytes += (size_t)width * height * std::max(depth, 1) * (red + green + blue + alpha) / 8 * faces;
+	}
+	return bytes;
+}
@@ -1,5 +1,43 @@
 #pragma once
 #include <glew.h>
 #include <glfw3.h>
+#include <string>
+#include <vector>
+#include "mappedFile.h"
+
+// reads a 24-bit uncompressed BMP into BGR rows (bottom-up, as stored); no GL calls
+bool readBMP(const char * imagepath, unsigned int &width, unsigned int &height, std::vector<unsigned char> &data);
 
 GLuint loadBMP(const char * imagepath);
+
+// Baked textures: the .gtex next to the source image (or the given cache path) is used when
+// it is newer than every source and stored in textureFormat, otherwise it is baked here first
+// and written back.
+extern GLenum textureFormat;
+
+#define TEXTURE_ARRAY_MAX_SIZE 1024
+
+// BMP expanded to RGBA8; rows bottom-up as stored, or flipped to top-down
+bool readBMPAsRGBA(const char * imagepath, bool topDown, unsigned int &width, unsigned int &height, std::vector<unsigned char> &rgba);
+
+std::string textureCachePath(const char * imagepath);
+bool bakeTexture(const char * imagepath, const char * cachePath, GLenum internalFormat);
+bool bakeCubemap(const std::vector<std::string> &faces, const char * cachePath, GLenum internalFormat);
+bool bakeTextureArray(const std::vector<std::string> &layers, const char * cachePath, GLenum internalFormat);
+
+// true when the container is newer than its sources, baked from the same file names and in
+// internalFormat; leaves it mapped in file
+bool isTextureContainerFresh(GLenum target, const std::vector<std::string> &sources, const char * cachePath, GLenum internalFormat, MappedFile &file);
+
+// source images decoded in parallel, no container involved
+GLuint loadCubemap(const std::vector<std::string> &faces);
+
+GLuint loadTexture(const char * imagepath);
+GLuint loadCubemapTexture(const std::vector<std::string> &faces, const char * cachePath);
+
+// GL_TEXTURE_2D_ARRAY with one layer per image, all resized to a common square size of at most
+// TEXTURE_ARRAY_MAX_SIZE; a NULL cachePath bakes in memory without touching the disk
+GLuint loadTextureArray(const std::vector<std::string> &layers, const char * cachePath);
+
+// bytes of every level of the texture as the driver reports them
+size_t textureVideoMemory(GLenum target, GLuint textureID);
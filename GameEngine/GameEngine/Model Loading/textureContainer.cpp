@@ -0,0 +1,463 @@
+#include "textureContainer.h"
+#include "..\Graphics\glState.h"
+#include "..\Graphics\glStats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+// sRGB <-> linear lookup tables, built on first use; mip chains are built from several jobs at once
+static float srgbToLinear[256];
+static unsigned char linearToSrgb[65536];
+static std::once_flag tablesBuilt;
+
+static void fillTables()
+{
+	for (int i = 0; i < 256; i++)
+	{
+		float c = i / 255.0f;
+		srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	for (int i = 0; i < 65536; i++)
+	{
+		float l = i / 65535.0f;
+		float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+		linearToSrgb[i] = (unsigned char)(c * 255.0f + 0.5f);
+	}
+}
+
+static void buildTables()
+{
+	std::call_once(tablesBuilt, fillTables);
+}
+
+void expandToRGBA(const unsigned char* src, unsigned int width, unsigned int height, unsigned int stride, bool bgr, std::vector<unsigned char>& rgba)
+{
+	rgba.resize(width * height * 4);
+
+	for (unsigned int y = 0; y < height; y++)
+	{
+		const unsigned char* row = src + y * stride;
+		unsigned char* out = &rgba[y * width * 4];
+		for (unsigned int x = 0; x < width; x++)
+		{
+			out[x * 4 + 0] = row[x * 3 + (bgr ? 2 : 0)];
+			out[x * 4 + 1] = row[x * 3 + 1];
+			out[x * 4 + 2] = row[x * 3 + (bgr ? 0 : 2)];
+			out[x * 4 + 3] = 255;
+		}
+	}
+}
+
+static int clampIndex(int i, int size)
+{
+	return i < 0 ? 0 : (i >= size ? size - 1 : i);
+}
+
+// halves one level with a separable [1 3 3 1] / 8 tent, colour in linear light
+static void downsample(const TextureMip& src, TextureMip& dst)
+{
+	static const float weights[4] = { 0.125f, 0.375f, 0.375f, 0.125f };
+
+	int sw = src.width;
+	int sh = src.height;
+	int dw = sw > 1 ? sw / 2 : 1;
+	int dh = sh > 1 ? sh / 2 : 1;
+
+	// a dimension that is already 1 is copied, not filtered
+	bool filterX = sw > 1;
+	bool filterY = sh > 1;
+
+	// horizontal pass into linear floats
+	std::vector<float> rows(sh * dw * 4);
+	for (int y = 0; y < sh; y++)
+	{
+		const unsigned char* in = &src.pixels[y * sw * 4];
+		float* out = &rows[y * dw * 4];
+		for (int x = 0; x < dw; x++)
+		{
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (int k = 0; k < 4; k++)
+			{
+				int sx = filterX ? clampIndex(2 * x - 1 + k, sw) : x;
+				const unsigned char* p = in + sx * 4;
+				float w = filterX ? weights[k] : 0.25f;
+				sum[0] += srgbToLinear[p[0]] * w;
+				sum[1] += srgbToLinear[p[1]] * w;
+				sum[2] += srgbToLinear[p[2]] * w;
+				sum[3] += p[3] / 255.0f * w;
+			}
+			out[x * 4 + 0] = sum[0];
+			out[x * 4 + 1] = sum[1];
+			out[x * 4 + 2] = sum[2];
+			out[x * 4 + 3] = sum[3];
+		}
+	}
+
+	// vertical pass back to sRGB bytes
+	dst.width = dw;
+	dst.height = dh;
+	dst.pixels.resize(dw * dh * 4);
+	for (int y = 0; y < dh; y++)
+	{
+		unsigned char* out = &dst.pixels[y * dw * 4];
+		for (int x = 0; x < dw; x++)
+		{
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (int k = 0; k < 4; k++)
+			{
+				int sy = filterY ? clampIndex(2 * y - 1 + k, sh) : y;
+				const float* p = &rows[(sy * dw + x) * 4];
+				float w = filterY ? weights[k] : 0.25f;
+				sum[0] += p[0] * w;
+				sum[1] += p[1] * w;
+				sum[2] += p[2] * w;
+				sum[3] += p[3] * w;
+			}
+			for (int c = 0; c < 3; c++)
+			{
+				float l = sum[c] < 0.0f ? 0.0f : (sum[c] > 1.0f ? 1.0f : sum[c]);
+				out[x * 4 + c] = linearToSrgb[(int)(l * 65535.0f + 0.5f)];
+			}
+			float a = sum[3] < 0.0f ? 0.0f : (sum[3] > 1.0f ? 1.0f : sum[3]);
+			out[x * 4 + 3] = (unsigned char)(a * 255.0f + 0.5f);
+		}
+	}
+}
+
+void resizeImage(const std::vector<unsigned char>& rgba, unsigned int width, unsigned int height, unsigned int newWidth, unsigned int newHeight, std::vector<unsigned char>& resized)
+{
+	buildTables();
+
+	resized.resize(newWidth * newHeight * 4);
+	for (unsigned int y = 0; y < newHeight; y++)
+	{
+		// sample positions at pixel centres, clamped to the edge texels
+		float sy = std::max(0.0f, (y + 0.5f) * height / newHeight - 0.5f);
+		unsigned int y0 = std::min((unsigned int)sy, height - 1);
+		unsigned int y1 = std::min(y0 + 1, height - 1);
+		float fy = sy - y0;
+
+		for (unsigned int x = 0; x < newWidth; x++)
+		{
+			float sx = std::max(0.0f, (x + 0.5f) * width / newWidth - 0.5f);
+			unsigned int x0 = std::min((unsigned int)sx, width - 1);
+			unsigned int x1 = std::min(x0 + 1, width - 1);
+			float fx = sx - x0;
+
+			const unsigned char* p00 = &rgba[(y0 * width + x0) * 4];
+			const unsigned char* p10 = &rgba[(y0 * width + x1) * 4];
+			const unsigned char* p01 = &rgba[(y1 * width + x0) * 4];
+			const unsigned char* p11 = &rgba[(y1 * width + x1) * 4];
+			unsigned char* out = &resized[(y * newWidth + x) * 4];
+
+			for (int c = 0; c < 3; c++)
+			{
+				float top = srgbToLinear[p00[c]] * (1.0f - fx) + srgbToLinear[p10[c]] * fx;
+				float bottom = srgbToLinear[p01[c]] * (1.0f - fx) + srgbToLinear[p11[c]] * fx;
+				float l = std::min(1.0f, std::max(0.0f, top * (1.0f - fy) + bottom * fy));
+				out[c] = linearToSrgb[(int)(l * 65535.0f + 0.5f)];
+			}
+			float top = p00[3] * (1.0f - fx) + p10[3] * fx;
+			float bottom = p01[3] * (1.0f - fx) + p11[3] * fx;
+			out[3] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+		}
+	}
+}
+
+void buildMipChain(const std::vector<unsigned char>& rgba, unsigned int width, unsigned int height, std::vector<TextureMip>& chain)
+{
+	buildTables();
+
+	chain.clear();
+	chain.push_back(TextureMip());
+	chain[0].width = width;
+	chain[0].height = height;
+	chain[0].pixels = rgba;
+
+	while ((chain.back().width > 1 || chain.back().height > 1) && chain.size() < TEXTURE_CONTAINER_MAX_LEVELS)
+	{
+		TextureMip next;
+		downsample(chain.back(), next);
+		chain.push_back(next);
+	}
+}
+
+void compressTexture(BakedTexture& texture, GLenum internalFormat)
+{
+	if (compressedBlockBytes(internalFormat) == 0)
+		return;
+
+	for (unsigned int face = 0; face < texture.faces.size(); face++)
+	{
+		for (unsigned int level = 0; level < texture.faces[face].size(); level++)
+		{
+			TextureMip& mip = texture.faces[face][level];
+			std::vector<unsigned char> blocks;
+			compressImage(internalFormat, &mip.pixels[0], mip.width, mip.height, blocks);
+			mip.pixels.swap(blocks);
+		}
+	}
+
+	texture.internalFormat = internalFormat;
+	texture.format = 0;
+	texture.type = 0;
+}
+
+GLenum parseTextureFormat(const char* name)
+{
+	std::string format = name;
+	if (format == "rgba8")
+		return GL_RGBA8;
+	if (format == "bc1")
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	if (format == "bc3")
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	if (format == "bc7")
+		return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	return 0;
+}
+
+const char* textureFormatName(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+		case GL_RGBA8:
+			return "rgba8";
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			return "bc1";
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			return "bc3";
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			return "bc7";
+		default:
+			return "unknown";
+	}
+}
+
+size_t textureContainerVideoMemory(const unsigned char* bytes)
+{
+	const TextureContainerHeader* header = (const TextureContainerHeader*)bytes;
+	size_t total = 0;
+	for (unsigned int level = 0; level < header->levelCount; level++)
+		total += (size_t)header->levels[level].size * header->faces;
+	return total;
+}
+
+size_t textureContainerRGB8Memory(const unsigned char* bytes)
+{
+	const TextureContainerHeader* header = (const TextureContainerHeader*)bytes;
+	size_t total = 0;
+	for (unsigned int level = 0; level < header->levelCount; level++)
+		total += (size_t)header->levels[level].width * header->levels[level].height * 3 * header->faces;
+	return total;
+}
+
+static bool isCompressedFormatSupported(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			return GLEW_EXT_texture_compression_s3tc != 0;
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+		default:
+			return false;
+	}
+}
+
+static unsigned int alignUp(unsigned int value)
+{
+	return (value + TEXTURE_CONTAINER_ALIGNMENT - 1) & ~(TEXTURE_CONTAINER_ALIGNMENT - 1);
+}
+
+void serializeTextureContainer(const BakedTexture& texture, std::vector<unsigned char>& bytes)
+{
+	TextureContainerHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = TEXTURE_CONTAINER_MAGIC;
+	header.version = TEXTURE_CONTAINER_VERSION;
+	header.width = texture.faces[0][0].width;
+	header.height = texture.faces[0][0].height;
+	header.faces = (unsigned int)texture.faces.size();
+	header.target = texture.target;
+	header.sourceHash = texture.sourceHash;
+	header.levelCount = (unsigned int)texture.faces[0].size();
+	header.internalFormat = texture.internalFormat;
+	header.format = texture.format;
+	header.type = texture.type;
+
+	unsigned int offset = alignUp(sizeof(TextureContainerHeader));
+	for (unsigned int level = 0; level < header.levelCount; level++)
+	{
+		const TextureMip& mip = texture.faces[0][level];
+		header.levels[level].offset = offset;
+		header.levels[level].size = (unsigned int)mip.pixels.size();
+		header.levels[level].width = mip.width;
+		header.levels[level].height = mip.height;
+		offset = alignUp(offset + header.levels[level].size * header.faces);
+	}
+
+	bytes.assign(offset, 0);
+	memcpy(&bytes[0], &header, sizeof(header));
+
+	for (unsigned int level = 0; level < header.levelCount; level++)
+	{
+		for (unsigned int face = 0; face < header.faces; face++)
+		{
+			const std::vector<unsigned char>& pixels = texture.faces[face][level].pixels;
+			memcpy(&bytes[header.levels[level].offset + face * header.levels[level].size], &pixels[0], pixels.size());
+		}
+	}
+}
+
+bool writeTextureContainer(const char* path, const std::vector<unsigned char>& bytes)
+{
+	FILE* file;
+	errno_t err = fopen_s(&file, path, "wb");
+	if (err)
+	{
+		std::cout << "Could not write texture container " << path << std::endl;
+		return false;
+	}
+
+	size_t written = fwrite(&bytes[0], 1, bytes.size(), file);
+	fclose(file);
+
+	return written == bytes.size();
+}
+
+bool validateTextureContainer(const unsigned char* bytes, size_t size)
+{
+	if (bytes == NULL || size < sizeof(TextureContainerHeader))
+		return false;
+
+	const TextureContainerHeader* header = (const TextureContainerHeader*)bytes;
+	if (header->magic != TEXTURE_CONTAINER_MAGIC || header->version != TEXTURE_CONTAINER_VERSION)
+		return false;
+	if (header->levelCount == 0 || header->levelCount > TEXTURE_CONTAINER_MAX_LEVELS)
+		return false;
+	if (header->target == GL_TEXTURE_2D && header->faces != 1)
+		return false;
+	if (header->target == GL_TEXTURE_CUBE_MAP && header->faces != 6)
+		return false;
+	if (header->target == GL_TEXTURE_2D_ARRAY && (header->faces == 0 || header->faces > TEXTURE_CONTAINER_MAX_LAYERS))
+		return false;
+	if (header->target != GL_TEXTURE_2D && header->target != GL_TEXTURE_CUBE_MAP && header->target != GL_TEXTURE_2D_ARRAY)
+		return false;
+
+	for (unsigned int level = 0; level < header->levelCount; level++)
+	{
+		const TextureContainerLevel& info = header->levels[level];
+		if ((size_t)info.offset + (size_t)info.size * header->faces > size)
+			return false;
+		if (header->format == 0 && info.size != compressedImageSize(header->internalFormat, info.width, info.height))
+			return false;
+	}
+	return true;
+}
+
+GLuint uploadTextureContainer(const unsigned char* bytes)
+{
+	const TextureContainerHeader* header = (const TextureContainerHeader*)bytes;
+	GLenum target = header->target;
+	bool layered = target == GL_TEXTURE_2D_ARRAY;
+	bool immutable = GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+	bool compressed = header->format == 0;
+	bool decode = compressed && !isCompressedFormatSupported(header->internalFormat);
+	GLenum internalFormat = decode ? GL_RGB8 : header->internalFormat;
+
+	if (decode)
+		printf("%s textures are not supported by the driver, decoding to RGB8\n", textureFormatName(header->internalFormat));
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	glState.bindTexture(GL_STATE_UPLOAD_UNIT, target, textureID);
+
+	if (immutable && layered)
+		glTexStorage3D(target, header->levelCount, internalFormat, header->width, header->height, header->faces);
+	else if (immutable)
+		glTexStorage2D(target, header->levelCount, internalFormat, header->width, header->height);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	std::vector<unsigned char> decoded;
+	for (unsigned int level = 0; level < header->levelCount; level++)
+	{
+		const TextureContainerLevel& info = header->levels[level];
+
+		// the layers of a level are contiguous, so an array level goes up in one call
+		if (layered)
+		{
+			const unsigned char* pixels = bytes + info.offset;
+			GLenum format = header->format;
+			GLenum type = header->type;
+
+			if (decode)
+			{
+				std::vector<unsigned char> layer;
+				decoded.resize((size_t)info.width * info.height * 4 * header->faces);
+				for (unsigned int i = 0; i < header->faces; i++)
+				{
+					decompressImage(header->internalFormat, pixels + i * info.size, info.width, info.height, layer);
+					memcpy(&decoded[(size_t)i * layer.size()], &layer[0], layer.size());
+				}
+				pixels = &decoded[0];
+				format = GL_RGBA;
+				type = GL_UNSIGNED_BYTE;
+			}
+			else if (compressed)
+			{
+				if (immutable)
+					glCompressedTexSubImage3D(target, level, 0, 0, 0, info.width, info.height, header->faces, internalFormat, info.size * header->faces, pixels);
+				else
+					glCompressedTexImage3D(target, level, internalFormat, info.width, info.height, header->faces, 0, info.size * header->faces, pixels);
+				continue;
+			}
+
+			if (immutable)
+				glTexSubImage3D(target, level, 0, 0, 0, info.width, info.height, header->faces, format, type, pixels);
+			else
+				glTexImage3D(target, level, internalFormat, info.width, info.height, header->faces, 0, format, type, pixels);
+			continue;
+		}
+
+		for (unsigned int face = 0; face < header->faces; face++)
+		{
+			GLenum faceTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+			const unsigned char* pixels = bytes + info.offset + face * info.size;
+			GLenum format = header->format;
+			GLenum type = header->type;
+
+			if (decode)
+			{
+				decompressImage(header->internalFormat, pixels, info.width, info.height, decoded);
+				pixels = &decoded[0];
+				format = GL_RGBA;
+				type = GL_UNSIGNED_BYTE;
+			}
+			else if (compressed)
+			{
+				if (immutable)
+					glCompressedTexSubImage2D(faceTarget, level, 0, 0, info.width, info.height, internalFormat, info.size, pixels);
+				else
+					glCompressedTexImage2D(faceTarget, level, internalFormat, info.width, info.height, 0, info.size, pixels);
+				continue;
+			}
+
+			if (immutable)
+				glTexSubImage2D(faceTarget, level, 0, 0, info.width, info.height, format, type, pixels);
+			else
+				glTexImage2D(faceTarget, level, internalFormat, info.width, info.height, 0, format, type, pixels);
+		}
+	}
+
+	glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, header->levelCount - 1);
+
+	return textureID;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <glew.h>
+#include <vector>
+#include "mappedFile.h"
+#include "blockCompression.h"
+
+// Baked texture container (.gtex): a small KTX-like layout holding every mip level of one
+// 2D texture, of the six faces of a cubemap or of every layer of a 2D array texture.
+//
+//   TextureContainerHeader
+//   level 0: face/layer 0 .. N-1, each levels[0].size bytes
+//   level 1: ...
+//
+// Level data starts on TEXTURE_CONTAINER_ALIGNMENT boundaries so it can be uploaded
+// straight out of a memory-mapped file. Levels are either raw RGBA8 or BC1/BC3/BC7 blocks,
+// in which case format and type are 0.
+
+#define TEXTURE_CONTAINER_MAGIC 0x58455447u	// "GTEX"
+#define TEXTURE_CONTAINER_VERSION 3
+#define TEXTURE_CONTAINER_MAX_LEVELS 16
+#define TEXTURE_CONTAINER_ALIGNMENT 16
+#define TEXTURE_CONTAINER_MAX_LAYERS 256
+
+struct TextureContainerLevel
+{
+	unsigned int offset;
+	unsigned int size;	// bytes per face
+	unsigned int width;
+	unsigned int height;
+};
+
+struct TextureContainerHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int width;
+	unsigned int height;
+	unsigned int faces;		// cubemap faces or array layers, 1 for a plain 2D texture
+	unsigned int levelCount;
+	unsigned int internalFormat;
+	unsigned int format;	// 0 for compressed formats
+	unsigned int type;		// 0 for compressed formats
+	unsigned int target;	// GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY
+	unsigned int sourceHash;	// hash of the source file names, in order
+	unsigned int reserved[3];
+	TextureContainerLevel levels[TEXTURE_CONTAINER_MAX_LEVELS];
+};
+
+// one level of one face while baking
+struct TextureMip
+{
+	unsigned int width;
+	unsigned int height;
+	std::vector<unsigned char> pixels;
+};
+
+struct BakedTexture
+{
+	unsigned int target;
+	unsigned int sourceHash;
+	unsigned int internalFormat;
+	unsigned int format;
+	unsigned int type;
+	// faces[face or layer][level]
+	std::vector<std::vector<TextureMip> > faces;
+};
+
+// expands 24-bit rows (any stride, RGB or BGR order) to tightly packed RGBA8
+void expandToRGBA(const unsigned char* src, unsigned int width, unsigned int height, unsigned int stride, bool bgr, std::vector<unsigned char>& rgba);
+
+// bilinear resample, used to bring array layers to a common size
+void resizeImage(const std::vector<unsigned char>& rgba, unsigned int width, unsigned int height, unsigned int newWidth, unsigned int newHeight, std::vector<unsigned char>& resized);
+
+// full mip chain down to 1x1, level 0 is the input; colour is filtered in linear light
+// with a [1 3 3 1] tent so the smaller levels keep the brightness of the original
+void buildMipChain(const std::vector<unsigned char>& rgba, unsigned int width, unsigned int height, std::vector<TextureMip>& chain);
+
+// re-encodes every level into a compressed internal format, GL_RGBA8 leaves it untouched
+void compressTexture(BakedTexture& texture, GLenum internalFormat);
+
+// "rgba8", "bc1", "bc3", "bc7" <-> internal format; 0 for unknown names
+GLenum parseTextureFormat(const char* name);
+const char* textureFormatName(GLenum internalFormat);
+
+// bytes the container occupies in VRAM, and what the same mip chain costs as RGB8
+size_t textureContainerVideoMemory(const unsigned char* bytes);
+size_t textureContainerRGB8Memory(const unsigned char* bytes);
+
+void serializeTextureContainer(const BakedTexture& texture, std::vector<unsigned char>& bytes);
+bool writeTextureContainer(const char* path, const std::vector<unsigned char>& bytes);
+bool validateTextureContainer(const unsigned char* bytes, size_t size);
+
+// needs a current GL context; uses immutable storage when available, never generates mips.
+// Compressed levels the driver cannot sample are decoded on the CPU and stored as RGB8.
+GLuint uploadTextureContainer(const unsigned char* bytes);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm.hpp>
+
+// Axis-aligned boxes are stored as the corner with the smallest coordinates (left, bottom, front)
+// plus the size along each axis, the same way Obiect keeps them.
+
+// overlap along each axis; touching faces do not count as a collision
+inline bool aabbOverlap(const glm::vec3 &posA, const glm::vec3 &sizeA, const glm::vec3 &posB, const glm::vec3 &sizeB)
+{
+	bool xOverlap = (posA.x < posB.x + sizeB.x) && (posB.x < posA.x + sizeA.x);
+	bool yOverlap = (posA.y < posB.y + sizeB.y) && (posB.y < posA.y + sizeA.y);
+	bool zOverlap = (posA.z < posB.z + sizeB.z) && (posB.z < posA.z + sizeA.z);
+
+	// collision if all three axes overlap
+	return xOverlap && yOverlap && zOverlap;
+}
+
+// box at least partly inside the six planes (normals pointing in, as in CameraRenderState::frustum):
+// it is outside if its corner furthest along a plane's normal is still behind that plane
+inline bool aabbInFrustum(const glm::vec4* frustum, const glm::vec3 &pos, const glm::vec3 &size)
+{
+	glm::vec3 boxMax = pos + size;
+	for (int p = 0; p < 6; p++)
+	{
+		glm::vec3 corner = glm::vec3(
+			frustum[p].x >= 0.0f ? boxMax.x : pos.x,
+			frustum[p].y >= 0.0f ? boxMax.y : pos.y,
+			frustum[p].z >= 0.0f ? boxMax.z : pos.z);
+		if (glm::dot(glm::vec3(frustum[p]), corner) + frustum[p].w < 0.0f)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,137 @@
+#include "collisionGrid.h"
+#include "collision.h"
+#include <algorithm>
+#include <cmath>
+
+CollisionGrid::CollisionGrid()
+{
+	this->cellSize = COLLISION_GRID_CELL_SIZE;
+	this->origin = glm::vec2(0.0f);
+	this->cellsX = 0;
+	this->cellsZ = 0;
+	this->queryStamp = 0;
+}
+
+// cells touched by the box, clamped to the grid; false if it lies entirely outside
+bool CollisionGrid::cellRange(const glm::vec3& position, const glm::vec3& size, int& x0, int& z0, int& x1, int& z1)
+{
+	x0 = (int)floor((position.x - origin.x) / cellSize);
+	z0 = (int)floor((position.z - origin.y) / cellSize);
+	x1 = (int)floor((position.x + size.x - origin.x) / cellSize);
+	z1 = (int)floor((position.z + size.z - origin.y) / cellSize);
+
+	if (x1 < 0 || z1 < 0 || x0 >= cellsX || z0 >= cellsZ)
+		return false;
+
+	x0 = std::max(x0, 0);
+	z0 = std::max(z0, 0);
+	x1 = std::min(x1, cellsX - 1);
+	z1 = std::min(z1, cellsZ - 1);
+	return true;
+}
+
+void CollisionGrid::build(const glm::vec3* positions, const glm::vec3* sizes, unsigned int count, float cellSize)
+{
+	this->cellSize = cellSize;
+	this->positions.assign(positions, positions + count);
+	this->sizes.assign(sizes, sizes + count);
+	visited.assign(count, 0);
+	queryStamp = 0;
+	cellStart.clear();
+	items.clear();
+	cellsX = cellsZ = 0;
+	if (count == 0)
+		return;
+
+	glm::vec2 lower(positions[0].x, positions[0].z);
+	glm::vec2 upper = lower;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		lower = glm::min(lower, glm::vec2(positions[i].x, positions[i].z));
+		upper = glm::max(upper, glm::vec2(positions[i].x + sizes[i].x, positions[i].z + sizes[i].z));
+	}
+	origin = lower;
+	cellsX = (int)floor((upper.x - lower.x) / cellSize) + 1;
+	cellsZ = (int)floor((upper.y - lower.y) / cellSize) + 1;
+
+	// count per cell, prefix sum, then fill: two passes over the boxes, no per-cell vectors
+	cellStart.assign(cellsX * cellsZ + 1, 0);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		int x0, z0, x1, z1;
+		cellRange(positions[i], sizes[i], x0, z0, x1, z1);
+		for (int z = z0; z <= z1; z++)
+			for (int x = x0; x <= x1; x++)
+				cellStart[z * cellsX + x + 1]++;
+	}
+	for (int c = 0; c < cellsX * cellsZ; c++)
+		cellStart[c + 1] += cellStart[c];
+
+	items.resize(cellStart[cellsX * cellsZ]);
+	std::vector<unsigned int> fill(cellStart.begin(), cellStart.end() - 1);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		int x0, z0, x1, z1;
+		cellRange(positions[i], sizes[i], x0, z0, x1, z1);
+		for (int z = z0; z <= z1; z++)
+			for (int x = x0; x <= x1; x++)
+				items[fill[z * cellsX + x]++] = i;
+	}
+}
+
+bool CollisionGrid::overlapsAny(const glm::vec3& position, const glm::vec3& size)
+{
+	int x0, z0, x1, z1;
+	if (!cellRange(position, size, x0, z0, x1, z1))
+		return false;
+
+	for (int z = z0; z <= z1; z++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			int cell = z * cellsX + x;
+			for (unsigned int i = cellStart[cell]; i < cellStart[cell + 1]; i++)
+			{
+				if (aabbOverlap(position, size, positions[items[i]], sizes[items[i]]))
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+void CollisionGrid::query(const glm::vec3& position, const glm::vec3& size, std::vector<unsigned int>& result)
+{
+	result.clear();
+	int x0, z0, x1, z1;
+	if (!cellRange(position, size, x0, z0, x1, z1))
+		return;
+
+	queryStamp++;
+	for (int z = z0; z <= z1; z++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			int cell = z * cellsX + x;
+			for (unsigned int i = cellStart[cell]; i < cellStart[cell + 1]; i++)
+			{
+				unsigned int box = items[i];
+				if (visited[box] == queryStamp)
+					continue;
+				visited[box] = queryStamp;
+				if (aabbOverlap(position, size, positions[box], sizes[box]))
+					result.push_back(box);
+			}
+		}
+	}
+}
+
+unsigned int CollisionGrid::getBoxCount()
+{
+	return (unsigned int)positions.size();
+}
+
+int CollisionGrid::getCellCount()
+{
+	return cellsX * cellsZ;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm.hpp>
+#include <vector>
+
+// cell edge used for the level; most labyrinth walls span two to four cells
+#define COLLISION_GRID_CELL_SIZE 16.0f
+
+// Uniform grid over the XZ plane holding the static boxes of a level (same corner + size
+// layout as collision.h). Every box is listed in each cell it touches, so a probe is only
+// tested against the boxes around it instead of all of them.
+class CollisionGrid
+{
+	private:
+		float cellSize;
+		glm::vec2 origin;
+		int cellsX;
+		int cellsZ;
+
+		// boxes of cell c are items[cellStart[c] .. cellStart[c + 1])
+		std::vector<unsigned int> cellStart;
+		std::vector<unsigned int> items;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> sizes;
+
+		// query() marks boxes it already returned, so boxes spanning several cells come out once
+		std::vector<unsigned int> visited;
+		unsigned int queryStamp;
+
+		bool cellRange(const glm::vec3& position, const glm::vec3& size, int& x0, int& z0, int& x1, int& z1);
+
+	public:
+		CollisionGrid();
+
+		void build(const glm::vec3* positions, const glm::vec3* sizes, unsigned int count, float cellSize);
+
+		// true if the box overlaps any box in the grid
+		bool overlapsAny(const glm::vec3& position, const glm::vec3& size);
+		// index (in build order) of every box the box overlaps
+		void query(const glm::vec3& position, const glm::vec3& size, std::vector<unsigned int>& result);
+
+		unsigned int getBoxCount();
+		int getCellCount();
+};
@@ -0,0 +1,226 @@
+#include "benchmark.h"
+#include "profiler.h"
+#include "..\Graphics\glStats.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+// driver strings go into the results as they are, so anything JSON treats specially is escaped
+static std::string escapeJson(const char* text)
+{
+	std::string escaped;
+	for (const char* c = text != NULL ? text : ""; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			escaped += '\\';
+			escaped += *c;
+		}
+		else if ((unsigned char)*c < 0x20)
+		{
+			char code[8];
+			snprintf(code, sizeof(code), "\\u%04x", (unsigned char)*c);
+			escaped += code;
+		}
+		else
+			escaped += *c;
+	}
+	return escaped;
+}
+
+FlythroughBenchmark::FlythroughBenchmark(float duration)
+{
+	this->duration = duration;
+	this->startTime = 0.0f;
+	this->started = false;
+	this->recording = false;
+	this->heapAllocations = 0;
+	this->allocatingFrames = 0;
+
+	// through the labyrinth corridors at walking height...
+	waypoints.push_back(glm::vec3(5.0f, 10.5f, 5.0f));
+	waypoints.push_back(glm::vec3(12.0f, 10.5f, 12.0f));
+	waypoints.push_back(glm::vec3(30.0f, 10.5f, 12.0f));
+	waypoints.push_back(glm::vec3(45.0f, 10.5f, 24.0f));
+	waypoints.push_back(glm::vec3(62.0f, 10.5f, 35.0f));
+	waypoints.push_back(glm::vec3(82.0f, 10.5f, 30.0f));
+	waypoints.push_back(glm::vec3(92.0f, 10.5f, 52.0f));
+	waypoints.push_back(glm::vec3(110.0f, 10.5f, 70.0f));
+	waypoints.push_back(glm::vec3(130.0f, 10.5f, 82.0f));
+	waypoints.push_back(glm::vec3(148.0f, 12.0f, 80.0f));
+
+	// ...then up the parkour pillars, landing on top of each one
+	waypoints.push_back(glm::vec3(159.8f, 17.5f, 78.8f));
+	waypoints.push_back(glm::vec3(169.8f, 22.5f, 83.7f));
+	waypoints.push_back(glm::vec3(165.5f, 27.5f, 96.0f));
+	waypoints.push_back(glm::vec3(176.0f, 32.5f, 108.9f));
+	waypoints.push_back(glm::vec3(188.0f, 32.5f, 108.9f));
+}
+
+// uniform Catmull-Rom through the waypoints, t in [0, 1]
+glm::vec3 FlythroughBenchmark::evaluate(float t)
+{
+	int segments = (int)waypoints.size() - 1;
+	float f = glm::clamp(t, 0.0f, 1.0f) * segments;
+	int i = std::min((int)f, segments - 1);
+	float u = f - i;
+
+	glm::vec3 p0 = waypoints[std::max(i - 1, 0)];
+	glm::vec3 p1 = waypoints[i];
+	glm::vec3 p2 = waypoints[i + 1];
+	glm::vec3 p3 = waypoints[std::min(i + 2, segments)];
+
+	float u2 = u * u;
+	float u3 = u2 * u;
+
+	return 0.5f * ((2.0f * p1) +
+		(-p0 + p2) * u +
+		(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u2 +
+		(-p0 + 3.0f * p1 - 3.0f * p2 + p3) * u3);
+}
+
+void FlythroughBenchmark::update(float time, glm::vec3& playerPos, float& playerAngle, Camera& camera, float distance, float height)
+{
+	if (!started)
+	{
+		startTime = time;
+		started = true;
+	}
+
+	float elapsed = time - startTime;
+	if (!recording && elapsed >= BENCHMARK_WARMUP_SECONDS)
+	{
+		recording = true;
+		profiler.resetTotals();
+		glStats.resetTotals();
+		frameTimes.reserve((size_t)(duration * BENCHMARK_RESERVED_FPS));
+	}
+
+	float t = elapsed / (BENCHMARK_WARMUP_SECONDS + duration);
+	playerPos = evaluate(t);
+
+	// look along the path, a little ahead of the player
+	glm::vec3 ahead = evaluate(t + 0.01f);
+	glm::vec3 forward = ahead - playerPos;
+	forward.y = 0.0f;
+	if (glm::length(forward) < 0.0001f)
+		forward = camera.getCameraViewDirection();
+	forward = glm::normalize(forward);
+
+	glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 cameraPos = playerPos - forward * distance + up * height;
+	glm::vec3 view = glm::normalize(playerPos - cameraPos);
+	glm::vec3 right = glm::normalize(glm::cross(view, up));
+
+	camera.setCameraPosition(cameraPos);
+	camera.setCameraViewDirection(view);
+	camera.setCameraRight(right);
+	camera.setCameraUp(glm::cross(right, view));
+
+	// the player model faces -Z at angle 0
+	playerAngle = atan2(-forward.x, -forward.z);
+}
+
+void FlythroughBenchmark::recordFrame(float frameMs, unsigned long long heapAllocations)
+{
+	if (!recording)
+		return;
+
+	frameTimes.push_back(frameMs);
+	this->heapAllocations += heapAllocations;
+	if (heapAllocations > 0)
+		allocatingFrames++;
+}
+
+bool FlythroughBenchmark::isFinished(float time)
+{
+	return started && time - startTime >= BENCHMARK_WARMUP_SECONDS + duration;
+}
+
+// nearest-rank percentile of an already sorted list
+static float percentile(const std::vector<float>& sorted, float p)
+{
+	if (sorted.empty())
+		return 0.0f;
+
+	int rank = (int)ceil(p / 100.0f * sorted.size());
+	return sorted[glm::clamp(rank - 1, 0, (int)sorted.size() - 1)];
+}
+
+bool FlythroughBenchmark::writeResults(const char* path, int width, int height)
+{
+	std::vector<float> sorted = frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0;
+	for (unsigned int i = 0; i < sorted.size(); i++)
+		total += sorted[i];
+
+	float average = sorted.empty() ? 0.0f : (float)(total / sorted.size());
+	float p50 = percentile(sorted, 50.0f);
+	float p95 = percentile(sorted, 95.0f);
+	float p99 = percentile(sorted, 99.0f);
+	float max = sorted.empty() ? 0.0f : sorted.back();
+	float fps = total > 0.0 ? (float)(sorted.size() * 1000.0 / total) : 0.0f;
+
+	std::cout << "Benchmark: " << sorted.size() << " frames, " << fps << " FPS avg" << std::endl;
+	std::cout << "  frame ms  avg " << average << "  p50 " << p50 << "  p95 " << p95 << "  p99 " << p99 << "  max " << max << std::endl;
+	std::cout << "  heap allocations " << heapAllocations << " in " << allocatingFrames << " frames" << std::endl;
+
+	FILE* file;
+	errno_t err = fopen_s(&file, path, "w");
+	if (err)
+	{
+		std::cout << "Could not open " << path << " for writing" << std::endl;
+		return false;
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"benchmark\": \"flythrough\",\n");
+	fprintf(file, "  \"build\": \"%s %s\",\n", __DATE__, __TIME__);
+	fprintf(file, "  \"renderer\": \"%s\",\n", escapeJson((const char*)glGetString(GL_RENDERER)).c_str());
+	fprintf(file, "  \"gl_version\": \"%s\",\n", escapeJson((const char*)glGetString(GL_VERSION)).c_str());
+	fprintf(file, "  \"resolution\": [%d, %d],\n", width, height);
+	fprintf(file, "  \"duration_s\": %.3f,\n", duration);
+	fprintf(file, "  \"frames\": %d,\n", (int)sorted.size());
+	fprintf(file, "  \"avg_fps\": %.2f,\n", fps);
+	fprintf(file, "  \"frame_ms\": { \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n", average, p50, p95, p99, max);
+	fprintf(file, "  \"heap\": { \"allocations\": %llu, \"allocating_frames\": %d, \"allocations_per_frame\": %.4f },\n", heapAllocations,
+		allocatingFrames, sorted.empty() ? 0.0 : (double)heapAllocations / sorted.size());
+
+	if (glStatsCompiledIn())
+	{
+		const GlFrameStats& gl = glStats.getTotals();
+		double frames = glStats.getTotalFrames() > 0 ? (double)glStats.getTotalFrames() : 1.0;
+		unsigned long long calls = 0, redundant = 0;
+		for (int i = 0; i < GL_STAT_CALL_COUNT; i++)
+		{
+			calls += gl.calls[i];
+			redundant += gl.redundant[i];
+		}
+		double draws = (gl.calls[GL_STAT_DRAW_ELEMENTS] + gl.calls[GL_STAT_DRAW_ARRAYS]) / frames;
+
+		fprintf(file, "  \"gl\": { \"calls_per_frame\": %.2f, \"draw_calls_per_frame\": %.2f, \"redundant_per_frame\": %.2f, \"bytes_uploaded_per_frame\": %.1f,\n", calls / frames,
+			draws, redundant / frames, gl.bytesUploaded / frames);
+		fprintf(file, "    \"per_call\": [");
+		for (int i = 0; i < GL_STAT_CALL_COUNT; i++)
+			fprintf(file, "%s\n      { \"name\": \"%s\", \"per_frame\": %.2f, \"redundant_per_frame\": %.2f }", i == 0 ? "" : ",", glStatCallName((GlStatCall)i),
+				gl.calls[i] / frames, gl.redundant[i] / frames);
+		fprintf(file, "\n    ]\n  },\n");
+		std::cout << "  GL calls/frame " << calls / frames << "  draws " << draws << "  redundant " << redundant / frames << std::endl;
+	}
+
+	std::vector<ProfileScopeStats> passes = profiler.getTotals();
+	fprintf(file, "  \"passes\": [");
+	for (unsigned int i = 0; i < passes.size(); i++)
+	{
+		fprintf(file, "%s\n    { \"name\": \"%s\", \"cpu_ms\": %.4f, \"gpu_ms\": %.4f }", i == 0 ? "" : ",", passes[i].name, passes[i].cpuMs, passes[i].gpuMs);
+		std::cout << "  " << passes[i].name << "  cpu " << passes[i].cpuMs << " ms  gpu " << passes[i].gpuMs << " ms" << std::endl;
+	}
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	std::cout << "Benchmark results written to " << path << std::endl;
+	return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glm.hpp>
+#include <vector>
+#include "..\Camera\camera.h"
+
+// frames skipped at the start so shader compilation and driver warm-up do not skew the results
+#define BENCHMARK_WARMUP_SECONDS 1.0f
+// frame times are reserved for this rate up front, so recording them does not allocate
+#define BENCHMARK_RESERVED_FPS 2000
+
+// Scripted flythrough used by --benchmark: moves the player and the camera along a fixed
+// Catmull-Rom spline through the labyrinth and over the parkour pillars, records every frame
+// time and writes the summary as JSON.
+class FlythroughBenchmark
+{
+	private:
+		float duration;
+		float startTime;
+		bool started;
+		bool recording;
+
+		std::vector<glm::vec3> waypoints;
+		std::vector<float> frameTimes;
+		// heap allocations made by the recorded frames
+		unsigned long long heapAllocations;
+		int allocatingFrames;
+
+		glm::vec3 evaluate(float t);
+
+	public:
+		// duration is the measured part, in seconds, not counting the warm-up
+		FlythroughBenchmark(float duration);
+
+		// time is glfwGetTime(); the first call starts the run
+		void update(float time, glm::vec3& playerPos, float& playerAngle, Camera& camera, float distance, float height);
+		void recordFrame(float frameMs, unsigned long long heapAllocations);
+		bool isFinished(float time);
+
+		bool writeResults(const char* path, int width, int height);
+};
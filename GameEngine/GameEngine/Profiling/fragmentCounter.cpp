@@ -0,0 +1,69 @@
+#include "fragmentCounter.h"
+
+FragmentCounter::FragmentCounter()
+{
+	this->slot = 0;
+	this->ready = false;
+	this->lastSamples = 0;
+	this->totalSamples = 0;
+	this->totalFrames = 0;
+
+	for (int i = 0; i <= FRAGMENT_COUNTER_LATENCY; i++)
+	{
+		queries[i] = 0;
+		issued[i] = false;
+	}
+}
+
+void FragmentCounter::init()
+{
+	glGenQueries(FRAGMENT_COUNTER_LATENCY + 1, queries);
+	ready = true;
+}
+
+void FragmentCounter::shutdown()
+{
+	if (!ready)
+		return;
+
+	glDeleteQueries(FRAGMENT_COUNTER_LATENCY + 1, queries);
+	ready = false;
+}
+
+void FragmentCounter::begin()
+{
+	if (!ready)
+		return;
+
+	// the query about to be reused is FRAGMENT_COUNTER_LATENCY frames old, so this should not stall
+	if (issued[slot])
+	{
+		GLuint64 samples = 0;
+		glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &samples);
+		lastSamples = samples;
+		totalSamples += samples;
+		totalFrames++;
+	}
+
+	glBeginQuery(GL_SAMPLES_PASSED, queries[slot]);
+}
+
+void FragmentCounter::end()
+{
+	if (!ready)
+		return;
+
+	glEndQuery(GL_SAMPLES_PASSED);
+	issued[slot] = true;
+	slot = (slot + 1) % (FRAGMENT_COUNTER_LATENCY + 1);
+}
+
+unsigned long long FragmentCounter::getLastSamples()
+{
+	return lastSamples;
+}
+
+double FragmentCounter::getAverageSamples()
+{
+	return totalFrames > 0 ? (double)totalSamples / totalFrames : 0.0;
+}
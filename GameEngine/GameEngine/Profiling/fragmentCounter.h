@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glew.h>
+
+// results are read back this many frames after the query was issued
+#define FRAGMENT_COUNTER_LATENCY 4
+
+// GL_SAMPLES_PASSED around one pass, read back a few frames late so it never stalls the
+// pipeline; one begin/end pair per frame
+class FragmentCounter
+{
+	private:
+		GLuint queries[FRAGMENT_COUNTER_LATENCY + 1];
+		bool issued[FRAGMENT_COUNTER_LATENCY + 1];
+		int slot;
+		bool ready;
+
+		unsigned long long lastSamples;
+		unsigned long long totalSamples;
+		unsigned int totalFrames;
+
+	public:
+		FragmentCounter();
+
+		void init();
+		void shutdown();
+
+		void begin();
+		void end();
+
+		// samples of the newest resolved frame, and the average over every resolved frame
+		unsigned long long getLastSamples();
+		double getAverageSamples();
+};
@@ -0,0 +1,586 @@
+#include "profiler.h"
+#include "..\Graphics\glStats.h"
+#include "..\imgui\imgui.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#define NO_FRAME (~0ULL)
+
+Profiler profiler;
+
+Profiler::Profiler()
+{
+	this->epoch = std::chrono::high_resolution_clock::now();
+	this->frameIndex = 0;
+	this->frameOpen = false;
+	this->paused = false;
+	this->scopeDepth = 0;
+	this->gpuScopeOpen = false;
+	this->gpuReady = false;
+	this->gpuFrameIndex = 0;
+	this->gpuFrameOpen = false;
+	this->totalCpuFrames = 0;
+	this->totalGpuFrames = 0;
+
+	for (int i = 0; i < PROFILER_FRAME_HISTORY; i++)
+	{
+		frames[i].index = NO_FRAME;
+		frames[i].start = 0.0;
+		frames[i].duration = 0.0;
+		frames[i].gpuResolved = false;
+		frameTimes[i] = 0.0f;
+	}
+
+	for (int i = 0; i <= PROFILER_GPU_LATENCY; i++)
+	{
+		gpuQueryCount[i] = 0;
+		gpuQueryFrame[i] = 0;
+	}
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::init()
+{
+	// timer queries are core since GL 3.3
+	if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query)
+	{
+		std::cout << "Timer queries not supported, GPU profiling disabled" << std::endl;
+		return;
+	}
+
+	for (int i = 0; i <= PROFILER_GPU_LATENCY; i++)
+	{
+		glGenQueries(PROFILER_MAX_GPU_SCOPES, gpuQueries[i]);
+	}
+	gpuReady = true;
+}
+
+void Profiler::shutdown()
+{
+	if (!gpuReady)
+		return;
+
+	for (int i = 0; i <= PROFILER_GPU_LATENCY; i++)
+	{
+		glDeleteQueries(PROFILER_MAX_GPU_SCOPES, gpuQueries[i]);
+	}
+	gpuReady = false;
+}
+
+double Profiler::now()
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - epoch).count();
+}
+
+ProfileFrame& Profiler::currentFrame()
+{
+	return frames[frameIndex % PROFILER_FRAME_HISTORY];
+}
+
+ProfileFrame* Profiler::findFrame(unsigned long long index)
+{
+	ProfileFrame& frame = frames[index % PROFILER_FRAME_HISTORY];
+	if (frame.index != index)
+		return NULL;
+	return &frame;
+}
+
+// copy finished GL_TIME_ELAPSED results into the frame that issued them
+void Profiler::resolveGpuQueries(int slot, bool wait)
+{
+	int count = gpuQueryCount[slot];
+	if (count == 0)
+		return;
+
+	if (!wait)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(gpuQueries[slot][count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return;
+	}
+
+	ProfileFrame* frame = findFrame(gpuQueryFrame[slot]);
+	for (int i = 0; i < count; i++)
+	{
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(gpuQueries[slot][i], GL_QUERY_RESULT, &elapsed);
+		if (frame != NULL && i < (int)frame->gpuEvents.size())
+			frame->gpuEvents[i].duration = elapsed / 1000.0;
+	}
+	if (frame != NULL)
+	{
+		frame->gpuResolved = true;
+		accumulate(frame->gpuEvents, true);
+	}
+
+	gpuQueryCount[slot] = 0;
+}
+
+void Profiler::beginFrame()
+{
+	if (paused)
+		return;
+
+	frameIndex++;
+
+	ProfileFrame& frame = currentFrame();
+	frame.index = frameIndex;
+	frame.start = now();
+	frame.duration = 0.0;
+	frame.cpuEvents.clear();
+	frame.gpuEvents.clear();
+	frame.gpuResolved = !gpuReady;
+
+	scopeDepth = 0;
+	frameOpen = true;
+}
+
+void Profiler::endFrame()
+{
+	if (!frameOpen)
+		return;
+
+	// close scopes left open by an early return
+	while (scopeDepth > 0)
+		endCpuScope();
+
+	ProfileFrame& frame = currentFrame();
+	frame.duration = now() - frame.start;
+	frameTimes[frameIndex % PROFILER_FRAME_HISTORY] = (float)(frame.duration / 1000.0);
+	accumulate(frame.cpuEvents, false);
+
+	frameOpen = false;
+}
+
+void Profiler::beginCpuScope(const char* name)
+{
+	if (!frameOpen || scopeDepth >= PROFILER_MAX_DEPTH)
+		return;
+
+	ProfileFrame& frame = currentFrame();
+
+	ProfileEvent event;
+	event.name = name;
+	event.depth = scopeDepth;
+	event.start = now();
+	event.duration = 0.0;
+	frame.cpuEvents.push_back(event);
+
+	scopeStack[scopeDepth++] = (int)frame.cpuEvents.size() - 1;
+}
+
+void Profiler::endCpuScope()
+{
+	if (!frameOpen || scopeDepth == 0)
+		return;
+
+	ProfileEvent& event = currentFrame().cpuEvents[scopeStack[--scopeDepth]];
+	event.duration = now() - event.start;
+}
+
+void Profiler::beginGpuFrame(unsigned long long index)
+{
+	if (!gpuReady)
+		return;
+
+	// a scope left open by the previous frame's commands
+	if (gpuScopeOpen)
+		endGpuScope();
+
+	// the main thread may have paused since it recorded this frame, then nothing is measured
+	gpuFrameOpen = !paused && findFrame(index) != NULL;
+	if (!gpuFrameOpen)
+		return;
+
+	// the slot we are about to reuse is PROFILER_GPU_LATENCY + 1 frames old, so this should not stall
+	int slot = index % (PROFILER_GPU_LATENCY + 1);
+	resolveGpuQueries(slot, true);
+	gpuQueryFrame[slot] = index;
+	gpuFrameIndex = index;
+
+	// pick up anything else that already finished
+	for (int i = 0; i <= PROFILER_GPU_LATENCY; i++)
+	{
+		if (i != slot)
+			resolveGpuQueries(i, false);
+	}
+}
+
+void Profiler::beginGpuScope(const char* name)
+{
+	if (!gpuFrameOpen || !gpuReady || gpuScopeOpen)
+		return;
+
+	int slot = gpuFrameIndex % (PROFILER_GPU_LATENCY + 1);
+	if (gpuQueryCount[slot] >= PROFILER_MAX_GPU_SCOPES)
+		return;
+
+	ProfileEvent event;
+	event.name = name;
+	event.depth = 0;
+	event.start = now();
+	event.duration = 0.0;
+	frames[gpuFrameIndex % PROFILER_FRAME_HISTORY].gpuEvents.push_back(event);
+
+	glBeginQuery(GL_TIME_ELAPSED, gpuQueries[slot][gpuQueryCount[slot]++]);
+	gpuScopeOpen = true;
+}
+
+void Profiler::endGpuScope()
+{
+	if (!gpuScopeOpen)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	gpuScopeOpen = false;
+}
+
+void Profiler::setPaused(bool paused)
+{
+	if (frameOpen && paused)
+		endFrame();
+	this->paused = paused;
+}
+
+bool Profiler::isPaused()
+{
+	return paused;
+}
+
+unsigned long long Profiler::getFrameIndex()
+{
+	return frameIndex;
+}
+
+FrameVector<ProfileScopeStats> Profiler::getScopeStats()
+{
+	FrameVector<ProfileScopeStats> stats;
+	stats.reserve(PROFILER_MAX_GPU_SCOPES * 2);
+	int cpuFrames = 0;
+	int gpuFrames = 0;
+
+	for (int i = 0; i < PROFILER_FRAME_HISTORY; i++)
+	{
+		ProfileFrame& frame = frames[i];
+		// skip empty slots and the frame still being recorded
+		if (frame.index == NO_FRAME || (frameOpen && frame.index == frameIndex))
+			continue;
+
+		cpuFrames++;
+		if (frame.gpuResolved)
+			gpuFrames++;
+
+		for (int pass = 0; pass < 2; pass++)
+		{
+			std::vector<ProfileEvent>& events = pass == 0 ? frame.cpuEvents : frame.gpuEvents;
+			if (pass == 1 && !frame.gpuResolved)
+				continue;
+
+			for (unsigned int e = 0; e < events.size(); e++)
+			{
+				unsigned int s = 0;
+				while (s < stats.size() && strcmp(stats[s].name, events[e].name) != 0)
+					s++;
+				if (s == stats.size())
+				{
+					ProfileScopeStats entry = { events[e].name, 0.0, 0.0 };
+					stats.push_back(entry);
+				}
+
+				if (pass == 0)
+					stats[s].cpuMs += events[e].duration / 1000.0;
+				else
+					stats[s].gpuMs += events[e].duration / 1000.0;
+			}
+		}
+	}
+
+	for (unsigned int s = 0; s < stats.size(); s++)
+	{
+		if (cpuFrames > 0) stats[s].cpuMs /= cpuFrames;
+		if (gpuFrames > 0) stats[s].gpuMs /= gpuFrames;
+	}
+
+	return stats;
+}
+
+float Profiler::getAverageFrameMs()
+{
+	float total = 0.0f;
+	int count = 0;
+	for (int i = 0; i < PROFILER_FRAME_HISTORY; i++)
+	{
+		if (frameTimes[i] > 0.0f)
+		{
+			total += frameTimes[i];
+			count++;
+		}
+	}
+	return count > 0 ? total / count : 0.0f;
+}
+
+const float* Profiler::getFrameTimes(int& count, int& offset)
+{
+	count = PROFILER_FRAME_HISTORY;
+	offset = (frameIndex + 1) % PROFILER_FRAME_HISTORY;
+	return frameTimes;
+}
+
+void Profiler::accumulate(const std::vector<ProfileEvent>& events, bool gpu)
+{
+	std::lock_guard<std::mutex> lock(totalsMutex);
+	if (gpu)
+		totalGpuFrames++;
+	else
+		totalCpuFrames++;
+
+	for (unsigned int e = 0; e < events.size(); e++)
+	{
+		unsigned int s = 0;
+		while (s < totals.size() && strcmp(totals[s].name, events[e].name) != 0)
+			s++;
+		if (s == totals.size())
+		{
+			ProfileScopeStats entry = { events[e].name, 0.0, 0.0 };
+			totals.push_back(entry);
+		}
+
+		if (gpu)
+			totals[s].gpuMs += events[e].duration / 1000.0;
+		else
+			totals[s].cpuMs += events[e].duration / 1000.0;
+	}
+}
+
+void Profiler::resetTotals()
+{
+	std::lock_guard<std::mutex> lock(totalsMutex);
+	totals.clear();
+	totalCpuFrames = 0;
+	totalGpuFrames = 0;
+}
+
+std::vector<ProfileScopeStats> Profiler::getTotals()
+{
+	std::lock_guard<std::mutex> lock(totalsMutex);
+	std::vector<ProfileScopeStats> stats = totals;
+	for (unsigned int s = 0; s < stats.size(); s++)
+	{
+		if (totalCpuFrames > 0) stats[s].cpuMs /= totalCpuFrames;
+		if (totalGpuFrames > 0) stats[s].gpuMs /= totalGpuFrames;
+	}
+	return stats;
+}
+
+static ImU32 colorForName(const char* name)
+{
+	unsigned int hash = 2166136261u;
+	for (const char* c = name; *c; c++)
+		hash = (hash ^ (unsigned char)*c) * 16777619u;
+
+	return IM_COL32(90 + hash % 140, 90 + (hash >> 8) % 140, 90 + (hash >> 16) % 140, 255);
+}
+
+// one row per nesting level, scaled to the frame duration
+void Profiler::drawFlameGraph(const ProfileFrame& frame)
+{
+	const float rowHeight = 18.0f;
+	float width = ImGui::GetContentRegionAvail().x;
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+	int maxDepth = 0;
+	for (unsigned int i = 0; i < frame.cpuEvents.size(); i++)
+	{
+		if (frame.cpuEvents[i].depth > maxDepth)
+			maxDepth = frame.cpuEvents[i].depth;
+	}
+
+	// GPU passes get their own row under the CPU rows
+	int gpuRow = maxDepth + 1;
+	float scale = frame.duration > 0.0 ? width / (float)frame.duration : 0.0f;
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		const std::vector<ProfileEvent>& events = pass == 0 ? frame.cpuEvents : frame.gpuEvents;
+		if (pass == 1 && !frame.gpuResolved)
+			continue;
+
+		for (unsigned int i = 0; i < events.size(); i++)
+		{
+			const ProfileEvent& event = events[i];
+			int row = pass == 0 ? event.depth : gpuRow;
+
+			ImVec2 min(origin.x + (float)(event.start - frame.start) * scale, origin.y + row * rowHeight);
+			ImVec2 max(min.x + (float)event.duration * scale, min.y + rowHeight - 1.0f);
+			if (max.x - min.x < 1.0f)
+				max.x = min.x + 1.0f;
+
+			drawList->AddRectFilled(min, max, colorForName(event.name));
+			drawList->PushClipRect(min, max, true);
+			drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(0, 0, 0, 255), event.name);
+			drawList->PopClipRect();
+
+			if (ImGui::IsMouseHoveringRect(min, max))
+				ImGui::SetTooltip("%s %s: %.3f ms", pass == 0 ? "CPU" : "GPU", event.name, event.duration / 1000.0);
+		}
+	}
+
+	ImGui::Dummy(ImVec2(width, (gpuRow + 1) * rowHeight));
+}
+
+void Profiler::drawGlStats()
+{
+	if (!ImGui::CollapsingHeader("GL calls"))
+		return;
+
+	if (!glStatsCompiledIn())
+	{
+		ImGui::TextUnformatted("GL stats compiled out (define ENGINE_GL_STATS)");
+		return;
+	}
+
+	const GlFrameStats& last = glStats.getLastFrame();
+	ImGui::Text("%llu calls, %.1f KB uploaded last frame", glStats.getLastFrameCalls(), last.bytesUploaded / 1024.0);
+	ImGui::Columns(3, "glcalls");
+	ImGui::Text("call"); ImGui::NextColumn();
+	ImGui::Text("count"); ImGui::NextColumn();
+	ImGui::Text("redundant"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (int i = 0; i < GL_STAT_CALL_COUNT; i++)
+	{
+		ImGui::TextUnformatted(glStatCallName((GlStatCall)i)); ImGui::NextColumn();
+		ImGui::Text("%llu", last.calls[i]); ImGui::NextColumn();
+		if (last.redundant[i] > 0)
+			ImGui::Text("%llu", last.redundant[i]);
+		ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+	ImGui::Separator();
+}
+
+void Profiler::drawOverlay()
+{
+	static char status[128] = "";
+
+	ImGui::Begin("Profiler");
+
+	float averageMs = getAverageFrameMs();
+	ImGui::Text("%.1f FPS  |  %.3f ms/frame", averageMs > 0.0f ? 1000.0f / averageMs : 0.0f, averageMs);
+
+	bool pause = paused;
+	if (ImGui::Checkbox("Pause", &pause))
+		setPaused(pause);
+
+	ImGui::SameLine();
+	if (ImGui::Button("Save Chrome trace"))
+	{
+		if (writeChromeTrace("profile_trace.json"))
+			snprintf(status, sizeof(status), "Wrote profile_trace.json");
+		else
+			snprintf(status, sizeof(status), "Could not write profile_trace.json");
+	}
+	if (status[0])
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted(status);
+	}
+
+	int count, offset;
+	const float* times = getFrameTimes(count, offset);
+	ImGui::PlotHistogram("##frametimes", times, count, offset, "frame time (ms)", 0.0f, averageMs * 2.5f + 1.0f, ImVec2(ImGui::GetContentRegionAvail().x, 60.0f));
+
+	FrameVector<ProfileScopeStats> stats = getScopeStats();
+	ImGui::Columns(3, "scopes");
+	ImGui::Text("scope"); ImGui::NextColumn();
+	ImGui::Text("CPU ms"); ImGui::NextColumn();
+	ImGui::Text("GPU ms"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (unsigned int i = 0; i < stats.size(); i++)
+	{
+		ImGui::TextUnformatted(stats[i].name); ImGui::NextColumn();
+		ImGui::Text("%.3f", stats[i].cpuMs); ImGui::NextColumn();
+		ImGui::Text("%.3f", stats[i].gpuMs); ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+	ImGui::Separator();
+
+	drawGlStats();
+
+	// most recent frame whose GPU timings are back, or the previous frame if there are none
+	const ProfileFrame* shown = NULL;
+	for (int back = 1; back < PROFILER_FRAME_HISTORY && shown == NULL; back++)
+	{
+		if (frameIndex < (unsigned long long)back)
+			break;
+		const ProfileFrame* frame = findFrame(frameIndex - back);
+		if (frame != NULL && frame->gpuResolved)
+			shown = frame;
+	}
+	if (shown == NULL && frameIndex > 0)
+		shown = findFrame(frameIndex - 1);
+
+	if (shown != NULL)
+	{
+		ImGui::Text("frame %llu", shown->index);
+		drawFlameGraph(*shown);
+	}
+
+	ImGui::End();
+}
+
+static void writeTraceEvent(FILE* file, bool& first, const char* name, int tid, double start, double duration)
+{
+	fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",", name, tid, start, duration);
+	first = false;
+}
+
+// Chrome trace_event format, open with chrome://tracing or ui.perfetto.dev
+bool Profiler::writeChromeTrace(const char* path)
+{
+	FILE* file;
+	errno_t err = fopen_s(&file, path, "w");
+	if (err)
+	{
+		std::cout << "Could not open " << path << " for writing" << std::endl;
+		return false;
+	}
+
+	bool first = true;
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	fprintf(file, "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},");
+	fprintf(file, "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+	first = false;
+
+	// oldest frame first
+	for (int i = PROFILER_FRAME_HISTORY - 1; i >= 0; i--)
+	{
+		if (frameIndex < (unsigned long long)i)
+			continue;
+
+		ProfileFrame* frame = findFrame(frameIndex - i);
+		if (frame == NULL || frame->duration <= 0.0)
+			continue;
+
+		writeTraceEvent(file, first, "frame", 1, frame->start, frame->duration);
+		for (unsigned int e = 0; e < frame->cpuEvents.size(); e++)
+			writeTraceEvent(file, first, frame->cpuEvents[e].name, 1, frame->cpuEvents[e].start, frame->cpuEvents[e].duration);
+
+		if (frame->gpuResolved)
+		{
+			for (unsigned int e = 0; e < frame->gpuEvents.size(); e++)
+				writeTraceEvent(file, first, frame->gpuEvents[e].name, 2, frame->gpuEvents[e].start, frame->gpuEvents[e].duration);
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	std::cout << "Wrote Chrome trace to " << path << std::endl;
+	return true;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <glew.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "..\Memory\frameArena.h"
+
+// frames kept for the overlay graphs and the trace export
+#define PROFILER_FRAME_HISTORY 240
+// GPU timer queries are read back this many frames after they were issued
+#define PROFILER_GPU_LATENCY 4
+#define PROFILER_MAX_GPU_SCOPES 16
+#define PROFILER_MAX_DEPTH 16
+
+// one timed region; times are in microseconds since the profiler was created
+struct ProfileEvent
+{
+	const char* name;
+	int depth;
+	double start;
+	double duration;
+};
+
+struct ProfileFrame
+{
+	unsigned long long index;
+	double start;
+	double duration;
+	std::vector<ProfileEvent> cpuEvents;
+	// GPU events use the CPU submit time as start, duration comes from GL_TIME_ELAPSED
+	std::vector<ProfileEvent> gpuEvents;
+	bool gpuResolved;
+};
+
+// average cost of one named scope over the frame history
+struct ProfileScopeStats
+{
+	const char* name;
+	double cpuMs;
+	double gpuMs;
+};
+
+class Profiler
+{
+	private:
+		std::chrono::high_resolution_clock::time_point epoch;
+
+		ProfileFrame frames[PROFILER_FRAME_HISTORY];
+		unsigned long long frameIndex;
+		bool frameOpen;
+		bool paused;
+
+		// open CPU scopes: index into the current frame's cpuEvents
+		int scopeStack[PROFILER_MAX_DEPTH];
+		int scopeDepth;
+
+		// GL_TIME_ELAPSED queries, one set per in-flight frame
+		// (these queries cannot nest, so GPU scopes must not overlap)
+		GLuint gpuQueries[PROFILER_GPU_LATENCY + 1][PROFILER_MAX_GPU_SCOPES];
+		int gpuQueryCount[PROFILER_GPU_LATENCY + 1];
+		unsigned long long gpuQueryFrame[PROFILER_GPU_LATENCY + 1];
+		bool gpuScopeOpen;
+		bool gpuReady;
+		// the frame whose commands are being replayed, which can be behind frameIndex
+		unsigned long long gpuFrameIndex;
+		bool gpuFrameOpen;
+
+		float frameTimes[PROFILER_FRAME_HISTORY];
+
+		// running totals since resetTotals(), for runs longer than the history
+		// GPU results are added on the thread that replays the frames, hence the lock
+		std::vector<ProfileScopeStats> totals;
+		int totalCpuFrames;
+		int totalGpuFrames;
+		std::mutex totalsMutex;
+
+		ProfileFrame& currentFrame();
+		ProfileFrame* findFrame(unsigned long long index);
+		void resolveGpuQueries(int slot, bool wait);
+		void drawFlameGraph(const ProfileFrame& frame);
+		void drawGlStats();
+		void accumulate(const std::vector<ProfileEvent>& events, bool gpu);
+
+	public:
+		Profiler();
+		~Profiler();
+
+		// GL queries need a current context, so they are created separately
+		void init();
+		void shutdown();
+
+		void beginFrame();
+		void endFrame();
+
+		void beginCpuScope(const char* name);
+		void endCpuScope();
+		// the GPU side runs where the GL commands are issued, the render thread when there is one:
+		// beginGpuFrame reads back old queries and starts on the given frame (see getFrameIndex)
+		void beginGpuFrame(unsigned long long index);
+		void beginGpuScope(const char* name);
+		void endGpuScope();
+		unsigned long long getFrameIndex();
+
+		double now();
+		void setPaused(bool paused);
+		bool isPaused();
+
+		// averages over the frames currently in the history, valid until the frame after next
+		FrameVector<ProfileScopeStats> getScopeStats();
+		float getAverageFrameMs();
+		const float* getFrameTimes(int& count, int& offset);
+
+		// per-frame averages over every frame since the last reset
+		void resetTotals();
+		std::vector<ProfileScopeStats> getTotals();
+
+		void drawOverlay();
+		bool writeChromeTrace(const char* path);
+};
+
+extern Profiler profiler;
+
+class ProfileScope
+{
+	public:
+		ProfileScope(const char* name) { profiler.beginCpuScope(name); }
+		~ProfileScope() { profiler.endCpuScope(); }
+};
+
+class GpuProfileScope
+{
+	public:
+		GpuProfileScope(const char* name) { profiler.beginGpuScope(name); }
+		~GpuProfileScope() { profiler.endGpuScope(); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
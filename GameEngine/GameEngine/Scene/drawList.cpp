@@ -0,0 +1,113 @@
+#include "drawList.h"
+#include "..\Physics\collision.h"
+#include "..\Threading\jobSystem.h"
+#include <algorithm>
+#include <cstring>
+
+static bool keyLess(const DrawItem& a, const DrawItem& b)
+{
+	return a.key < b.key;
+}
+
+// squared distances are non-negative floats, whose bits sort the same way as their values
+static unsigned int depthBits(float distanceSquared)
+{
+	unsigned int bits;
+	memcpy(&bits, &distanceSquared, sizeof(bits));
+	return bits >> 8;
+}
+
+DrawListBuilder::DrawListBuilder()
+{
+	this->chunkCount = 0;
+}
+
+unsigned int DrawListBuilder::build(EntityStore& store, const glm::vec4* frustum, const glm::vec3& viewPos, EntityId exclude, DrawItem* out)
+{
+	unsigned int count = store.getCount();
+	chunkCount = std::max(1u, std::min((unsigned int)DRAW_LIST_MAX_CHUNKS, count / DRAW_LIST_MIN_CHUNK));
+	if (scratch.size() < count)
+		scratch.resize(count);
+	runs.resize(chunkCount);
+
+	const glm::vec3* positions = store.getPositions();
+	const glm::vec3* sizes = store.getSizes();
+	const int* renderHandles = store.getRenderHandles();
+	const unsigned int* materials = store.getMaterials();
+	unsigned int excludeSlot = store.isAlive(exclude) ? store.slotOf(exclude) : 0xFFFFFFFFu;
+	DrawItem* items = scratch.empty() ? NULL : &scratch[0];
+
+	// every chunk culls into its own slice of the scratch list and sorts it there
+	jobSystem.parallelFor(chunkCount, 1, [&](unsigned int firstChunk, unsigned int lastChunk) {
+		for (unsigned int c = firstChunk; c < lastChunk; c++)
+		{
+			unsigned int first = (unsigned int)((unsigned long long)count * c / chunkCount);
+			unsigned int last = (unsigned int)((unsigned long long)count * (c + 1) / chunkCount);
+			unsigned int written = first;
+			for (unsigned int i = first; i < last; i++)
+			{
+				if (renderHandles[i] == NO_RENDER_HANDLE || i == excludeSlot || !aabbInFrustum(frustum, positions[i], sizes[i]))
+					continue;
+
+				glm::vec3 offset = positions[i] + sizes[i] * 0.5f - viewPos;
+				DrawItem& item = items[written++];
+				item.key = ((unsigned long long)std::min(materials[i], 255u) << 56) | ((unsigned long long)depthBits(glm::dot(offset, offset)) << 32) | i;
+				item.entity = store.entityAt(i);
+				item.renderHandle = renderHandles[i];
+			}
+			std::sort(items + first, items + written, keyLess);
+			runs[c].first = first;
+			runs[c].count = written - first;
+		}
+	});
+
+	// the runs have gaps between them; every merge writes its result where it starts in the
+	// final list, so from the first level on the runs are packed from 0
+	unsigned int total = 0;
+	for (unsigned int c = 0; c < chunkCount; c++)
+		total += runs[c].count;
+
+	DrawItem* source = items;
+	DrawItem* target = out;
+	do
+	{
+		unsigned int pairs = ((unsigned int)runs.size() + 1) / 2;
+		merged.resize(pairs);
+		unsigned int start = 0;
+		for (unsigned int p = 0; p < pairs; p++)
+		{
+			merged[p].first = start;
+			merged[p].count = runs[p * 2].count + (p * 2 + 1 < runs.size() ? runs[p * 2 + 1].count : 0);
+			start += merged[p].count;
+		}
+
+		// the last levels have few merges left, they run on fewer threads
+		jobSystem.parallelFor(pairs, 1, [&](unsigned int firstPair, unsigned int lastPair) {
+			for (unsigned int p = firstPair; p < lastPair; p++)
+			{
+				const Run& a = runs[p * 2];
+				DrawItem* to = target + merged[p].first;
+				if (p * 2 + 1 < runs.size())
+				{
+					const Run& b = runs[p * 2 + 1];
+					std::merge(source + a.first, source + a.first + a.count, source + b.first, source + b.first + b.count, to, keyLess);
+				}
+				else
+					std::copy(source + a.first, source + a.first + a.count, to);
+			}
+		});
+
+		runs.swap(merged);
+		std::swap(source, target);
+	} while (runs.size() > 1);
+
+	// an even number of levels left the list in the scratch buffer
+	if (source != out)
+		std::copy(source, source + total, out);
+	return total;
+}
+
+unsigned int DrawListBuilder::getChunkCount()
+{
+	return chunkCount;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm.hpp>
+#include <vector>
+#include "entityStore.h"
+
+// entities per chunk at the least, below that a job costs more than the culling it saves
+#define DRAW_LIST_MIN_CHUNK 2048
+// most chunks a build is cut into; the merge does one pass over the list per doubling
+#define DRAW_LIST_MAX_CHUNKS 64
+
+// one object to draw; the list is sorted by key
+struct DrawItem
+{
+	// material in the top 8 bits, then the distance to the camera in 24, then the slot, so
+	// the draws are grouped by material, front to back within one, and no two keys are equal
+	unsigned long long key;
+	EntityId entity;
+	int renderHandle;
+};
+
+// Builds the frame's draw list out of the entity streams: frustum culling, sort keys and the
+// sort itself. The entities are cut into fixed chunks, each culled and sorted by a job into
+// its own part of the scratch list, and the sorted chunks are then merged pairwise, every
+// level of merges as jobs again. Chunks do not depend on the thread count and keys are
+// unique, so the list comes out the same with one thread or sixteen.
+// Only CPU data is touched; the draws themselves are recorded by the caller on its thread.
+class DrawListBuilder
+{
+	private:
+		struct Run
+		{
+			unsigned int first;
+			unsigned int count;
+		};
+
+		std::vector<DrawItem> scratch;
+		std::vector<Run> runs;
+		std::vector<Run> merged;
+		unsigned int chunkCount;
+
+	public:
+		DrawListBuilder();
+
+		// writes every entity with a render handle whose box is in the frustum, except exclude,
+		// to out, which must have room for store.getCount() items; returns how many it wrote
+		unsigned int build(EntityStore& store, const glm::vec4* frustum, const glm::vec3& viewPos, EntityId exclude, DrawItem* out);
+
+		// chunks the last build was cut into
+		unsigned int getChunkCount();
+};
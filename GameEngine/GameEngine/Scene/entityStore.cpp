@@ -0,0 +1,201 @@
+#include "entityStore.h"
+#include "..\Physics\collision.h"
+
+void EntityStore::reserve(unsigned int count)
+{
+	positions.reserve(count);
+	sizes.reserve(count);
+	rotations.reserve(count);
+	renderHandles.reserve(count);
+	materials.reserve(count);
+	flags.reserve(count);
+	names.reserve(count);
+	slotEntities.reserve(count);
+	entitySlots.reserve(count);
+}
+
+void EntityStore::clear()
+{
+	positions.clear();
+	sizes.clear();
+	rotations.clear();
+	renderHandles.clear();
+	materials.clear();
+	flags.clear();
+	names.clear();
+	slotEntities.clear();
+	entitySlots.clear();
+	freeIds.clear();
+}
+
+EntityId EntityStore::create(int name, const glm::vec3& position, const glm::vec3& size, unsigned int material, unsigned char flags)
+{
+	EntityId entity;
+	if (!freeIds.empty())
+	{
+		entity = freeIds.back();
+		freeIds.pop_back();
+	}
+	else
+	{
+		entity = (EntityId)entitySlots.size();
+		entitySlots.push_back(INVALID_ENTITY);
+	}
+
+	entitySlots[entity] = (unsigned int)positions.size();
+	positions.push_back(position);
+	sizes.push_back(size);
+	rotations.push_back(0.0f);
+	renderHandles.push_back(NO_RENDER_HANDLE);
+	materials.push_back(material);
+	this->flags.push_back(flags);
+	names.push_back(name);
+	slotEntities.push_back(entity);
+	return entity;
+}
+
+void EntityStore::destroy(EntityId entity)
+{
+	if (!isAlive(entity))
+		return;
+
+	unsigned int slot = entitySlots[entity];
+	unsigned int last = (unsigned int)positions.size() - 1;
+	if (slot != last)
+	{
+		positions[slot] = positions[last];
+		sizes[slot] = sizes[last];
+		rotations[slot] = rotations[last];
+		renderHandles[slot] = renderHandles[last];
+		materials[slot] = materials[last];
+		flags[slot] = flags[last];
+		names[slot] = names[last];
+		slotEntities[slot] = slotEntities[last];
+		entitySlots[slotEntities[slot]] = slot;
+	}
+
+	positions.pop_back();
+	sizes.pop_back();
+	rotations.pop_back();
+	renderHandles.pop_back();
+	materials.pop_back();
+	flags.pop_back();
+	names.pop_back();
+	slotEntities.pop_back();
+
+	entitySlots[entity] = INVALID_ENTITY;
+	freeIds.push_back(entity);
+}
+
+bool EntityStore::isAlive(EntityId entity)
+{
+	return entity < entitySlots.size() && entitySlots[entity] != INVALID_ENTITY;
+}
+
+unsigned int EntityStore::getCount()
+{
+	return (unsigned int)positions.size();
+}
+
+unsigned int EntityStore::slotOf(EntityId entity)
+{
+	return entitySlots[entity];
+}
+
+EntityId EntityStore::entityAt(unsigned int slot)
+{
+	return slotEntities[slot];
+}
+
+glm::vec3 EntityStore::getPosition(EntityId entity)
+{
+	return positions[entitySlots[entity]];
+}
+
+glm::vec3 EntityStore::getSize(EntityId entity)
+{
+	return sizes[entitySlots[entity]];
+}
+
+int EntityStore::getRenderHandle(EntityId entity)
+{
+	return renderHandles[entitySlots[entity]];
+}
+
+void EntityStore::setPosition(EntityId entity, const glm::vec3& position)
+{
+	positions[entitySlots[entity]] = position;
+}
+
+void EntityStore::setRotation(EntityId entity, float rotation)
+{
+	rotations[entitySlots[entity]] = rotation;
+}
+
+void EntityStore::setRenderHandle(EntityId entity, int renderHandle)
+{
+	renderHandles[entitySlots[entity]] = renderHandle;
+}
+
+const glm::vec3* EntityStore::getPositions()
+{
+	return positions.empty() ? NULL : &positions[0];
+}
+
+const glm::vec3* EntityStore::getSizes()
+{
+	return sizes.empty() ? NULL : &sizes[0];
+}
+
+const float* EntityStore::getRotations()
+{
+	return rotations.empty() ? NULL : &rotations[0];
+}
+
+const int* EntityStore::getRenderHandles()
+{
+	return renderHandles.empty() ? NULL : &renderHandles[0];
+}
+
+const unsigned int* EntityStore::getMaterials()
+{
+	return materials.empty() ? NULL : &materials[0];
+}
+
+const unsigned char* EntityStore::getFlags()
+{
+	return flags.empty() ? NULL : &flags[0];
+}
+
+const int* EntityStore::getNames()
+{
+	return names.empty() ? NULL : &names[0];
+}
+
+EntityId EntityStore::findOverlap(const glm::vec3& position, const glm::vec3& size, unsigned char flagMask, EntityId ignore)
+{
+	unsigned int count = (unsigned int)positions.size();
+	unsigned int ignoreSlot = isAlive(ignore) ? entitySlots[ignore] : INVALID_ENTITY;
+
+	// the flag byte rules most entities out before their boxes are touched
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if ((flags[i] & flagMask) == 0 || i == ignoreSlot)
+			continue;
+		if (aabbOverlap(position, size, positions[i], sizes[i]))
+			return slotEntities[i];
+	}
+	return INVALID_ENTITY;
+}
+
+unsigned int EntityStore::cull(const glm::vec4* frustum, EntityId* visible)
+{
+	unsigned int visibleCount = 0;
+	unsigned int count = (unsigned int)positions.size();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (aabbInFrustum(frustum, positions[i], sizes[i]))
+			visible[visibleCount++] = slotEntities[i];
+	}
+	return visibleCount;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm.hpp>
+#include <vector>
+
+// Entities are addressed by a stable id that survives other entities being destroyed.
+// Their components live in dense parallel arrays (one per component), so a system that only
+// needs positions and sizes walks two tightly packed arrays instead of whole objects.
+typedef unsigned int EntityId;
+
+#define INVALID_ENTITY 0xFFFFFFFFu
+// render handle of an entity with nothing of its own to draw (e.g. part of the static level batch)
+#define NO_RENDER_HANDLE -1
+
+class EntityStore
+{
+	private:
+		// dense component streams, all indexed by the same slot
+		std::vector<glm::vec3> positions;	// corner with the smallest coordinates, as in collision.h
+		std::vector<glm::vec3> sizes;
+		std::vector<float> rotations;		// yaw in radians
+		std::vector<int> renderHandles;
+		std::vector<unsigned int> materials;
+		std::vector<unsigned char> flags;
+		std::vector<int> names;				// id from the level file
+		std::vector<EntityId> slotEntities;
+
+		// stable id -> slot; destroyed ids are reused from freeIds
+		std::vector<unsigned int> entitySlots;
+		std::vector<EntityId> freeIds;
+
+	public:
+		void reserve(unsigned int count);
+		void clear();
+
+		EntityId create(int name, const glm::vec3& position, const glm::vec3& size, unsigned int material, unsigned char flags);
+		// the last slot is moved into the hole, so the streams stay dense
+		void destroy(EntityId entity);
+		bool isAlive(EntityId entity);
+
+		unsigned int getCount();
+		unsigned int slotOf(EntityId entity);
+		EntityId entityAt(unsigned int slot);
+
+		// per-entity access
+		glm::vec3 getPosition(EntityId entity);
+		glm::vec3 getSize(EntityId entity);
+		int getRenderHandle(EntityId entity);
+		void setPosition(EntityId entity, const glm::vec3& position);
+		void setRotation(EntityId entity, float rotation);
+		void setRenderHandle(EntityId entity, int renderHandle);
+
+		// whole streams, getCount() entries each
+		const glm::vec3* getPositions();
+		const glm::vec3* getSizes();
+		const float* getRotations();
+		const int* getRenderHandles();
+		const unsigned int* getMaterials();
+		const unsigned char* getFlags();
+		const int* getNames();
+
+		// first entity with any of flagMask set whose box overlaps the given one, skipping ignore
+		EntityId findOverlap(const glm::vec3& position, const glm::vec3& size, unsigned char flagMask, EntityId ignore);
+		// writes every entity whose box is at least partly inside the six frustum planes (as in
+		// CameraRenderState::frustum) to visible, which must have room for getCount() ids; returns how many it wrote
+		unsigned int cull(const glm::vec4* frustum, EntityId* visible);
+};
@@ -1,16 +1,34 @@
 #version 400
 
 in vec2 textureCoord; 
+flat in float textureLayer;
 in vec3 norm;
 in vec3 fragPos;
 
 out vec4 fragColor;
 
-uniform sampler2D texture1;
+uniform sampler2DArray materials;
 uniform vec3 lightColor;
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 
+// clustered point lights, same grid as clusteredLighting.h
+const int CLUSTER_TILES_X = 16;
+const int CLUSTER_TILES_Y = 9;
+const int CLUSTER_SLICES = 24;
+
+uniform samplerBuffer lightData;		// per light: position and radius, then color
+uniform usamplerBuffer clusterData;		// per cluster: offset into lightIndices and count
+uniform usamplerBuffer lightIndices;
+uniform vec2 clusterTileScale;
+uniform float clusterDepthScale;
+uniform float clusterDepthBias;
+uniform vec3 viewForward;
+
+// sun shadow: cached static casters with the dynamic ones drawn on top
+uniform sampler2DShadow shadowMap;
+uniform mat4 lightSpace;
+
 void main()
 {
 	//Ambient light
@@ -35,7 +53,37 @@ void main()
 	float spec = pow(max(dot(viewDir, reflectDir), 0.0), 64);
 	vec3 specular = specularStrength * spec * lightColor; 
 
-	vec3 result = ambient + diffuse + specular;
+	//Sun shadow, only for what the light's view covers
+	vec4 lightSpacePos = lightSpace * vec4(fragPos, 1.0);
+	vec3 shadowCoord = lightSpacePos.xyz / lightSpacePos.w * 0.5 + 0.5;
+	float shadowBias = max(0.002 * (1.0 - dot(normal, lightDir)), 0.0005);
+	float sunVisible = 1.0;
+	if (lightSpacePos.w > 0.0 && all(greaterThanEqual(shadowCoord, vec3(0.0))) && all(lessThanEqual(shadowCoord, vec3(1.0))))
+		sunVisible = texture(shadowMap, vec3(shadowCoord.xy, shadowCoord.z - shadowBias));
+
+	//Point lights, only the ones assigned to this fragment's cluster
+	float depth = max(dot(fragPos - viewPos, viewForward), 0.0001);
+	int slice = clamp(int(log(depth) * clusterDepthScale + clusterDepthBias), 0, CLUSTER_SLICES - 1);
+	ivec2 tile = clamp(ivec2(gl_FragCoord.xy * clusterTileScale), ivec2(0), ivec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+	uvec2 cluster = texelFetch(clusterData, (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x).xy;
+
+	vec3 pointLights = vec3(0.0);
+	for (uint i = 0u; i < cluster.y; i++)
+	{
+		int light = int(texelFetch(lightIndices, int(cluster.x + i)).x);
+		vec4 positionRadius = texelFetch(lightData, 2 * light);
+		vec3 color = texelFetch(lightData, 2 * light + 1).rgb;
+
+		vec3 toLight = positionRadius.xyz - fragPos;
+		float distance = length(toLight);
+		float falloff = clamp(1.0 - distance / positionRadius.w, 0.0, 1.0);
+		vec3 pointDir = toLight / max(distance, 0.0001);
+		float pointDiff = max(dot(normal, pointDir), 0.0);
+		float pointSpec = pow(max(dot(viewDir, reflect(-pointDir, normal)), 0.0), 64);
+		pointLights += (pointDiff + specularStrength * pointSpec) * color * falloff * falloff;
+	}
+
+	vec3 result = ambient + sunVisible * (diffuse + specular) + pointLights;
 	fragColor = vec4(result, 1.0f);
-	fragColor = fragColor * texture(texture1, textureCoord);
-}
\ No newline at end of file
+	fragColor = fragColor * texture(materials, vec3(textureCoord, textureLayer));
+}
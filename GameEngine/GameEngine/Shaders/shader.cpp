@@ -1,4 +1,6 @@
 #include "shader.h"
+#include "..\Graphics\glState.h"
+#include "..\Graphics\glStats.h"
 #include <iostream>
 #include <vector>
 
@@ -101,7 +103,7 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
 
 void Shader::use()
 {
-	glUseProgram(id);
+	glState.useProgram(id);
 }
 
 int Shader::getId()
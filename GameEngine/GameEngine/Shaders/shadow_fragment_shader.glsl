@@ -0,0 +1,6 @@
+#version 400
+
+// depth only, the shadow map has no color attachment
+void main()
+{
+}
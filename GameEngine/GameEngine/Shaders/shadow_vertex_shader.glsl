@@ -0,0 +1,10 @@
+#version 400
+
+layout (location = 0) in vec3 pos;
+
+uniform mat4 lightSpaceModel;
+
+void main()
+{
+	gl_Position = lightSpaceModel * vec4(pos, 1.0f);
+}
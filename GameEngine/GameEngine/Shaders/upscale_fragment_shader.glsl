@@ -0,0 +1,36 @@
+#version 400
+
+in vec2 screenCoord;
+
+out vec4 fragColor;
+
+uniform sampler2D scene;
+// part of the texture the scene was rendered into, and the texel centres at its edges
+uniform vec2 uvScale;
+uniform vec2 uvMin;
+uniform vec2 uvMax;
+uniform vec2 texelSize;
+// 0 is a plain bilinear upscale
+uniform float sharpness;
+
+vec3 sampleScene(vec2 uv)
+{
+	// never filter in the stale texels outside the rendered region
+	return texture(scene, clamp(uv, uvMin, uvMax)).rgb;
+}
+
+void main()
+{
+	vec2 uv = screenCoord * uvScale;
+	vec3 color = sampleScene(uv);
+
+	if (sharpness > 0.0f)
+	{
+		// unsharp mask against the four neighbouring source texels
+		vec3 blur = 0.25f * (sampleScene(uv + vec2(texelSize.x, 0.0f)) + sampleScene(uv - vec2(texelSize.x, 0.0f)) +
+			sampleScene(uv + vec2(0.0f, texelSize.y)) + sampleScene(uv - vec2(0.0f, texelSize.y)));
+		color = clamp(color + sharpness * (color - blur), 0.0f, 1.0f);
+	}
+
+	fragColor = vec4(color, 1.0f);
+}
@@ -0,0 +1,11 @@
+#version 400
+
+out vec2 screenCoord;
+
+void main()
+{
+	// one triangle that covers the whole screen, no vertex buffer needed
+	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	screenCoord = corner;
+	gl_Position = vec4(corner * 2.0f - 1.0f, 0.0f, 1.0f);
+}
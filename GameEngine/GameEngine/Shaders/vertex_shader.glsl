@@ -3,8 +3,10 @@
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 normals;
 layout (location = 2) in vec2 texCoord;
+layout (location = 3) in float layer;
 
 out vec2 textureCoord;
+flat out float textureLayer;
 out vec3 norm;
 out vec3 fragPos;
 
@@ -14,6 +16,7 @@ uniform mat4 model;
 void main()
 {
 	textureCoord = texCoord;
+	textureLayer = layer;
 	fragPos = vec3(model * vec4(pos, 1.0f));
 	norm = mat3(transpose(inverse(model)))*normals;
 	gl_Position = MVP * vec4(pos, 1.0f);
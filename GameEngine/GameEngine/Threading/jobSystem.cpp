@@ -0,0 +1,273 @@
+#include "jobSystem.h"
+#include <algorithm>
+
+JobSystem jobSystem;
+
+// queue of the calling thread, -1 for threads that are not part of the system
+static thread_local int currentQueue = -1;
+
+JobCounter::JobCounter()
+	: pending(0)
+{
+}
+
+bool JobCounter::isDone()
+{
+	if (pending.load() > 0)
+		return false;
+	// the job that brought it to zero may still hold the lock, let it go before anyone frees us
+	std::lock_guard<std::mutex> lock(continuationMutex);
+	return true;
+}
+
+JobSystem::JobSystem()
+	: running(false), queued(0), sleeping(0), executed(0), stolen(0)
+{
+}
+
+JobSystem::~JobSystem()
+{
+	shutdown();
+}
+
+void JobSystem::init(unsigned int threadCount)
+{
+	std::lock_guard<std::mutex> lock(initMutex);
+	if (running)
+		return;
+
+	unsigned int count = threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 0; i <= count; i++)
+		queues.push_back(new WorkerQueue());
+
+	currentQueue = 0;
+	running = true;
+	for (unsigned int i = 1; i < count; i++)
+		threads.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+void JobSystem::shutdown()
+{
+	std::lock_guard<std::mutex> lock(initMutex);
+	if (!running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> sleepLock(sleepMutex);
+		running = false;
+	}
+	wake.notify_all();
+	for (unsigned int i = 0; i < threads.size(); i++)
+		threads[i].join();
+	threads.clear();
+
+	// whatever is left runs here, nobody waiting on a counter is left hanging
+	currentQueue = 0;
+	Job job;
+	while (findJob(job))
+		execute(job);
+
+	for (unsigned int i = 0; i < queues.size(); i++)
+		delete queues[i];
+	queues.clear();
+	currentQueue = -1;
+}
+
+bool JobSystem::isRunning()
+{
+	return running;
+}
+
+unsigned int JobSystem::getThreadCount()
+{
+	return (unsigned int)threads.size() + 1;
+}
+
+void JobSystem::push(Job& job)
+{
+	int index = currentQueue;
+	if (index < 0 || index >= (int)queues.size() - 1)
+		index = (int)queues.size() - 1;
+
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->jobs.push_back(std::move(job));
+	}
+	queued++;
+
+	// a sleeper checks queued under sleepMutex, so taking it here means it either sees the job
+	// or is already waiting for the notification
+	if (sleeping.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_one();
+	}
+}
+
+bool JobSystem::pop(unsigned int queue, Job& job)
+{
+	std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+	if (queues[queue]->jobs.empty())
+		return false;
+	job = std::move(queues[queue]->jobs.back());
+	queues[queue]->jobs.pop_back();
+	queued--;
+	return true;
+}
+
+bool JobSystem::steal(unsigned int thief, Job& job)
+{
+	unsigned int count = (unsigned int)queues.size();
+	for (unsigned int i = 1; i < count; i++)
+	{
+		WorkerQueue* victim = queues[(thief + i) % count];
+		std::lock_guard<std::mutex> lock(victim->mutex);
+		if (victim->jobs.empty())
+			continue;
+		job = std::move(victim->jobs.front());
+		victim->jobs.pop_front();
+		queued--;
+		stolen++;
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::findJob(Job& job)
+{
+	if (queued.load() == 0)
+		return false;
+
+	unsigned int index = currentQueue >= 0 && currentQueue < (int)queues.size() ? currentQueue : (unsigned int)queues.size() - 1;
+	return pop(index, job) || steal(index, job);
+}
+
+void JobSystem::execute(Job& job)
+{
+	job.function();
+	executed++;
+
+	JobCounter* counter = job.counter;
+	if (counter == NULL)
+		return;
+
+	// decremented under the lock, so runAfter() either sees the counter busy and leaves its job
+	// here, or sees it done and queues the job itself
+	std::vector<Job> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->continuationMutex);
+		if (--counter->pending == 0)
+			ready.swap(counter->continuations);
+	}
+	for (unsigned int i = 0; i < ready.size(); i++)
+		push(ready[i]);
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+	currentQueue = (int)index;
+	unsigned int idle = 0;
+	while (running)
+	{
+		Job job;
+		if (findJob(job))
+		{
+			execute(job);
+			idle = 0;
+			continue;
+		}
+
+		if (++idle < JOB_SYSTEM_SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleeping++;
+		wake.wait(lock, [this]() { return !running || queued.load() > 0; });
+		sleeping--;
+		idle = 0;
+	}
+}
+
+void JobSystem::run(const std::function<void()>& function, JobCounter* counter)
+{
+	if (!running)
+		init();
+
+	if (counter != NULL)
+		counter->pending++;
+	Job job;
+	job.function = function;
+	job.counter = counter;
+	push(job);
+}
+
+void JobSystem::runAfter(JobCounter& dependency, const std::function<void()>& function, JobCounter* counter)
+{
+	if (!running)
+		init();
+
+	if (counter != NULL)
+		counter->pending++;
+	Job job;
+	job.function = function;
+	job.counter = counter;
+	{
+		std::lock_guard<std::mutex> lock(dependency.continuationMutex);
+		if (dependency.pending.load() > 0)
+		{
+			dependency.continuations.push_back(job);
+			return;
+		}
+	}
+	push(job);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	while (!counter.isDone())
+	{
+		Job job;
+		if (findJob(job))
+			execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::parallelFor(unsigned int count, unsigned int minChunk, const std::function<void(unsigned int, unsigned int)>& body)
+{
+	if (count == 0)
+		return;
+	if (!running)
+		init();
+
+	unsigned int chunk = std::max(std::max(minChunk, 1u), count / (getThreadCount() * JOB_SYSTEM_JOBS_PER_THREAD));
+	if (chunk >= count)
+	{
+		body(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (unsigned int first = 0; first < count; first += chunk)
+	{
+		unsigned int last = std::min(count, first + chunk);
+		run([&body, first, last]() { body(first, last); }, &counter);
+	}
+	wait(counter);
+}
+
+unsigned long long JobSystem::getExecutedCount()
+{
+	return executed;
+}
+
+unsigned long long JobSystem::getStolenCount()
+{
+	return stolen;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// parallelFor cuts its range into about this many jobs per thread, so stolen work balances out
+#define JOB_SYSTEM_JOBS_PER_THREAD 4
+// a thread that found no work spins this many times before it goes to sleep
+#define JOB_SYSTEM_SPIN_COUNT 64
+
+class JobCounter;
+
+struct Job
+{
+	std::function<void()> function;
+	// finished once the function returned, may be NULL
+	JobCounter* counter;
+};
+
+// Counts the jobs started with it that have not finished yet. Jobs started with runAfter()
+// on a counter wait for it to drop to zero, which is how one batch of jobs depends on another.
+// A counter can be reused once it reached zero.
+class JobCounter
+{
+	friend class JobSystem;
+
+	private:
+		std::atomic<unsigned int> pending;
+		std::mutex continuationMutex;
+		std::vector<Job> continuations;
+
+	public:
+		JobCounter();
+
+		bool isDone();
+};
+
+// Work-stealing scheduler. Every worker thread, and the thread that called init(), owns a
+// deque: jobs it starts go to the back of its own deque and it takes work from the back too,
+// so it keeps running what it just queued while its caches are warm. A thread that runs dry
+// steals from the front of the others', where the oldest and usually biggest jobs sit. Threads
+// that are not part of the system queue to a shared deque everyone steals from.
+// wait() never blocks: the waiting thread runs queued jobs until the counter reaches zero, so
+// jobs can start and wait for jobs of their own.
+// Started on first use with one thread per hardware thread (the caller counts as one).
+class JobSystem
+{
+	private:
+		struct WorkerQueue
+		{
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		std::vector<std::thread> threads;
+		// one per thread of the system, then the shared one for outside threads
+		std::vector<WorkerQueue*> queues;
+		std::atomic<bool> running;
+		std::mutex initMutex;
+
+		// jobs sitting in any queue, threads only sleep while this is zero
+		std::atomic<unsigned int> queued;
+		std::atomic<unsigned int> sleeping;
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+
+		std::atomic<unsigned long long> executed;
+		std::atomic<unsigned long long> stolen;
+
+		void push(Job& job);
+		bool pop(unsigned int queue, Job& job);
+		bool steal(unsigned int thief, Job& job);
+		bool findJob(Job& job);
+		void execute(Job& job);
+		void workerLoop(unsigned int index);
+
+	public:
+		JobSystem();
+		~JobSystem();
+
+		// threadCount 0 is one per hardware thread; the calling thread becomes thread 0
+		void init(unsigned int threadCount = 0);
+		void shutdown();
+		bool isRunning();
+		unsigned int getThreadCount();
+
+		// counter may be NULL for jobs nobody waits for
+		void run(const std::function<void()>& function, JobCounter* counter);
+		// queued once dependency reaches zero, right away if it already has
+		void runAfter(JobCounter& dependency, const std::function<void()>& function, JobCounter* counter);
+		// runs other jobs until counter reaches zero
+		void wait(JobCounter& counter);
+
+		// body(first, last) over [0, count) in chunks of at least minChunk, returns when all ran
+		void parallelFor(unsigned int count, unsigned int minChunk, const std::function<void(unsigned int, unsigned int)>& body);
+
+		unsigned long long getExecutedCount();
+		unsigned long long getStolenCount();
+};
+
+extern JobSystem jobSystem;
@@ -0,0 +1,21 @@
+#include "parallel.h"
+#include "jobSystem.h"
+#include <algorithm>
+#include <thread>
+
+unsigned int workerCount()
+{
+	if (jobSystem.isRunning())
+		return jobSystem.getThreadCount();
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void parallelFor(unsigned int count, const std::function<void(unsigned int)>& body)
+{
+	// the callers hand in a few heavy items (cubemap faces, bands of blocks, batches of lights),
+	// so every item is a job of its own and idle threads steal them
+	jobSystem.parallelFor(count, 1, [&](unsigned int first, unsigned int last) {
+		for (unsigned int i = first; i < last; i++)
+			body(i);
+	});
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <functional>
+
+// Runs body(0) .. body(count - 1) as jobs on the job system and returns once all of them
+// finished. The calling thread runs jobs too while it waits, so a single item never leaves it.
+void parallelFor(unsigned int count, const std::function<void(unsigned int)>& body);
+
+// threads of the job system, or of the machine before it started
+unsigned int workerCount();
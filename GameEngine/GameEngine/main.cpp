@@ -1,14 +1,40 @@
 #include "Graphics\window.h"
+#include "Graphics\glState.h"
+#include "Graphics\glStats.h"
+#include "Graphics\uploadRing.h"
+#include "Graphics\framePacer.h"
+#include "Graphics\dynamicResolution.h"
+#include "Graphics\clusteredLighting.h"
+#include "Graphics\shadowMap.h"
+#include "Graphics\renderThread.h"
+#include "Input\inputQueue.h"
 #include "Camera\camera.h"
 #include "Shaders\shader.h"
 #include "Model Loading\mesh.h"
 #include "Model Loading\texture.h"
+#include "Model Loading\textureContainer.h"
+#include "Model Loading\materialArray.h"
+#include "Assets\assetRegistry.h"
 #include "Model Loading\meshLoaderObj.h"
-#include "stb_image.h"
+#include "Profiling\profiler.h"
+#include "Profiling\benchmark.h"
+#include "Profiling\fragmentCounter.h"
+#include "Physics\collision.h"
+#include "Physics\collisionGrid.h"
+#include "Level\level.h"
+#include "Scene\entityStore.h"
+#include "Scene\drawList.h"
+#include "Memory\frameArena.h"
+#include "Memory\heapCounter.h"
+#include "Memory\allocationTracker.h"
+#include "Threading\jobSystem.h"
 #include <glm.hpp>
 #include "imgui/imgui.h"
 #include "imgui/backends/imgui_impl_glfw.h"
 #include "imgui/backends/imgui_impl_opengl3.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <string>
 
 
@@ -19,12 +45,11 @@ const char* skyboxVertexShaderSource = R"GLSL(
 #version 330 core
 layout (location = 0) in vec3 aPos;
 out vec3 TexCoords;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 viewProjection;
 void main() {
     TexCoords = aPos;  // Pass the vertex position to the fragment shader as texture coordinates
-    vec4 pos = projection * view * vec4(aPos, 1.0);
-    gl_Position = pos.xyww;  // We only need the X and Y coordinates, so Z and W are set to 1.0
+    vec4 pos = viewProjection * vec4(aPos, 1.0);
+    gl_Position = pos.xyww;  // z = w, so after the divide the skybox sits exactly on the far plane
 }
 )GLSL";
 
@@ -86,34 +111,6 @@ float skyboxVertices[] = {
 };
 
 
-//load cubemap function
-unsigned int loadCubemap(std::vector<std::string> faces) {
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-	int width, height, nrChannels;
-	for (unsigned int i = 0; i < faces.size(); i++) {
-		unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-		if (data) {
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			stbi_image_free(data);
-			std::cout << "Loaded texture: " << faces[i] << std::endl;  // Debugging line
-		}
-		else {
-			std::cerr << "Failed to load cubemap texture at " << faces[i] << ": " << stbi_failure_reason() << std::endl;
-			stbi_image_free(data);
-		}
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-	return textureID;
-}
-
 //compile shader function (probabil poate fi folosita cea deja din game engine idk)
 unsigned int compileShader(const char* source, GLenum shaderType) {
 	unsigned int shader = glCreateShader(shaderType);
@@ -166,6 +163,18 @@ unsigned int createShaderProgram(const char* vertexSource, const char* fragmentS
 float deltaTime = 0.0f;	// time between current frame and last frame
 float lastFrame = 0.0f;
 
+// movement and jumping run in fixed steps, each one seeing the input that arrived before it ended
+#define SIM_STEP (1.0 / 60.0)
+// steps run in one frame at most; after a longer stall the simulation skips ahead instead
+#define SIM_MAX_STEPS 8
+double simTime = 0.0;
+InputState simInput;
+
+// a torch floats above every labyrinth wall unless --lights asks for another count
+#define TORCH_HEIGHT 3.0f
+#define TORCH_RADIUS 30.0f
+#define TORCH_COLOR glm::vec3(1.0f, 0.55f, 0.2f)
+
 Window window("Game Engine", 800, 800);
 // pozitia camerei -- foarte corelata cu pozitia player-ului
 Camera camera(glm::vec3(25.0f, -10.0f, 25.0f));		// pozitia camerei
@@ -176,7 +185,6 @@ glm::vec3 lightPos = glm::vec3(-180.0f, 100.0f, -200.0f);
 
 
 
-MeshLoaderObj loader;
 
 
 
@@ -225,398 +233,105 @@ bool collisionCheckREPLACEME = 1;
 
 
 
-class Obiect
-{
-
-	// HITBOX SI CHESTII GENERALE
-
-		// hitboxul o sa fie un mesh facut din rectangle-uri si poti sa il lasi asa daca nu vrei un model anume (e.g. pentru pereti)
-		// daca vrei un model anume, mesh-ul hitboxului nu o sa fie randat, o sa fie randat numai meshul din argument
-
-		// nume ID unic
-	int Obiect_id;
-	// pozitia coltului din: stanga, jos, front
-	glm::vec3 position;
-	// marime: width, height, depth
-	glm::vec3 size;
-
-	std::vector<Vertex> vertices;
-
-	// MESH -- va primi fie valoarea marginilor hitboxului, fie mesh-ul specific din argument, i.f.s.d. constructor
-	Mesh mesh;
-	// or sa trebuiasca si offseturi si rotatii si scalari pt asta... doar inregistreaza-le in niste variabile,
-	// le ajustezi in constructor, si le transmiti sa fie facute in rendering loop
-
-
-	// Rotation angles in radians
-	glm::vec3 rotation;
-
-	// TEXTURA
-	std::vector<Texture> textura;
-
-	// SHADERE (optional?)
-		//
-
-
-
-public:
-
-	// pentru mesh-ul hitbox-ului cu textura peste
-	Obiect(int id, glm::vec3 auxposition, glm::vec3 auxsize, std::vector<Texture> textura)
-	{
-		Obiect_id = id;
-		position = auxposition;
-		size = auxsize;
-
-
-		/*
-				// "compile" all vertices and indices of defined objects:
-					// retrieve the x and y coords of the top left corner
-				float tl_x = position.x;
-				float tl_y = position.y;
-
-				// compute the other 3 corners using the size and
-				// insert them into the vertices array in the following order: TR, BR, BL, TL
-				float width = size.x;
-				float height = size.y;
-
-
-
-				// BR
-				vertices[0] = tl_x + width;  // x
-				vertices[1] = tl_y;          // y
-				vertices[2] = 0.0f;          // z
-
-				// TR
-				vertices[3] = tl_x + width;  // x
-				vertices[4] = tl_y + height; // y
-				vertices[5] = 0.0f;          // z
-
-				// TL
-				vertices[6] = tl_x;         // x
-				vertices[7] = tl_y + height;// y
-				vertices[8] = 0.0f;         // z
-
-				// BL
-				vertices[9] = tl_x;         // x
-				vertices[10] = tl_y;         // y
-				vertices[11] = 0.0f;         // z
-
-				// Define indices for two triangles that form the rectangle
-				indices[0] = 0; // BR // 0
-				indices[1] = 3; // BL // 3
-				indices[2] = 2; // TL // 2
-
-				indices[3] = 1; // TR
-				indices[4] = 0; // BR
-				indices[5] = 2; // TL
-		*/
-
-
-		float x = position.x;
-		float y = position.y;
-		float z = position.z;
-
-		float w = size.x;
-		float h = size.y;
-		float d = size.z;
-
-		if (Obiect_id == 0)
-			std::cout << "player y: " << playerPos.y << " | player y + h: " << playerPos.y + h << std::endl;
-
-		std::cout << Obiect_id << ": " << std::endl;
-		std::cout << y << std::endl;
-		std::cout << y + h << std::endl;
-		std::cout << std::endl;
-
-		std::vector<Vertex> vertices = {
-
-			// Front face
-			Vertex(x,       y,       z + d,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f),
-			Vertex(x + w,   y,       z + d,   0.0f, 0.0f, 1.0f,   1.0f, 0.0f),
-			Vertex(x + w,   y + h,   z + d,   0.0f, 0.0f, 1.0f,   1.0f, 1.0f),
-			Vertex(x,       y + h,   z + d,   0.0f, 0.0f, 1.0f,   0.0f, 1.0f),
-
-			// Back face
-			Vertex(x,       y,       z,      0.0f, 0.0f, -1.0f,  1.0f, 0.0f),
-			Vertex(x + w,   y,       z,      0.0f, 0.0f, -1.0f,  0.0f, 0.0f),
-			Vertex(x + w,   y + h,   z,      0.0f, 0.0f, -1.0f,  0.0f, 1.0f),
-			Vertex(x,       y + h,   z,      0.0f, 0.0f, -1.0f,  1.0f, 1.0f),
-
-			// Left face
-			Vertex(x,       y,       z,      -1.0f, 0.0f, 0.0f,  0.0f, 0.0f),
-			Vertex(x,       y,       z + d,  -1.0f, 0.0f, 0.0f,  1.0f, 0.0f),
-			Vertex(x,       y + h,   z + d,  -1.0f, 0.0f, 0.0f,  1.0f, 1.0f),
-			Vertex(x,       y + h,   z,      -1.0f, 0.0f, 0.0f,  0.0f, 1.0f),
-
-			// Right face
-			Vertex(x + w,   y,       z,      1.0f, 0.0f, 0.0f,   0.0f, 0.0f),
-			Vertex(x + w,   y,       z + d,  1.0f, 0.0f, 0.0f,   1.0f, 0.0f),
-			Vertex(x + w,   y + h,   z + d,  1.0f, 0.0f, 0.0f,   1.0f, 1.0f),
-			Vertex(x + w,   y + h,   z,      1.0f, 0.0f, 0.0f,   0.0f, 1.0f),
-
-			// Top face
-			Vertex(x,       y + h,   z,      0.0f, 1.0f, 0.0f,   0.0f, 0.0f),
-			Vertex(x + w,   y + h,   z,      0.0f, 1.0f, 0.0f,   1.0f, 0.0f),
-			Vertex(x + w,   y + h,   z + d,  0.0f, 1.0f, 0.0f,   1.0f, 1.0f),
-			Vertex(x,       y + h,   z + d,  0.0f, 1.0f, 0.0f,   0.0f, 1.0f),
-
-			// Bottom face
-			Vertex(x,       y,       z,      0.0f, -1.0f, 0.0f,  0.0f, 0.0f),
-			Vertex(x + w,   y,       z,      0.0f, -1.0f, 0.0f,  1.0f, 0.0f),
-			Vertex(x + w,   y,       z + d,  0.0f, -1.0f, 0.0f,  1.0f, 1.0f),
-			Vertex(x,       y,       z + d,  0.0f, -1.0f, 0.0f,  0.0f, 1.0f)
-		};
-
-		std::vector<int> indices = {
-
-			// Front face
-			0, 1, 2, 2, 3, 0,
-			// Back face
-			4, 5, 6, 6, 7, 4,
-			// Left face
-			8, 9, 10, 10, 11, 8,
-			// Right face
-			12, 13, 14, 14, 15, 12,
-			// Top face
-			16, 17, 18, 18, 19, 16,
-			// Bottom face
-			20, 21, 22, 22, 23, 20
-
-		};
-
-		/*
-				std::vector<int> indices = {
-					// front
-					0, 1, 2,
-					2, 3, 0,
-					// right
-					1, 5, 6,
-					6, 2, 1,
-					// back
-					7, 6, 5,
-					5, 4, 7,
-					// left
-					4, 0, 3,
-					3, 7, 4,
-					// bottom
-					4, 5, 1,
-					1, 0, 4,
-					// top
-					3, 2, 6,
-					6, 7, 3
-				};
-		*/
-
-		// Create the Mesh object for the cube
-		mesh = Mesh(vertices, indices, textura);
-
-		/*
-				// hitbox loading
-				vert.push_back(Vertex());
-				vert[0].pos = glm::vec3(10.5f, 10.5f, 0.0f);
-				vert[0].textureCoords = glm::vec2(1.0f, 1.0f);
-
-				vert.push_back(Vertex());
-				vert[1].pos = glm::vec3(10.5f, -10.5f, 0.0f);
-				vert[1].textureCoords = glm::vec2(1.0f, 0.0f);
-
-				vert.push_back(Vertex());
-				vert[2].pos = glm::vec3(-10.5f, -10.5f, 0.0f);
-				vert[2].textureCoords = glm::vec2(0.0f, 0.0f);
-
-				vert.push_back(Vertex());
-				vert[3].pos = glm::vec3(-10.5f, 10.5f, 0.0f);
-				vert[3].textureCoords = glm::vec2(0.0f, 1.0f);
-
-				vert[0].normals = glm::normalize(glm::cross(vert[1].pos - vert[0].pos, vert[3].pos - vert[0].pos));
-				vert[1].normals = glm::normalize(glm::cross(vert[2].pos - vert[1].pos, vert[0].pos - vert[1].pos));
-				vert[2].normals = glm::normalize(glm::cross(vert[3].pos - vert[2].pos, vert[1].pos - vert[2].pos));
-				vert[3].normals = glm::normalize(glm::cross(vert[0].pos - vert[3].pos, vert[2].pos - vert[3].pos));
-
-				Mesh mesh(vert, ind, textura);*/
-	}
-
-	// pentru mesh in argument si hitbox transparent
-	Obiect(int id, glm::vec3 auxposition, glm::vec3 auxsize, Mesh auxmesh)
-	{
-		Obiect_id = id;
-		position = auxposition;
-		size = auxsize;
-		mesh = auxmesh;
-
-		/*
-				// "compile" all vertices and indices of defined objects:
-					// retrieve the x and y coords of the top left corner
-				float tl_x = position.x;
-				float tl_y = position.y;
-
-				// compute the other 3 corners using the size and
-				// insert them into the vertices array in the following order: TR, BR, BL, TL
-				float width = size.x;
-				float height = size.y;
-
-
-
-				// BR
-				vertices[0] = tl_x + width;  // x
-				vertices[1] = tl_y;          // y
-				vertices[2] = 0.0f;          // z
-
-				// TR
-				vertices[3] = tl_x + width;  // x
-				vertices[4] = tl_y + height; // y
-				vertices[5] = 0.0f;          // z
-
-				// TL
-				vertices[6] = tl_x;         // x
-				vertices[7] = tl_y + height;// y
-				vertices[8] = 0.0f;         // z
-
-				// BL
-				vertices[9] = tl_x;         // x
-				vertices[10] = tl_y;         // y
-				vertices[11] = 0.0f;         // z
-
-				// Define indices for two triangles that form the rectangle
-				indices[0] = 0; // BR // 0
-				indices[1] = 3; // BL // 3
-				indices[2] = 2; // TL // 2
-
-				indices[3] = 1; // TR
-				indices[4] = 0; // BR
-				indices[5] = 2; // TL
-		*/
-
-		float x = position.x;
-		float y = position.y;
-		float z = position.z;
-
-		float w = size.x;
-		float h = size.y;
-		float d = size.z;
-
-		if (Obiect_id == 0)
-			std::cout << "player y: " << playerPos.y << " | player y + h: " << playerPos.y + h << std::endl;
-
-		std::cout << Obiect_id << ": " << std::endl;
-		std::cout << y << std::endl;
-		std::cout << y + h << std::endl;
-		std::cout << std::endl;
-
-		/*
-				// hitbox loading
-				vert.push_back(Vertex());
-				vert[0].pos = glm::vec3(10.5f, 10.5f, 0.0f);
-				vert[0].textureCoords = glm::vec2(1.0f, 1.0f);
-
-				vert.push_back(Vertex());
-				vert[1].pos = glm::vec3(10.5f, -10.5f, 0.0f);
-				vert[1].textureCoords = glm::vec2(1.0f, 0.0f);
-
-				vert.push_back(Vertex());
-				vert[2].pos = glm::vec3(-10.5f, -10.5f, 0.0f);
-				vert[2].textureCoords = glm::vec2(0.0f, 0.0f);
-
-				vert.push_back(Vertex());
-				vert[3].pos = glm::vec3(-10.5f, 10.5f, 0.0f);
-				vert[3].textureCoords = glm::vec2(0.0f, 1.0f);
-
-				vert[0].normals = glm::normalize(glm::cross(vert[1].pos - vert[0].pos, vert[3].pos - vert[0].pos));
-				vert[1].normals = glm::normalize(glm::cross(vert[2].pos - vert[1].pos, vert[0].pos - vert[1].pos));
-				vert[2].normals = glm::normalize(glm::cross(vert[3].pos - vert[2].pos, vert[1].pos - vert[2].pos));
-				vert[3].normals = glm::normalize(glm::cross(vert[0].pos - vert[3].pos, vert[2].pos - vert[3].pos));
-
-				Mesh mesh(vert, ind, textura);*/
-	}
+// every level object, the player included, with its components in dense arrays
+EntityStore entities;
+EntityId playerEntity = INVALID_ENTITY;
+// meshes of the entities that are drawn on their own (not in the static batch), by render handle
+std::vector<Mesh> entityMeshes;
+DrawListBuilder drawListBuilder;
 
+// static level boxes, indexed once at load
+CollisionGrid collisionGrid;
 
+// anticipate collision of the player at future_position with any other object
+bool playerWouldCollide(glm::vec3 future_position)
+{
+	ALLOCATION_SCOPE(ALLOC_TAG_COLLISION);
+	glm::vec3 playerSize = entities.getSize(playerEntity);
+	if (collisionGrid.overlapsAny(future_position, playerSize))
+		return true;
 
+	return entities.findOverlap(future_position, playerSize, LEVEL_OBJECT_DYNAMIC, playerEntity) != INVALID_ENTITY;
+}
 
-	Mesh getMesh()
-	{
-		return mesh;
-	}
 
-	int getID()
-	{
-		return Obiect_id;
-	}
 
-	glm::vec3 getPosition()
-	{
-		return position;
-	}
+// passes recorded as callbacks run on the render thread, with a copy of what they were given
 
-	glm::vec3 getSize()
-	{
-		return size;
-	}
+struct ShadowPass
+{
+	glm::vec3 lightPos;
+	glm::vec3 sceneMin;
+	glm::vec3 sceneMax;
+	glm::mat4 levelModel;
+	glm::mat4 playerModel;
+	Mesh* levelMesh;
+	int playerHandle;
+	int windowWidth;
+	int windowHeight;
+};
 
-	void setPosition(glm::vec3 newpos)
+// sun shadows: the labyrinth only when the cached map went stale, the dynamic objects every frame
+void drawShadows(const void* data)
+{
+	const ShadowPass& pass = *(const ShadowPass*)data;
+	shadowMap.setLight(pass.lightPos, pass.sceneMin, pass.sceneMax);
+	if (shadowMap.beginStaticPass())
 	{
-		position = newpos;
+		if (!pass.levelMesh->indices.empty())
+			shadowMap.drawCaster(*pass.levelMesh, pass.levelModel);
+		shadowMap.endStaticPass();
 	}
+	shadowMap.beginDynamicPass();
+	for (int h = 0; h < (int)entityMeshes.size(); h++)
+		shadowMap.drawCaster(entityMeshes[h], h == pass.playerHandle ? pass.playerModel : pass.levelModel);
+	shadowMap.endDynamicPass(pass.windowWidth, pass.windowHeight);
+}
 
-	/*
-	void setRotation(glm::vec3 newrot)
-	{
-		rotation = newrot;
-
-		// Create rotation matrices for each axis
-		glm::mat4 rotationX = glm::rotate(glm::mat4(1.0f), radians.x, glm::vec3(1.0f, 0.0f, 0.0f));
-		glm::mat4 rotationY = glm::rotate(glm::mat4(1.0f), radians.y, glm::vec3(0.0f, 1.0f, 0.0f));
-		glm::mat4 rotationZ = glm::rotate(glm::mat4(1.0f), radians.z, glm::vec3(0.0f, 0.0f, 1.0f));
-
-		// Combine rotations (order matters)
-		glm::mat4 rotationMatrix = rotationZ * rotationY * rotationX;
-
-		for (auto& vertex : vertices) {
-			glm::vec4 pos = glm::vec4(vertex.pos, 1.0f);	// Convert to 4D vector
-			pos = rotationMatrix * pos;                     // Apply rotation
-			vertex.pos = glm::vec3(pos);               // Convert back to 3D vector
-		}
-	}
-	*/
+struct WindowSize
+{
+	int width;
+	int height;
 };
 
-// aici tinem toate obiectele pe care le randam, simulam, etc
-std::vector<Obiect> vector_obiecte;
-
-
-// collision between any 2 objects
-bool isColliding(Obiect& a, Obiect& b)
+void beginScene(const void* data)
 {
-	// check for overlap along each axis	
-	bool xOverlap = (a.getPosition().x < b.getPosition().x + b.getSize().x)
-		&& (b.getPosition().x < a.getPosition().x + a.getSize().x);
+	const WindowSize& size = *(const WindowSize*)data;
+	dynamicResolution.beginScene(size.width, size.height);
+}
 
-	bool yOverlap = (a.getPosition().y < b.getPosition().y + b.getSize().y)
-		&& (b.getPosition().y < a.getPosition().y + a.getSize().y);
+void endScene(const void* data)
+{
+	dynamicResolution.endScene();
+}
 
-	bool zOverlap = (a.getPosition().z < b.getPosition().z + b.getSize().z)
-		&& (b.getPosition().z < a.getPosition().z + a.getSize().z);
+struct SceneLighting
+{
+	GLuint program;
+	unsigned int assignedLights;
+};
 
-	// collision if all three axes overlap
-	return xOverlap && yOverlap && zOverlap;
+// the render size is only known once beginScene ran on the render thread
+void bindSceneLighting(const void* data)
+{
+	const SceneLighting& lighting = *(const SceneLighting*)data;
+	clusteredLighting.bind(lighting.program, lighting.assignedLights, dynamicResolution.getRenderWidth(), dynamicResolution.getRenderHeight());
+	shadowMap.bind(lighting.program);
 }
 
-// anticipate collision for player object's future position and an object
-// uses a specified future_position, not the current one of Obiect& player
-bool anticipateCollision(glm::vec3 future_position, Obiect& player, Obiect& obiect)
+void beginFragmentCount(const void* data)
 {
-	// check for overlap along each axis	
-	bool xOverlap = (future_position.x < obiect.getPosition().x + obiect.getSize().x)
-		&& (obiect.getPosition().x < future_position.x + player.getSize().x);
-
-	bool yOverlap = (future_position.y < obiect.getPosition().y + obiect.getSize().y)
-		&& (obiect.getPosition().y < future_position.y + player.getSize().y);
+	(*(FragmentCounter* const*)data)->begin();
+}
 
-	bool zOverlap = (future_position.z < obiect.getPosition().z + obiect.getSize().z)
-		&& (obiect.getPosition().z < future_position.z + player.getSize().z);
+void endFragmentCount(const void* data)
+{
+	(*(FragmentCounter* const*)data)->end();
+}
 
-	// collision if all three axes overlap
-	return xOverlap && yOverlap && zOverlap;
+void endFramePacing(const void* data)
+{
+	framePacer.endFrame(*(const FrameTiming*)data);
 }
 
 
@@ -627,10 +342,8 @@ bool anticipateCollision(glm::vec3 future_position, Obiect& player, Obiect& obie
 
 
 
-void processKeyboardInput();
+void processKeyboardInput(float step);
 void processPlayerMovement();
-bool checkPlayerCollision(std::vector<Obiect>& vector_obiecte);
-bool isColliding(Obiect& a, Obiect& b);
 
 
 
@@ -644,46 +357,119 @@ bool isColliding(Obiect& a, Obiect& b);
 
 
 
-int main()
+int main(int argc, char** argv)
 {
+	// --benchmark [seconds] [output.json]: scripted flythrough with vsync off
+	// --no-texture-cache: decode the source BMPs instead of the baked .gtex containers
+	// --texture-format rgba8|bc1|bc3|bc7: format the containers are (re)baked in
+	// --track-allocations [report.txt]: per-subsystem heap tracking, overlay and report on exit
+	// --pacing vsync|off|limit|lowlatency [fps]: frame pacing mode, fps is the limiter's rate
+	// --no-dynamic-resolution: always render the scene at window size (the benchmark does too)
+	// --lights count: number of torch lights spread over the walls, one per wall by default
+	// --threads count: job system threads including the main one, one per hardware thread by default
+	// --no-render-thread: replay the recorded GL commands on the main thread
+	ALLOCATION_SCOPE(ALLOC_TAG_LOADER);
+	bool benchmarkMode = false;
+	bool textureCache = true;
+	bool dynamicResolutionEnabled = true;
+	FramePacingMode pacingMode = PACING_VSYNC;
+	unsigned int torchCount = 0;
+	unsigned int threadCount = 0;
+	bool renderThreadEnabled = true;
+	float benchmarkSeconds = 30.0f;
+	std::string benchmarkOutput = "benchmark_results.json";
+	std::string allocationReport = "allocation_report.txt";
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--benchmark")
+		{
+			benchmarkMode = true;
+			if (i + 1 < argc && atof(argv[i + 1]) > 0.0)
+				benchmarkSeconds = (float)atof(argv[++i]);
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				benchmarkOutput = argv[++i];
+		}
+		else if (std::string(argv[i]) == "--no-texture-cache")
+			textureCache = false;
+		else if (std::string(argv[i]) == "--track-allocations")
+		{
+			allocationTracker.setEnabled(true);
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				allocationReport = argv[++i];
+		}
+		else if (std::string(argv[i]) == "--no-dynamic-resolution")
+			dynamicResolutionEnabled = false;
+		else if (std::string(argv[i]) == "--pacing" && i + 1 < argc)
+		{
+			if (!parseFramePacingMode(argv[++i], pacingMode))
+				printf("Unknown pacing mode %s, using %s\n", argv[i], framePacingModeName(pacingMode));
+			if (i + 1 < argc && atof(argv[i + 1]) > 0.0)
+				framePacer.setTargetFps((float)atof(argv[++i]));
+		}
+		else if (std::string(argv[i]) == "--lights" && i + 1 < argc)
+			torchCount = (unsigned int)atoi(argv[++i]);
+		else if (std::string(argv[i]) == "--threads" && i + 1 < argc)
+			threadCount = (unsigned int)atoi(argv[++i]);
+		else if (std::string(argv[i]) == "--no-render-thread")
+			renderThreadEnabled = false;
+		else if (std::string(argv[i]) == "--texture-format" && i + 1 < argc)
+		{
+			GLenum format = parseTextureFormat(argv[++i]);
+			if (format != 0)
+				textureFormat = format;
+			else
+				printf("Unknown texture format %s, using %s\n", argv[i], textureFormatName(textureFormat));
+		}
+	}
+	// loading already decodes and compresses on the workers, and this thread is worker 0
+	jobSystem.init(threadCount);
+	printf("Job system running on %u threads\n", jobSystem.getThreadCount());
+	FlythroughBenchmark benchmark(benchmarkSeconds);
+
 	glClearColor(0.2f, 0.8f, 1.0f, 1.0f);
 
-	glEnable(GL_DEPTH_TEST);
+	glState.setDepthTest(true);
 
 	// Compiling shader program
-	Shader shader("Shaders/vertex_shader.glsl", "Shaders/fragment_shader.glsl");
-	Shader sunShader("Shaders/sun_vertex_shader.glsl", "Shaders/sun_fragment_shader.glsl");
+	AssetHandle<Shader> shaderAsset = assetRegistry.shader("Shaders/vertex_shader.glsl", "Shaders/fragment_shader.glsl");
+	AssetHandle<Shader> sunShaderAsset = assetRegistry.shader("Shaders/sun_vertex_shader.glsl", "Shaders/sun_fragment_shader.glsl");
+	Shader& shader = *shaderAsset;
+	Shader& sunShader = *sunShaderAsset;
 
 
 	// Textures
 
-	GLuint tex = loadBMP("Resources/Textures/rock.bmp");
-	GLuint tex2 = loadBMP("Resources/Textures/wood.bmp");
-	GLuint tex3 = loadBMP("Resources/Textures/orange.bmp");
+	// persistent-mapped pixel buffer the source-image loaders decode into
+	uploadRing.init();
 
-	std::vector<Texture> textures;
-	textures.push_back(Texture());
-	textures[0].id = tex;
-	textures[0].type = "texture_diffuse";
+	// the level names the materials it uses, so it is mapped before the textures are built
+	std::chrono::high_resolution_clock::time_point levelStart = std::chrono::high_resolution_clock::now();
+	Level level;
+	if (!level.load("Resources/Levels/labyrinth.level", "Resources/Levels/labyrinth.glvl") || level.getObjectCount() == 0)
+		return 1;
+	double levelMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - levelStart).count();
 
-	std::vector<Texture> textures2;
-	textures2.push_back(Texture());
-	textures2[0].id = tex2;
-	textures2[0].type = "texture_diffuse";
+	// every diffuse texture is a layer of one array, so all textured objects share a bind
+	std::chrono::high_resolution_clock::time_point textureStart = std::chrono::high_resolution_clock::now();
+	MaterialArray materialArray;
+	std::vector<float> materialLayers;
+	for (unsigned int m = 0; m < level.getMaterialCount(); m++)
+		materialLayers.push_back(materialArray.addMaterial(level.getMaterialPath(m)));
+	materialArray.build(textureCache ? "Resources/Textures/materials.gtex" : NULL);
+	double textureMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - textureStart).count();
 
-	std::vector<Texture> textures3;
-	textures3.push_back(Texture());
-	textures3[0].id = tex3;
-	textures3[0].type = "texture_diffuse";
+	std::vector<Texture> materials;
+	materials.push_back(materialArray.getTexture());
 
 
 
 	// Meshes
 
-	Mesh sun = loader.loadObj("Resources/Models/sphere.obj");
-	Mesh suz = loader.loadObj("Resources/Models/suzanne.obj", textures);
-	Mesh plane = loader.loadObj("Resources/Models/plane1.obj", textures2);
-	Mesh playercube = loader.loadObj("Resources/Models/cube.obj");
+	// loaded on first use, so the ones nothing draws never reach the GPU
+	AssetHandle<Mesh> sun = assetRegistry.mesh("Resources/Models/sphere.obj");
+	AssetHandle<Mesh> suz = assetRegistry.mesh("Resources/Models/suzanne.obj", materials);
+	AssetHandle<Mesh> plane = assetRegistry.mesh("Resources/Models/plane1.obj", materials);
+	AssetHandle<Mesh> playercube = assetRegistry.mesh("Resources/Models/cube.obj");
 
 
 
@@ -693,80 +479,93 @@ int main()
 
 	// Obiecte
 
-		// daca nu incepe playerul la -20 se buleste absolut tot legat de coliziunile pe Y
-		// daca nu incepe de la x=0 si z=0, se strica de la offsetul din clasa de camera (dar nu stau sa-l automatizez)
-	vector_obiecte.push_back(Obiect(0, glm::vec3(0.0f, -20.0f, 0.0f), glm::vec3(2.0f, 5.0f, 2.0f), textures3));
-	vector_obiecte.push_back(Obiect(1, glm::vec3(-50.0f, 0.0f, -50.0f), glm::vec3(200.0f, 10.0f, 200.0f), textures));
-	vector_obiecte.push_back(Obiect(2, glm::vec3(150.0f, 0.0f, -50.0f), glm::vec3(200.0f, 10.0f, 200.0f), textures));
-	//vector_obiecte.push_back(Obiect(2, glm::vec3(-50.0f, 0.0f, -50.0f), glm::vec3(200.0f, 10.0f, 200.0f), suz));
+	// one pass over the level's flat arrays: an entity for every object, static boxes batched
+	// into a single mesh and indexed for collisions, dynamic ones (the player) with a mesh of their own
+	levelStart = std::chrono::high_resolution_clock::now();
+	unsigned int objectCount = level.getObjectCount();
+	const int* objectIds = level.getIds();
+	const glm::vec3* objectPositions = level.getPositions();
+	const glm::vec3* objectSizes = level.getSizes();
+	const unsigned int* objectMaterials = level.getMaterials();
+	const unsigned char* objectFlags = level.getFlags();
+
+	std::vector<Vertex> levelVertices;
+	std::vector<int> levelIndices;
+	std::vector<glm::vec3> staticPositions;
+	std::vector<glm::vec3> staticSizes;
+	levelVertices.reserve(objectCount * 24);
+	levelIndices.reserve(objectCount * 36);
+	entities.reserve(objectCount);
+
+	for (unsigned int i = 0; i < objectCount; i++)
+	{
+		float layer = materialLayers[objectMaterials[i]];
+		EntityId entity = entities.create(objectIds[i], objectPositions[i], objectSizes[i], objectMaterials[i], objectFlags[i]);
+		if (objectFlags[i] & LEVEL_OBJECT_DYNAMIC)
+		{
+			std::vector<Vertex> vertices;
+			std::vector<int> indices;
+			appendBoxGeometry(objectPositions[i], objectSizes[i], layer, vertices, indices);
+			entities.setRenderHandle(entity, (int)entityMeshes.size());
+			ALLOCATION_SCOPE(ALLOC_TAG_MESH);
+			entityMeshes.push_back(Mesh(vertices, indices, materials));
+			continue;
+		}
 
+		appendBoxGeometry(objectPositions[i], objectSizes[i], layer, levelVertices, levelIndices);
+		staticPositions.push_back(objectPositions[i]);
+		staticSizes.push_back(objectSizes[i]);
+	}
+	// the first object of the level is the player
+	playerEntity = entities.entityAt(0);
 
-	// labirint
-	float predef_height = 8.0f;
-	float predef_height_length = 10.0f;
+	Mesh levelMesh;
+	if (!levelIndices.empty())
 	{
-		//vector_obiecte.push_back(Obiect(10, glm::vec3(1.1372855, predef_height, 0.42250618), glm::vec3(52.440838, predef_height_length, 4.5908861), textures2));
-		vector_obiecte.push_back(Obiect(11, glm::vec3(87.200981, predef_height, 11.013816), glm::vec3(42.580688, predef_height_length, 4.61971), textures2));
-		vector_obiecte.push_back(Obiect(12, glm::vec3(96.55674, predef_height, 0.82457626), glm::vec3(42.580688, predef_height_length, 4.61971), textures2));
-		vector_obiecte.push_back(Obiect(13, glm::vec3(68.274307, predef_height, 29.346987), glm::vec3(14.096099, predef_height_length, 4.7329602), textures2));
-		vector_obiecte.push_back(Obiect(14, glm::vec3(58.890327, predef_height, 14.485009), glm::vec3(14.096099, predef_height_length, 4.7329602), textures2));
-		vector_obiecte.push_back(Obiect(15, glm::vec3(49.221619, predef_height, 29.114639), glm::vec3(14.096099, predef_height_length, 4.7329602), textures2));
-		vector_obiecte.push_back(Obiect(16, glm::vec3(39.316532, predef_height, 48.116287), glm::vec3(14.096099, predef_height_length, 4.7329602), textures2));
-		vector_obiecte.push_back(Obiect(17, glm::vec3(58.683502, predef_height, 47.952427), glm::vec3(14.096099, predef_height_length, 4.7329602), textures2));
-		vector_obiecte.push_back(Obiect(18, glm::vec3(53.841625, predef_height, 0.68185288), glm::vec3(52.440838, predef_height_length, 4.5908861), textures2));
-		vector_obiecte.push_back(Obiect(19, glm::vec3(58.569191, predef_height, 19.65799), glm::vec3(52.440838, predef_height_length, 4.5908861), textures2));
-		vector_obiecte.push_back(Obiect(20, glm::vec3(58.121952, predef_height, 67.378357), glm::vec3(52.440838, predef_height_length, 4.5908861), textures2));
-		vector_obiecte.push_back(Obiect(21, glm::vec3(48.947918, predef_height, 5.0133924), glm::vec3(4.6302085, predef_height_length, 28.631697), textures2));
-		vector_obiecte.push_back(Obiect(22, glm::vec3(77.423111, predef_height, 38.952435), glm::vec3(4.6302085, predef_height_length, 28.631697), textures2));
-		vector_obiecte.push_back(Obiect(23, glm::vec3(23.772322, predef_height, 19.659969), glm::vec3(38.175598, predef_height_length, 4.5357141), textures2));
-		vector_obiecte.push_back(Obiect(25, glm::vec3(30.078815, predef_height, 39.088078), glm::vec3(38.175598, predef_height_length, 4.4412203), textures2));
-		vector_obiecte.push_back(Obiect(26, glm::vec3(40.222961, predef_height, 77.017509), glm::vec3(38.175598, predef_height_length, 4.4412203), textures2));
-		//vector_obiecte.push_back(Obiect(27, glm::vec3(1.1372855, predef_height, 5.0133924), glm::vec3(4.8158398, predef_height_length, 27.813984), textures2));
-		vector_obiecte.push_back(Obiect(28, glm::vec3(135.11575, predef_height, 48.431767), glm::vec3(4.8158398, predef_height_length, 47.813984), textures2));
-		vector_obiecte.push_back(Obiect(29, glm::vec3(135.07138, predef_height, 0.94643623), glm::vec3(4.8158398, predef_height_length, 47.813984), textures2));
-		vector_obiecte.push_back(Obiect(30, glm::vec3(0.69528389, predef_height, 52.724197), glm::vec3(4.8158398, predef_height_length, 47.813984), textures2));
-		vector_obiecte.push_back(Obiect(31, glm::vec3(31.772322, predef_height, 24.195683), glm::vec3(4.7247019, predef_height_length, 19.182293), textures2));
-		vector_obiecte.push_back(Obiect(32, glm::vec3(58.278927, predef_height, 19.900898), glm::vec3(4.7707243, predef_height_length, 13.615655), textures2));
-		vector_obiecte.push_back(Obiect(33, glm::vec3(68.221611, predef_height, 0.36067444), glm::vec3(4.7707243, predef_height_length, 13.615655), textures2));
-		vector_obiecte.push_back(Obiect(34, glm::vec3(125.05869, predef_height, 34.015962), glm::vec3(4.7707243, predef_height_length, 13.615655), textures2));
-		vector_obiecte.push_back(Obiect(35, glm::vec3(77.557251, predef_height, 35.186513), glm::vec3(4.7707243, predef_height_length, 13.615655), textures2));
-		vector_obiecte.push_back(Obiect(36, glm::vec3(36.736322, predef_height, 58.329948), glm::vec3(4.7707243, predef_height_length, 13.615655), textures2));
-		vector_obiecte.push_back(Obiect(37, glm::vec3(125.08556, predef_height, 48.189827), glm::vec3(4.7707243, predef_height_length, 13.615655), textures2));
-		vector_obiecte.push_back(Obiect(38, glm::vec3(125.00494, predef_height, 76.876305), glm::vec3(4.7707243, predef_height_length, 13.615655), textures2));
-		vector_obiecte.push_back(Obiect(39, glm::vec3(115.47031, predef_height, 58.212864), glm::vec3(4.6395726, predef_height_length, 32.193371), textures2));
-		vector_obiecte.push_back(Obiect(40, glm::vec3(29.447573, predef_height, 39.164627), glm::vec3(4.7247019, predef_height_length, 19.182293), textures2));
-		vector_obiecte.push_back(Obiect(41, glm::vec3(39.413097, predef_height, 57.968845), glm::vec3(4.7247019, predef_height_length, 19.182293), textures2));
-		vector_obiecte.push_back(Obiect(42, glm::vec3(67.986763, predef_height, 43.052795), glm::vec3(4.7247019, predef_height_length, 19.182293), textures2));
-		vector_obiecte.push_back(Obiect(43, glm::vec3(68.399063, predef_height, 29.248795), glm::vec3(4.7247019, predef_height_length, 19.182293), textures2));
-		vector_obiecte.push_back(Obiect(44, glm::vec3(86.899773, predef_height, 24.259315), glm::vec3(4.7247019, predef_height_length, 19.182293), textures2));
-		vector_obiecte.push_back(Obiect(45, glm::vec3(96.581886, predef_height, 38.646191), glm::vec3(4.6978688, predef_height_length, 22.897234), textures2));
-		vector_obiecte.push_back(Obiect(46, glm::vec3(115.78501, predef_height, 14.060096), glm::vec3(4.7247019, predef_height_length, 19.182293), textures2));
-		vector_obiecte.push_back(Obiect(48, glm::vec3(116.00485, predef_height, 38.996563), glm::vec3(4.7707243, predef_height_length, 13.615655), textures2));
-		vector_obiecte.push_back(Obiect(49, glm::vec3(48.977024, predef_height, 52.400517), glm::vec3(4.7247019, predef_height_length, 19.182293), textures2));
-		vector_obiecte.push_back(Obiect(50, glm::vec3(5.953125, predef_height, 48.386162), glm::vec3(19.087799, predef_height_length, 4.4412169), textures2));
-		vector_obiecte.push_back(Obiect(51, glm::vec3(20.355036, predef_height, 57.917809), glm::vec3(19.087799, predef_height_length, 4.4412169), textures2));
-		vector_obiecte.push_back(Obiect(52, glm::vec3(87.385323, predef_height, 76.828835), glm::vec3(28.379045, predef_height_length, 4.3780298), textures2));
-		vector_obiecte.push_back(Obiect(53, glm::vec3(20.453715, predef_height, 29.298363), glm::vec3(4.6302099, predef_height_length, 19.087799), textures2));
-		vector_obiecte.push_back(Obiect(54, glm::vec3(38.960194, predef_height, 29.471451), glm::vec3(4.6764565, predef_height_length, 13.521385), textures2));
-		vector_obiecte.push_back(Obiect(55, glm::vec3(87.131828, predef_height, 48.636959), glm::vec3(4.6764565, predef_height_length, 13.521385), textures2));
-		vector_obiecte.push_back(Obiect(56, glm::vec3(25.040924, predef_height, 29.298363), glm::vec3(19.087797, predef_height_length, 4.4412198), textures2));
-		vector_obiecte.push_back(Obiect(57, glm::vec3(116.15706, predef_height, 38.605915), glm::vec3(19.087797, predef_height_length, 4.4412198), textures2));
-		vector_obiecte.push_back(Obiect(58, glm::vec3(96.775284, predef_height, 29.424734), glm::vec3(19.087797, predef_height_length, 4.4412198), textures2));
-		vector_obiecte.push_back(Obiect(59, glm::vec3(96.666504, predef_height, 57.865437), glm::vec3(19.087797, predef_height_length, 4.4412198), textures2));
-		vector_obiecte.push_back(Obiect(61, glm::vec3(116.31538, predef_height, 86.402695), glm::vec3(13.256493, predef_height_length, 4.4898448), textures2));
-		vector_obiecte.push_back(Obiect(62, glm::vec3(126.08751, predef_height, 29.208355), glm::vec3(9.0231743, predef_height_length, 4.5328393), textures2));
-		vector_obiecte.push_back(Obiect(63, glm::vec3(87.388481, predef_height, 48.451759), glm::vec3(9.0231743, predef_height_length, 4.5328393), textures2));
-		vector_obiecte.push_back(Obiect(64, glm::vec3(125.6228, predef_height, 67.226462), glm::vec3(9.0231743, predef_height_length, 4.5328393), textures2));
-		vector_obiecte.push_back(Obiect(65, glm::vec3(5.8175478, predef_height, 76.932739), glm::vec3(9.0231743, predef_height_length, 4.5328393), textures2));
-		vector_obiecte.push_back(Obiect(66, glm::vec3(53.904575, predef_height, 57.94318), glm::vec3(9.0231743, predef_height_length, 4.5328393), textures2));
-		vector_obiecte.push_back(Obiect(67, glm::vec3(15.369582, predef_height, 67.465652), glm::vec3(19.087797, predef_height_length, 4.4412198), textures2));
+		ALLOCATION_SCOPE(ALLOC_TAG_MESH);
+		levelMesh = Mesh(levelVertices, levelIndices, materials);
 	}
+	if (!staticPositions.empty())
+		collisionGrid.build(&staticPositions[0], &staticSizes[0], (unsigned int)staticPositions.size(), COLLISION_GRID_CELL_SIZE);
+
+	// the level is drawn with the plane's model matrix the previous frame left bound, so its
+	// shadow is cast from there too, and the sun's shadow view is fitted around that
+	glm::mat4 levelModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -20.0f, 0.0f));
+	glm::vec3 shadowMin = glm::vec3(0.0f);
+	glm::vec3 shadowMax = glm::vec3(0.0f);
+	for (unsigned int i = 0; i < staticPositions.size(); i++)
+	{
+		shadowMin = i == 0 ? staticPositions[i] : glm::min(shadowMin, staticPositions[i]);
+		shadowMax = i == 0 ? staticPositions[i] + staticSizes[i] : glm::max(shadowMax, staticPositions[i] + staticSizes[i]);
+	}
+	shadowMin = glm::vec3(levelModel * glm::vec4(shadowMin, 1.0f));
+	shadowMax = glm::vec3(levelModel * glm::vec4(shadowMax, 1.0f));
+
+	// torches on top of the walls; objects 0 to 2 are the player and the two floors. More torches
+	// than walls are spread along each wall's longer side
+	unsigned int wallCount = objectCount > 3 ? objectCount - 3 : 0;
+	unsigned int torches = torchCount > 0 ? torchCount : wallCount;
+	unsigned int torchRounds = wallCount > 0 ? (torches + wallCount - 1) / wallCount : 0;
+	for (unsigned int t = 0; t < torches && wallCount > 0; t++)
+	{
+		unsigned int i = 3 + t % wallCount;
+		float along = (t / wallCount + 0.5f) / torchRounds;
+		glm::vec3 torch = objectPositions[i] + objectSizes[i] * glm::vec3(0.5f, 1.0f, 0.5f);
+		if (objectSizes[i].x > objectSizes[i].z)
+			torch.x = objectPositions[i].x + objectSizes[i].x * along;
+		else
+			torch.z = objectPositions[i].z + objectSizes[i].z * along;
+		torch.y += TORCH_HEIGHT;
+		// the walls are drawn with levelModel, the lights have to be where the walls end up
+		torch = glm::vec3(levelModel * glm::vec4(torch, 1.0f));
+		if (!clusteredLighting.addLight(torch, TORCH_RADIUS, TORCH_COLOR))
+			break;
+	}
+	levelMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - levelStart).count();
 
-	// stalpi de parkour
-	vector_obiecte.push_back(Obiect(68, glm::vec3(157.1494594, 10.0f, 76.4780231), glm::vec3(5.278573, 7.0f, 4.7440343), textures2));
-	vector_obiecte.push_back(Obiect(69, glm::vec3(167.305702, 10.0f, 81.489327), glm::vec3(5.0781207, 12.0f, 4.4767647), textures2));
-	vector_obiecte.push_back(Obiect(70, glm::vec3(163.102751, 10.0f, 93.656635), glm::vec3(4.7977629, 17.0f, 4.597311), textures2));
-	vector_obiecte.push_back(Obiect(71, glm::vec3(163.3408689, 10.0f, 106.34539), glm::vec3(25.79151, 22.0f, 5.1449385), textures2));
+	printf("Level loaded in %.2f ms: %u objects, %u static in one batch (%zu vertices), %u dynamic, %d grid cells\n", levelMs, objectCount,
+		collisionGrid.getBoxCount(), levelVertices.size(), (unsigned int)entityMeshes.size(), collisionGrid.getCellCount());
+	printf("%u torch lights\n", clusteredLighting.getLightCount());
 
 
 
@@ -788,12 +587,15 @@ int main()
 	unsigned int skyboxVAO, skyboxVBO;
 	glGenVertexArrays(1, &skyboxVAO);
 	glGenBuffers(1, &skyboxVBO);
-	glBindVertexArray(skyboxVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
+	glState.bindVertexArray(skyboxVAO);
+	glState.bindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
+	// how many pixels the skybox still shades after the scene
+	FragmentCounter skyboxFragments;
+
 	// Load cubemap textures
 	std::vector<std::string> faces = {
 		"Resources/Skybox/clouds1_west.bmp",
@@ -804,7 +606,13 @@ int main()
 		"Resources/Skybox/clouds1_north.bmp"
 	};
 
-	unsigned int cubemapTexture = loadCubemap(faces);
+	textureStart = std::chrono::high_resolution_clock::now();
+	AssetHandle<Texture> skybox = assetRegistry.cubemap(faces, textureCache ? "Resources/Skybox/clouds1.gtex" : NULL);
+	unsigned int cubemapTexture = skybox.get() != NULL ? skybox->id : 0;
+	textureMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - textureStart).count();
+	printf("Textures loaded in %.2f ms (%s)\n", textureMs, textureCache ? "baked" : "source images");
+	if (uploadRing.isReady())
+		printf("Upload ring: %u uploads, %u stalls (%.2f ms)\n", uploadRing.getUploadCount(), uploadRing.getStallCount(), uploadRing.getStallMs());
 
 
 
@@ -812,6 +620,7 @@ int main()
 
 	// Setup Dear ImGui
 	IMGUI_CHECKVERSION();
+	ImGui::SetAllocatorFunctions(heapCounterImGuiAlloc, heapCounterImGuiFree);
 	ImGui::CreateContext();
 	ImGuiIO& io = ImGui::GetIO();
 	(void)io;
@@ -823,15 +632,61 @@ int main()
 	ImGui_ImplGlfw_InitForOpenGL(window.getWindow(), true);
 	ImGui_ImplOpenGL3_Init("#version 400");
 
+	profiler.init();
+	skyboxFragments.init();
+	dynamicResolution.init();
+	clusteredLighting.init();
+	shadowMap.init();
+	// benchmark frame times are only comparable at a fixed resolution
+	dynamicResolution.setEnabled(dynamicResolutionEnabled && !benchmarkMode);
 
+	framePacer.init(benchmarkMode ? PACING_UNCAPPED : pacingMode);
+	if (benchmarkMode)
+	{
+		std::cout << "Running flythrough benchmark for " << benchmarkSeconds << " seconds" << std::endl;
+	}
+
+	// the render thread cannot load anything, so what the loop draws is loaded now, and ImGui's
+	// GL objects are made before the context moves over
+	Mesh* sunMesh = sun.get();
+	ImGui_ImplOpenGL3_CreateDeviceObjects();
+	renderThread.init(window.getWindow());
+	renderThread.setEnabled(renderThreadEnabled);
 
 
 
+
+	simTime = glfwGetTime();
+
 	// Rendering loop
 		//check if we close the window or press the escape button
 	while (!window.isPressed(GLFW_KEY_ESCAPE) && glfwWindowShouldClose(window.getWindow()) == 0)
 	{
-		window.clear();
+		// checked before anything begins a frame, so the last one recorded is also complete
+		if (benchmarkMode && benchmark.isFinished((float)glfwGetTime()))
+			break;
+
+		// whatever the frame allocates is charged to rendering unless a narrower scope says otherwise
+		ALLOCATION_SCOPE(ALLOC_TAG_RENDER);
+		// low latency pacing waits on a fence before input, which needs the context on this thread
+		bool threaded = renderThread.isEnabled() && framePacer.getMode() != PACING_LOW_LATENCY;
+		if (threaded && !renderThread.isRunning())
+			renderThread.start();
+		else if (!threaded && renderThread.isRunning())
+			renderThread.stop();
+
+		framePacer.waitForFrame();
+		window.pollEvents();
+
+		profiler.beginFrame();
+		frameArena.beginFrame();
+		allocationTracker.beginFrame();
+
+		// the frame's GL work is recorded here and replayed by the render thread while the next
+		// frame is simulated; nothing below calls GL directly
+		CommandBuffer& commands = renderThread.getCommands();
+		commands.beginFrame(profiler.getFrameIndex());
+		commands.clear(true, true);
 		float currentFrame = glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
@@ -845,72 +700,138 @@ int main()
 
 
 
-		processKeyboardInput();
+		double now = glfwGetTime();
+		unsigned int simSteps = 0;
+		unsigned int simEvents = 0;
 
-		processPlayerMovement();
+		if (benchmarkMode)
+		{
+			// the flythrough drives the player, input is only drained
+			simInput.consume(window.getInputQueue(), now, now);
+
+			benchmark.recordFrame(deltaTime * 1000.0f, frameArena.getLastFrameHeapAllocations());
+			benchmark.update(currentFrame, playerPos, playerAngle, camera, distanceFromCube, heightAboveCube);
+			entities.setPosition(playerEntity, playerPos);
+			entities.setRotation(playerEntity, playerAngle);
+		}
+		else
+		{
+			while (simTime + SIM_STEP <= now && simSteps < SIM_MAX_STEPS)
+			{
+				simTime += SIM_STEP;
+				simEvents += simInput.consume(window.getInputQueue(), simTime, now);
+
+				{
+					PROFILE_SCOPE("input");
+					processKeyboardInput((float)SIM_STEP);
+				}
+
+				{
+					PROFILE_SCOPE("movement");
+					processPlayerMovement();
+				}
+
+				simInput.endStep();
+				simSteps++;
+			}
+			if (simTime + SIM_STEP <= now)
+				simTime = now;
+		}
 
 
 
 
 		// taskuri
-		if (anticipateCollision(glm::vec3(playerPos.x, playerPos.y - 1.0f, playerPos.z), vector_obiecte.at(0), vector_obiecte.at(1)))
+		profiler.beginCpuScope("collision");
+		if (aabbOverlap(glm::vec3(playerPos.x, playerPos.y - 1.0f, playerPos.z), entities.getSize(playerEntity), entities.getPosition(1), entities.getSize(1)))
 		{
 			current_task = 1;
 		}
 
-		if (anticipateCollision(glm::vec3(playerPos.x, playerPos.y - 1.0f, playerPos.z), vector_obiecte.at(0), vector_obiecte.at(2)))
+		if (aabbOverlap(glm::vec3(playerPos.x, playerPos.y - 1.0f, playerPos.z), entities.getSize(playerEntity), entities.getPosition(2), entities.getSize(2)))
 		{
 			current_task = 2;
 		}
+		profiler.endCpuScope();
 
 
 
 
 
-		// Disable depth test for the skybox to ensure it renders behind everything
-		glDisable(GL_DEPTH_TEST);
-
-		// Update the view matrix (do not translate the camera for skybox)
-		glm::mat4 view = glm::mat4(glm::mat3(glm::lookAt(camera.getCameraPosition(), camera.getCameraPosition() + camera.getCameraViewDirection(), camera.getCameraUp()))); // Remove translation for the skybox
-		glm::mat4 projection = glm::perspective(glm::radians(4000.0f), 800.0f / 600.0f, 0.1f, 100.0f);
-
-
-		// Render the skybox
-		glUseProgram(skyboxShader);
-		glUniformMatrix4fv(glGetUniformLocation(skyboxShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-		glUniformMatrix4fv(glGetUniformLocation(skyboxShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-
-		glBindVertexArray(skyboxVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-
-		// Re-enable depth test for the rest of the scene
-		glEnable(GL_DEPTH_TEST);
-
 		//// Code for the light ////
 
-		sunShader.use();
+		// matrices and frustum are only rebuilt when the camera or the window actually changed
+		camera.setProjection(90.0f, window.getWidth() * 1.0f / window.getHeight(), 0.1f, 10000.0f);
+		const CameraRenderState& cameraState = camera.getRenderState();
 
-		glm::mat4 ProjectionMatrix = glm::perspective(90.0f, window.getWidth() * 1.0f / window.getHeight(), 0.1f, 10000.0f);
-		glm::mat4 ViewMatrix = glm::lookAt(camera.getCameraPosition(), camera.getCameraPosition() + camera.getCameraViewDirection(), camera.getCameraUp());
+		profiler.beginCpuScope("lights");
+		unsigned int assignedLights = clusteredLighting.assign(cameraState);
+		profiler.endCpuScope();
 
+		// where the player is drawn, in the shadow map and in the scene
+		glm::mat4 playerModel = glm::mat4(1.0);
+		// translate according to where the controls have moved the player
+		playerModel = glm::translate(playerModel, playerPos);
+		// rotate according to the angle given by controls
+		playerModel = glm::rotate(playerModel, playerAngle, glm::vec3(0.0f, 1.0f, 0.0f));
+
+		// culled and sorted on the job system; the draw list is frame data, from the frame arena
+		profiler.beginCpuScope("draw list");
+		DrawItem* drawList = frameArena.allocateArray<DrawItem>(entities.getCount());
+		unsigned int drawCount = drawListBuilder.build(entities, cameraState.frustum, cameraState.position, playerEntity, drawList);
+		profiler.endCpuScope();
+
+		profiler.beginCpuScope("shadows");
+		commands.beginGpuScope("shadows");
+		ShadowPass shadowPass;
+		shadowPass.lightPos = lightPos;
+		shadowPass.sceneMin = shadowMin;
+		shadowPass.sceneMax = shadowMax;
+		shadowPass.levelModel = levelModel;
+		shadowPass.playerModel = playerModel;
+		shadowPass.levelMesh = &levelMesh;
+		shadowPass.playerHandle = entities.getRenderHandle(playerEntity);
+		shadowPass.windowWidth = window.getWidth();
+		shadowPass.windowHeight = window.getHeight();
+		commands.call(drawShadows, &shadowPass, sizeof(shadowPass));
+		commands.endGpuScope();
+		profiler.endCpuScope();
+
+		// the 3D scene goes to the offscreen target, ImGui is drawn at window size after the upscale
+		WindowSize windowSize = { window.getWidth(), window.getHeight() };
+		commands.call(beginScene, &windowSize, sizeof(windowSize));
+
+		profiler.beginCpuScope("sun");
+		commands.beginGpuScope("sun");
+
+		commands.useShader(&sunShader);
+		// the skybox leaves GL_LEQUAL behind from the previous frame
+		commands.setDepthFunc(RENDER_DEPTH_LESS);
 
 
-		GLuint MatrixID = glGetUniformLocation(sunShader.getId(), "MVP");
 
 		//Test for one Obj loading = light source
 
 		glm::mat4 ModelMatrix = glm::mat4(1.0);
 		ModelMatrix = glm::translate(ModelMatrix, lightPos);
-		glm::mat4 MVP = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
+		glm::mat4 MVP = cameraState.viewProjection * ModelMatrix;
+		commands.setUniform("MVP", MVP);
+
+		if (sunMesh != NULL)
+			commands.drawMesh(sunMesh);
 
-		sun.draw(sunShader);
+		commands.endGpuScope();
+		profiler.endCpuScope();
 
 		//// End code for the light ////
 
-		shader.use();
+		profiler.beginCpuScope("objects");
+		commands.beginGpuScope("objects");
 
+		commands.useShader(&shader);
+		// gl_FragCoord is in render pixels, not window pixels
+		SceneLighting sceneLighting = { (GLuint)shader.getId(), assignedLights };
+		commands.call(bindSceneLighting, &sceneLighting, sizeof(sceneLighting));
 
 
 
@@ -919,32 +840,27 @@ int main()
 
 
 
-		// rendering for objects, i.e. not for player, with id==0
-		for (int v = 1; v < vector_obiecte.size(); v++)
-		{
-			vector_obiecte.at(v).getMesh().draw(shader);
-		}
 
+		// rendering for objects, i.e. not for player, with id==0: all static ones in one draw,
+		// then any other dynamic object
+		if (!levelMesh.indices.empty())
+			commands.drawMesh(&levelMesh);
+		for (unsigned int d = 0; d < drawCount; d++)
+			commands.drawMesh(&entityMeshes[drawList[d].renderHandle]);
 
 
-		GLuint MatrixID2 = glGetUniformLocation(shader.getId(), "MVP");
-		GLuint ModelMatrixID = glGetUniformLocation(shader.getId(), "model");
 
 		// player mesh
 
-		ModelMatrix = glm::mat4(1.0);
-		// translate according to where the controls have moved the player
-		ModelMatrix = glm::translate(ModelMatrix, playerPos);
-		// rotate according to the angle given by controls
-		ModelMatrix = glm::rotate(ModelMatrix, playerAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-		MVP = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		glUniformMatrix4fv(MatrixID2, 1, GL_FALSE, &MVP[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-		glUniform3f(glGetUniformLocation(shader.getId(), "lightColor"), lightColor.x, lightColor.y, lightColor.z);
-		glUniform3f(glGetUniformLocation(shader.getId(), "lightPos"), lightPos.x, lightPos.y, lightPos.z);
-		glUniform3f(glGetUniformLocation(shader.getId(), "viewPos"), camera.getCameraPosition().x, camera.getCameraPosition().y, camera.getCameraPosition().z);
+		ModelMatrix = playerModel;
+		MVP = cameraState.viewProjection * ModelMatrix;
+		commands.setUniform("MVP", MVP);
+		commands.setUniform("model", ModelMatrix);
+		commands.setUniform("lightColor", lightColor);
+		commands.setUniform("lightPos", lightPos);
+		commands.setUniform("viewPos", cameraState.position);
 
-		vector_obiecte.at(0).getMesh().draw(shader);
+		commands.drawMesh(&entityMeshes[entities.getRenderHandle(playerEntity)]);
 
 
 
@@ -957,14 +873,52 @@ int main()
 
 		ModelMatrix = glm::mat4(1.0);
 		ModelMatrix = glm::translate(ModelMatrix, glm::vec3(0.0f, -20.0f, 0.0f));
-		MVP = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		glUniformMatrix4fv(MatrixID2, 1, GL_FALSE, &MVP[0][0]);
-		glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
+		MVP = cameraState.viewProjection * ModelMatrix;
+		commands.setUniform("MVP", MVP);
+		commands.setUniform("model", ModelMatrix);
+
+		//plane->draw(shader);
+
+		commands.endGpuScope();
+		profiler.endCpuScope();
+
+
+		// skybox last: pos.xyww puts it on the far plane, so with GL_LEQUAL only the pixels
+		// no object covered get shaded
+		profiler.beginCpuScope("skybox");
+		commands.beginGpuScope("skybox");
+
+		commands.setDepthFunc(RENDER_DEPTH_LEQUAL);
 
-		//plane.draw(shader);
+		// same projection as the scene, without the camera translation
+		commands.useProgram(skyboxShader);
+		commands.setUniform("viewProjection", cameraState.skyboxViewProjection);
+		commands.bindTexture(0, RENDER_TEXTURE_CUBE_MAP, cubemapTexture);
 
+		FragmentCounter* skyboxCounter = &skyboxFragments;
+		commands.call(beginFragmentCount, &skyboxCounter, sizeof(skyboxCounter));
+		commands.drawArrays(skyboxVAO, 0, 36);
+		commands.call(endFragmentCount, &skyboxCounter, sizeof(skyboxCounter));
 
+		commands.endGpuScope();
+		profiler.endCpuScope();
 
+		profiler.beginCpuScope("upscale");
+		commands.beginGpuScope("upscale");
+		commands.call(endScene, NULL, 0);
+		commands.endGpuScope();
+		profiler.endCpuScope();
+
+
+
+		// the previous frame has to be through the render thread before its results (queries,
+		// timings, shadow stats) are read, or anything it uses is changed, by the overlays below
+		profiler.beginCpuScope("render sync");
+		renderThread.sync();
+		profiler.endCpuScope();
+
+		profiler.beginCpuScope("imgui");
+		commands.beginGpuScope("imgui");
 
 		// ImGui window creation goes here
 		ImGui::Begin("Current task:");
@@ -984,14 +938,76 @@ int main()
 		}*/
 		ImGui::End();
 
+		// drawn first, the skybox used to shade every pixel of the window
+		ImGui::Begin("Skybox");
+		ImGui::Text("Fragments shaded: %llu (%.1f%% of the scene)", skyboxFragments.getLastSamples(),
+			100.0 * skyboxFragments.getLastSamples() / ((double)dynamicResolution.getRenderWidth() * dynamicResolution.getRenderHeight()));
+		ImGui::End();
+
+		ImGui::Begin("Input");
+		ImGui::Text("%u sim steps, %u events this frame", simSteps, simEvents);
+		ImGui::Text("Event to step latency: %.2f ms avg, %.2f ms last", simInput.getAverageLatencyMs(), simInput.getLastLatencyMs());
+		if (window.getInputQueue().getDroppedCount() > 0)
+			ImGui::Text("Dropped events: %u", window.getInputQueue().getDroppedCount());
+		ImGui::End();
+
+		ImGui::Begin("Lights");
+		ImGui::Text("%u torches, %u visible, assigned in %.3f ms", clusteredLighting.getLightCount(), clusteredLighting.getVisibleLightCount(),
+			clusteredLighting.getAssignMs());
+		ImGui::Text("%u cluster entries, at most %u lights in a cluster", clusteredLighting.getIndexCount(), clusteredLighting.getMaxClusterLights());
+		if (clusteredLighting.getOverflowCount() > 0)
+			ImGui::Text("Dropped from full clusters: %u", clusteredLighting.getOverflowCount());
+		ImGui::End();
+
+		ImGui::Begin("Shadows");
+		ImGui::Text("Static casters: %u draws this frame, cache rebuilt %u times", shadowMap.getStaticDraws(), shadowMap.getStaticRebuilds());
+		ImGui::Text("Dynamic casters: %u draws this frame", shadowMap.getDynamicDraws());
+		if (ImGui::Button("Rebuild static shadows"))
+			shadowMap.invalidateStatic();
+		ImGui::End();
+
+		framePacer.drawOverlay();
+		renderThread.drawOverlay();
+		dynamicResolution.drawOverlay();
+		profiler.drawOverlay();
+		assetRegistry.drawOverlay();
+		frameArena.drawOverlay();
+		allocationTracker.drawOverlay();
+
 		// Render ImGui draw data
 		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		renderThread.recordImGui(ImGui::GetDrawData());
+
+		commands.endGpuScope();
+		profiler.endCpuScope();
+
+		commands.present(window.getWidth(), window.getHeight());
+		FrameTiming frameTiming = framePacer.getFrameTiming();
+		commands.call(endFramePacing, &frameTiming, sizeof(frameTiming));
+		renderThread.submit();
 
-		window.update();
+		profiler.endFrame();
 	}
 
 	// Cleanup
+	// the last frame is finished and the context is back on this thread before anything is read or freed
+	renderThread.shutdown();
+	if (benchmarkMode)
+		benchmark.writeResults(benchmarkOutput.c_str(), window.getWidth(), window.getHeight());
+
+	printf("Skybox shaded %.0f fragments per frame on average (%.1f%% of the window)\n", skyboxFragments.getAverageSamples(),
+		100.0 * skyboxFragments.getAverageSamples() / ((double)window.getWidth() * window.getHeight()));
+	skyboxFragments.shutdown();
+	dynamicResolution.shutdown();
+	clusteredLighting.shutdown();
+	shadowMap.shutdown();
+	assetRegistry.printReport();
+	if (allocationTracker.isEnabled())
+		allocationTracker.writeReport(allocationReport.c_str());
+	uploadRing.shutdown();
+	framePacer.shutdown();
+	profiler.shutdown();
+	jobSystem.shutdown();
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
@@ -1007,37 +1023,31 @@ int main()
 
 
 // basic WASD movement and camera rotation
-void processKeyboardInput()
+void processKeyboardInput(float step)
 {
-	float cameraSpeed = 30 * deltaTime;
+	float cameraSpeed = 30 * step;
 
 	// collisions computed based on player model's center, not the functional playerPos aka coltul stanga, jos, front
 	glm::vec3 playerCenterPos = glm::vec3(
-		playerPos.x - (vector_obiecte.at(0).getSize().x / 2.0f),
+		playerPos.x - (entities.getSize(playerEntity).x / 2.0f),
 		playerPos.y,
-		playerPos.z - (vector_obiecte.at(0).getSize().z / 2.0f)
+		playerPos.z - (entities.getSize(playerEntity).z / 2.0f)
 	);
 
 
 
 	//translation -- playerPos TREB SA TINA CONT de getCameraViewDirection() (nu face miscare din laterale, se misca invers)
 
-	if (window.isPressed(GLFW_KEY_W))
+	if (simInput.isDown(GLFW_KEY_W))
 	{
 		glm::vec3 future_pos_w = playerCenterPos + glm::vec3(1.0f, 0.0f, 1.0f) * camera.getCameraViewDirection() * cameraSpeed * playerSpeed * 20.0f;
 
 		bool will_collide = 0;
 
 		// check whether it'll collide with any object
-		for (int i = 1; i < vector_obiecte.size(); i++)
-		{
-			// perform movement if no collision will happen between the player (0th object) and any other object
-			if (anticipateCollision(future_pos_w, vector_obiecte.at(0), vector_obiecte.at(i)) == 1)
-			{
-				will_collide = 1;
-				///std::cout << "will collide on W" << std::endl;
-			}
-		}
+		profiler.beginCpuScope("collision");
+		will_collide = playerWouldCollide(future_pos_w);
+		profiler.endCpuScope();
 
 		// if not, let it move
 		if (will_collide == 0)
@@ -1047,22 +1057,16 @@ void processKeyboardInput()
 		}
 	}
 
-	if (window.isPressed(GLFW_KEY_S))
+	if (simInput.isDown(GLFW_KEY_S))
 	{
 		glm::vec3 future_pos_s = playerCenterPos - glm::vec3(1.0f, 0.0f, 1.0f) * camera.getCameraViewDirection() * cameraSpeed * playerSpeed * 20.0f;
 
 		bool will_collide = 0;
 
 		// check whether it'll collide with any object
-		for (int i = 1; i < vector_obiecte.size(); i++)
-		{
-			// perform movement if no collision will happen between the player (0th object) and any other object
-			if (anticipateCollision(future_pos_s, vector_obiecte.at(0), vector_obiecte.at(i)) == 1)
-			{
-				will_collide = 1;
-				//std::cout << "will collide on S" << std::endl;
-			}
-		}
+		profiler.beginCpuScope("collision");
+		will_collide = playerWouldCollide(future_pos_s);
+		profiler.endCpuScope();
 
 		// if not, let it move
 		if (will_collide == 0)
@@ -1072,22 +1076,16 @@ void processKeyboardInput()
 		}
 	}
 
-	if (window.isPressed(GLFW_KEY_A))
+	if (simInput.isDown(GLFW_KEY_A))
 	{
 		glm::vec3 future_pos_a = playerCenterPos - glm::cross(camera.getCameraViewDirection(), camera.getCameraUp()) * cameraSpeed * playerSpeed * 20.0f;
 
 		bool will_collide = 0;
 
 		// check whether it'll collide with any object
-		for (int i = 1; i < vector_obiecte.size(); i++)
-		{
-			// perform movement if no collision will happen between the player (0th object) and any other object
-			if (anticipateCollision(future_pos_a, vector_obiecte.at(0), vector_obiecte.at(i)) == 1)
-			{
-				will_collide = 1;
-				//std::cout << "will collide on A" << std::endl;
-			}
-		}
+		profiler.beginCpuScope("collision");
+		will_collide = playerWouldCollide(future_pos_a);
+		profiler.endCpuScope();
 
 		// if not, let it move
 		if (will_collide == 0)
@@ -1097,22 +1095,16 @@ void processKeyboardInput()
 		}
 	}
 
-	if (window.isPressed(GLFW_KEY_D))
+	if (simInput.isDown(GLFW_KEY_D))
 	{
 		glm::vec3 future_pos_d = playerCenterPos + glm::cross(camera.getCameraViewDirection(), camera.getCameraUp()) * cameraSpeed * playerSpeed * 20.0f;
 
 		bool will_collide = 0;
 
 		// check whether it'll collide with any object
-		for (int i = 1; i < vector_obiecte.size(); i++)
-		{
-			// perform movement if no collision will happen between the player (0th object) and any other object
-			if (anticipateCollision(future_pos_d, vector_obiecte.at(0), vector_obiecte.at(i)) == 1)
-			{
-				will_collide = 1;
-				//std::cout << "will collide on D" << std::endl;
-			}
-		}
+		profiler.beginCpuScope("collision");
+		will_collide = playerWouldCollide(future_pos_d);
+		profiler.endCpuScope();
 
 		// if not, let it move
 		if (will_collide == 0)
@@ -1135,10 +1127,10 @@ void processKeyboardInput()
 
 
 	// enable jumping movement when pressing space AND when standing on something
-	if (window.isPressed(GLFW_KEY_SPACE) && jumping == 0 && standing == 1 /* && (checkCollision() || swinging == 1)*/)
+	if (simInput.isDown(GLFW_KEY_SPACE) && jumping == 0 && standing == 1 /* && (checkCollision() || swinging == 1)*/)
 	{
 		jumping = 1;
-		firstJumpFrame = glfwGetTime();
+		firstJumpFrame = (float)simTime;
 		initialJumpHeight = playerPos.y;
 		initialCameraPosHeight = camera.getCameraPosition().y;
 	}
@@ -1147,32 +1139,33 @@ void processKeyboardInput()
 
 
 	// rotatii cu sageti
-	if (window.isPressed(GLFW_KEY_LEFT))
+	if (simInput.isDown(GLFW_KEY_LEFT))
 	{
 		camera.rotateOy(cameraSpeed, playerPos);
 
 		// rotate object in sync with camera (in rendering loop)
 		playerAngle += cameraSpeed;
 	}
-	if (window.isPressed(GLFW_KEY_RIGHT))
+	if (simInput.isDown(GLFW_KEY_RIGHT))
 	{
 		camera.rotateOy(-cameraSpeed, playerPos);
 
 		// rotate object in sync with camera (in rendering loop)
 		playerAngle -= cameraSpeed;
 	}
-	if (window.isPressed(GLFW_KEY_UP))
+	if (simInput.isDown(GLFW_KEY_UP))
 	{
 		camera.rotateOx(cameraSpeed, playerPos);
 	}
-	if (window.isPressed(GLFW_KEY_DOWN))
+	if (simInput.isDown(GLFW_KEY_DOWN))
 	{
 		camera.rotateOx(-cameraSpeed, playerPos);
 	}
 
 
 	// record position in player object (for collisions)
-	vector_obiecte.at(0).setPosition(playerPos);
+	entities.setPosition(playerEntity, playerPos);
+	entities.setRotation(playerEntity, playerAngle);
 }
 
 
@@ -1182,9 +1175,9 @@ void processPlayerMovement()
 {
 	// collisions computed based on player model's center, special treatment for height
 	glm::vec3 playerCenterPos = glm::vec3(
-		playerPos.x - (vector_obiecte.at(0).getSize().x / 2.0f),
+		playerPos.x - (entities.getSize(playerEntity).x / 2.0f),
 		playerPos.y,
-		playerPos.z - (vector_obiecte.at(0).getSize().z / 2.0f)
+		playerPos.z - (entities.getSize(playerEntity).z / 2.0f)
 	);
 
 
@@ -1195,7 +1188,7 @@ void processPlayerMovement()
 		//if (swinging == 1)
 		//	jumpDuration = longjumpDuration;
 
-		float currentJumpFrame = glfwGetTime();
+		float currentJumpFrame = (float)simTime;
 		deltaJumpTime = currentJumpFrame - firstJumpFrame;
 		float normalizedTime = (deltaJumpTime / jumpDuration) * 3.1456f;
 
@@ -1236,14 +1229,9 @@ void processPlayerMovement()
 		bool will_collide = 0;
 
 		// check whether it'll collide with any object
-		for (int i = 1; i < vector_obiecte.size(); i++)
-		{
-			if (anticipateCollision(future_pos_y, vector_obiecte.at(0), vector_obiecte.at(i)) == 1)
-			{
-				will_collide = 1;
-				//std::cout << "not falling" << std::endl;
-			}
-		}
+		profiler.beginCpuScope("collision");
+		will_collide = playerWouldCollide(future_pos_y);
+		profiler.endCpuScope();
 
 		// if not, let it fall
 		if (will_collide == 0)
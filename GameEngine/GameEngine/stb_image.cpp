@@ -1,2 +1,12 @@
 #define STB_IMAGE_IMPLEMENTATION
+
+// the game counts every decode allocation (Memory\heapCounter.h); the asset baker does not
+// link the counter and keeps plain malloc
+#ifdef ENGINE_COUNTED_HEAP
+#include "Memory\heapCounter.h"
+#define STBI_MALLOC(sz) heapMalloc(sz)
+#define STBI_REALLOC(p, newsz) heapRealloc(p, newsz)
+#define STBI_FREE(p) heapFree(p)
+#endif
+
 #include "stb_image.h"
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+// heap counters for the microbenchmarks; operator new/delete and stb_image's malloc go through these
+long long benchAllocationCount();
+long long benchAllocatedBytes();
+
+void* benchMalloc(size_t size);
+void* benchRealloc(void* ptr, size_t size);
+void benchFree(void* ptr);
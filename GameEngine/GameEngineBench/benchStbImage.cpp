@@ -0,0 +1,9 @@
+// stb_image built with counted allocations, so the decode benchmarks report real allocs/op
+#include "benchAlloc.h"
+
+#define STBI_MALLOC(sz) benchMalloc(sz)
+#define STBI_REALLOC(p, newsz) benchRealloc(p, newsz)
+#define STBI_FREE(p) benchFree(p)
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "..\GameEngine\stb_image.h"
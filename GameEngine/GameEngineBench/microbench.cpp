@@ -0,0 +1,734 @@
+// Windowless microbenchmarks for the engine's loaders, collision tests, entity storage and camera math.
+//
+// usage: GameEngineBench.exe [--root <GameEngine project dir>] [--filter <substring>]
+//
+// Every benchmark prints ns/op, bytes/sec (where an op has a natural input size) and
+// heap allocations/op, counted through the global operator new and stb_image's allocator.
+
+#include "benchAlloc.h"
+#include "..\GameEngine\Model Loading\meshLoaderObj.h"
+#include "..\GameEngine\Model Loading\texture.h"
+#include "..\GameEngine\Camera\camera.h"
+#include "..\GameEngine\Physics\collision.h"
+#include "..\GameEngine\Physics\collisionGrid.h"
+#include "..\GameEngine\Level\level.h"
+#include "..\GameEngine\Scene\entityStore.h"
+#include "..\GameEngine\Scene\drawList.h"
+#include "..\GameEngine\Graphics\clusteredLighting.h"
+#include "..\GameEngine\Graphics\commandBuffer.h"
+#include "..\GameEngine\Threading\parallel.h"
+#include "..\GameEngine\Threading\jobSystem.h"
+#include "..\GameEngine\stb_image.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+// minimum measured time per benchmark
+#define BENCH_MIN_SECONDS 0.25
+
+static std::atomic<long long> allocationCount(0);
+static std::atomic<long long> allocatedBytes(0);
+
+long long benchAllocationCount()
+{
+	return allocationCount.load();
+}
+
+long long benchAllocatedBytes()
+{
+	return allocatedBytes.load();
+}
+
+void* benchMalloc(size_t size)
+{
+	allocationCount++;
+	allocatedBytes += size;
+	return malloc(size);
+}
+
+void* benchRealloc(void* ptr, size_t size)
+{
+	allocationCount++;
+	allocatedBytes += size;
+	return realloc(ptr, size);
+}
+
+void benchFree(void* ptr)
+{
+	free(ptr);
+}
+
+void* operator new(size_t size)
+{
+	void* ptr = benchMalloc(size == 0 ? 1 : size);
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	benchFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	benchFree(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	benchFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	benchFree(ptr);
+}
+
+// keeps results alive so the optimiser cannot drop the measured work
+static volatile float sink;
+
+static std::string filter;
+
+struct BenchResult
+{
+	std::string name;
+	long long iterations;
+	double nsPerOp;
+	double bytesPerSecond;
+	double allocationsPerOp;
+};
+
+static std::vector<BenchResult> results;
+
+template <typename Op>
+static void runBench(const std::string& name, size_t bytesPerOp, Op op)
+{
+	if (!filter.empty() && name.find(filter) == std::string::npos)
+		return;
+
+	// one untimed call to warm caches and fault in lazily allocated state
+	op();
+
+	long long iterations = 0;
+	long long batch = 1;
+	long long allocationsBefore = benchAllocationCount();
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	double elapsed = 0.0;
+
+	while (elapsed < BENCH_MIN_SECONDS)
+	{
+		for (long long i = 0; i < batch; i++)
+			op();
+		iterations += batch;
+		elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		if (elapsed < BENCH_MIN_SECONDS / 8)
+			batch *= 2;
+	}
+
+	BenchResult result;
+	result.name = name;
+	result.iterations = iterations;
+	result.nsPerOp = elapsed * 1e9 / iterations;
+	result.bytesPerSecond = bytesPerOp > 0 ? (double)bytesPerOp * iterations / elapsed : 0.0;
+	result.allocationsPerOp = (double)(benchAllocationCount() - allocationsBefore) / iterations;
+	results.push_back(result);
+
+	if (result.bytesPerSecond > 0.0)
+		printf("%-44s %14.1f ns/op %10.1f MB/s %10.2f allocs/op\n", name.c_str(), result.nsPerOp, result.bytesPerSecond / (1024.0 * 1024.0), result.allocationsPerOp);
+	else
+		printf("%-44s %14.1f ns/op %10s      %10.2f allocs/op\n", name.c_str(), result.nsPerOp, "-", result.allocationsPerOp);
+}
+
+static std::vector<std::string> listFiles(const std::string& directory, const std::string& extension)
+{
+	std::vector<std::string> files;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((directory + "\\*" + extension).c_str(), &data);
+	if (find != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				files.push_back(data.cFileName);
+		} while (FindNextFileA(find, &data));
+		FindClose(find);
+	}
+#else
+	DIR* dir = opendir(directory.c_str());
+	if (dir != NULL)
+	{
+		struct dirent* entry;
+		while ((entry = readdir(dir)) != NULL)
+		{
+			std::string name = entry->d_name;
+			if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+				files.push_back(name);
+		}
+		closedir(dir);
+	}
+#endif
+
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+static size_t fileSize(const std::string& path)
+{
+	FILE* file;
+	if (fopen_s(&file, path.c_str(), "rb"))
+		return 0;
+	fseek(file, 0, SEEK_END);
+	size_t size = (size_t)ftell(file);
+	fclose(file);
+	return size;
+}
+
+static void benchModels(const std::string& root)
+{
+	std::string directory = root + "/Resources/Models";
+	std::vector<std::string> files = listFiles(directory, ".obj");
+	MeshLoaderObj loader;
+
+	for (unsigned int i = 0; i < files.size(); i++)
+	{
+		std::string path = directory + "/" + files[i];
+		std::vector<Vertex> vertices;
+		std::vector<int> indices;
+
+		runBench("loadObj/" + files[i], fileSize(path), [&]() {
+			loader.parseObj(path, vertices, indices);
+			sink = sink + (float)indices.size();
+		});
+	}
+}
+
+static void benchTextures(const std::string& root)
+{
+	std::string directory = root + "/Resources/Textures";
+	std::vector<std::string> files = listFiles(directory, ".bmp");
+
+	for (unsigned int i = 0; i < files.size(); i++)
+	{
+		std::string path = directory + "/" + files[i];
+		unsigned int width, height;
+		std::vector<unsigned char> data;
+
+		// the op reads the first byte, so a file that does not load is left out
+		if (!readBMP(path.c_str(), width, height, data) || data.empty())
+		{
+			printf("%-44s skipped, could not be read\n", ("loadBMP/" + files[i]).c_str());
+			continue;
+		}
+
+		runBench("loadBMP/" + files[i], fileSize(path), [&]() {
+			readBMP(path.c_str(), width, height, data);
+			sink = sink + data[0];
+		});
+	}
+}
+
+static void benchCubemap(const std::string& root)
+{
+	std::string directory = root + "/Resources/Skybox";
+	std::vector<std::string> files = listFiles(directory, ".bmp");
+
+	for (unsigned int i = 0; i < files.size(); i++)
+	{
+		std::string path = directory + "/" + files[i];
+
+		runBench("stbi_load/" + files[i], fileSize(path), [&]() {
+			int width, height, channels;
+			unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+			if (data)
+			{
+				sink = sink + data[0];
+				stbi_image_free(data);
+			}
+		});
+	}
+
+	// the whole skybox the way loadCubemap used to decode it, and the way it does now
+	size_t totalBytes = 0;
+	std::vector<std::string> paths;
+	for (unsigned int i = 0; i < files.size(); i++)
+	{
+		paths.push_back(directory + "/" + files[i]);
+		totalBytes += fileSize(paths[i]);
+	}
+	auto decodeFace = [&](unsigned int i) {
+		int width, height, channels;
+		unsigned char* data = stbi_load(paths[i].c_str(), &width, &height, &channels, 3);
+		if (data)
+		{
+			sink = sink + data[0];
+			stbi_image_free(data);
+		}
+	};
+
+	runBench("stbi_load/all faces sequential", totalBytes, [&]() {
+		for (unsigned int i = 0; i < paths.size(); i++)
+			decodeFace(i);
+	});
+	runBench("stbi_load/all faces parallel", totalBytes, [&]() {
+		parallelFor((unsigned int)paths.size(), decodeFace);
+	});
+}
+
+struct SyntheticScene
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> sizes;
+};
+
+// wall-like boxes scattered over the same 200x200 area as the level
+static SyntheticScene makeScene(int count)
+{
+	SyntheticScene scene;
+	srand(1234);
+	for (int i = 0; i < count; i++)
+	{
+		float x = -50.0f + (rand() % 20000) / 100.0f;
+		float z = -50.0f + (rand() % 20000) / 100.0f;
+		bool alongX = rand() % 2 == 0;
+		scene.positions.push_back(glm::vec3(x, 8.0f, z));
+		scene.sizes.push_back(alongX ? glm::vec3(4.0f + rand() % 40, 10.0f, 4.5f) : glm::vec3(4.5f, 10.0f, 4.0f + rand() % 40));
+	}
+	return scene;
+}
+
+static void benchCollision()
+{
+	int counts[] = { 64, 1024, 16384 };
+	glm::vec3 playerPos = glm::vec3(50.0f, 10.0f, 50.0f);
+	glm::vec3 playerSize = glm::vec3(2.0f, 5.0f, 2.0f);
+
+	for (int c = 0; c < 3; c++)
+	{
+		SyntheticScene scene = makeScene(counts[c]);
+		std::string suffix = " x" + std::to_string(counts[c]);
+
+		// one op = the player against every object in the scene
+		runBench("isColliding" + suffix, 0, [&]() {
+			int hits = 0;
+			for (unsigned int i = 0; i < scene.positions.size(); i++)
+				hits += aabbOverlap(playerPos, playerSize, scene.positions[i], scene.sizes[i]);
+			sink = sink + hits;
+		});
+
+		// one op = the four WASD probes and the gravity probe processKeyboardInput/processPlayerMovement run per frame
+		glm::vec3 probes[5] = {
+			playerPos + glm::vec3(0.0f, 0.0f, -0.1f),
+			playerPos + glm::vec3(0.0f, 0.0f, 0.1f),
+			playerPos + glm::vec3(-0.1f, 0.0f, 0.0f),
+			playerPos + glm::vec3(0.1f, 0.0f, 0.0f),
+			playerPos + glm::vec3(0.0f, -0.02f, 0.0f)
+		};
+		runBench("anticipateCollision 5 probes" + suffix, 0, [&]() {
+			int hits = 0;
+			for (int p = 0; p < 5; p++)
+			{
+				for (unsigned int i = 0; i < scene.positions.size(); i++)
+					hits += aabbOverlap(probes[p], playerSize, scene.positions[i], scene.sizes[i]);
+			}
+			sink = sink + hits;
+		});
+
+		// the same probes through the level's collision grid
+		CollisionGrid grid;
+		grid.build(&scene.positions[0], &scene.sizes[0], (unsigned int)scene.positions.size(), COLLISION_GRID_CELL_SIZE);
+		runBench("CollisionGrid 5 probes" + suffix, 0, [&]() {
+			int hits = 0;
+			for (int p = 0; p < 5; p++)
+				hits += grid.overlapsAny(probes[p], playerSize);
+			sink = sink + hits;
+		});
+
+		// CPU side of loading a level this size: the static batch and the grid, in one pass
+		runBench("level build" + suffix, 0, [&]() {
+			std::vector<Vertex> vertices;
+			std::vector<int> indices;
+			vertices.reserve(scene.positions.size() * 24);
+			indices.reserve(scene.positions.size() * 36);
+			for (unsigned int i = 0; i < scene.positions.size(); i++)
+				appendBoxGeometry(scene.positions[i], scene.sizes[i], 1.0f, vertices, indices);
+			CollisionGrid levelGrid;
+			levelGrid.build(&scene.positions[0], &scene.sizes[0], (unsigned int)scene.positions.size(), COLLISION_GRID_CELL_SIZE);
+			sink = sink + (unsigned int)indices.size() + levelGrid.getCellCount();
+		});
+	}
+}
+
+// the layout scene objects had before EntityStore: every field of an object next to each other
+struct ObiectLayout
+{
+	int id;
+	glm::vec3 position;
+	glm::vec3 size;
+	std::vector<Vertex> vertices;
+	Mesh mesh;
+	glm::vec3 rotation;
+	std::vector<Texture> textures;
+};
+
+#define ENTITY_BENCH_COUNT 1000000
+
+static void benchEntities()
+{
+	SyntheticScene scene = makeScene(ENTITY_BENCH_COUNT);
+	std::string suffix = " x" + std::to_string(ENTITY_BENCH_COUNT);
+
+	std::vector<ObiectLayout> objects(ENTITY_BENCH_COUNT);
+	EntityStore store;
+	store.reserve(ENTITY_BENCH_COUNT);
+	for (unsigned int i = 0; i < ENTITY_BENCH_COUNT; i++)
+	{
+		objects[i].id = (int)i;
+		objects[i].position = scene.positions[i];
+		objects[i].size = scene.sizes[i];
+		EntityId entity = store.create((int)i, scene.positions[i], scene.sizes[i], i % 3, LEVEL_OBJECT_DYNAMIC);
+		// one in sixteen draws on its own, like the player among the batched level
+		if (i % 16 == 0)
+			store.setRenderHandle(entity, (int)(i / 16));
+	}
+
+	// a probe outside the scene, so every op walks all entities
+	glm::vec3 probe = glm::vec3(1000.0f, 10.0f, 1000.0f);
+	glm::vec3 probeSize = glm::vec3(2.0f, 5.0f, 2.0f);
+
+	// one op = one collision scan over every entity
+	runBench("entity overlap scan AoS" + suffix, 0, [&]() {
+		int hit = -1;
+		for (unsigned int i = 0; i < objects.size() && hit < 0; i++)
+		{
+			if (aabbOverlap(probe, probeSize, objects[i].position, objects[i].size))
+				hit = (int)i;
+		}
+		sink = sink + hit;
+	});
+
+	runBench("entity overlap scan SoA" + suffix, 0, [&]() {
+		sink = sink + store.findOverlap(probe, probeSize, LEVEL_OBJECT_DYNAMIC, INVALID_ENTITY);
+	});
+
+	// one op = frustum culling every entity against the level's usual view
+	glm::mat4 viewProjection = glm::perspective(90.0f, 16.0f / 9.0f, 0.1f, 10000.0f) *
+		glm::lookAt(glm::vec3(50.0f, 20.0f, 50.0f), glm::vec3(100.0f, 10.0f, 100.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::vec4 frustum[6];
+	extractFrustumPlanes(viewProjection, frustum);
+	std::vector<EntityId> visible(ENTITY_BENCH_COUNT);
+	runBench("entity frustum cull SoA" + suffix, 0, [&]() {
+		sink = sink + store.cull(frustum, &visible[0]);
+	});
+
+	// one op = the render pass walking every entity for the ones it has to draw
+	runBench("entity render walk AoS" + suffix, 0, [&]() {
+		unsigned int draws = 0;
+		for (unsigned int i = 0; i < objects.size(); i++)
+			draws += !objects[i].mesh.indices.empty() || i % 16 == 0;
+		sink = sink + draws;
+	});
+
+	runBench("entity render walk SoA" + suffix, 0, [&]() {
+		const int* renderHandles = store.getRenderHandles();
+		const unsigned int* materials = store.getMaterials();
+		unsigned int draws = 0;
+		unsigned int count = store.getCount();
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (renderHandles[i] != NO_RENDER_HANDLE)
+				draws += materials[i] + 1;
+		}
+		sink = sink + draws;
+	});
+}
+
+static void benchCamera()
+{
+	Camera camera(glm::vec3(25.0f, -10.0f, 25.0f));
+	glm::vec3 pivot = glm::vec3(5.0f, 10.0f, 5.0f);
+
+	runBench("Camera::rotateOx", 0, [&]() {
+		camera.rotateOx(0.001f, pivot);
+		sink = sink + camera.getCameraViewDirection().y;
+	});
+
+	runBench("Camera::rotateOy", 0, [&]() {
+		camera.rotateOy(0.001f, pivot);
+		sink = sink + camera.getCameraViewDirection().x;
+	});
+
+	runBench("Camera::getViewMatrix", 0, [&]() {
+		glm::mat4 view = camera.getViewMatrix();
+		sink = sink + view[3][0];
+	});
+
+	// one op = what every pass used to rebuild per frame: view, projection, their product and the planes
+	camera.setProjection(90.0f, 16.0f / 9.0f, 0.1f, 10000.0f);
+	runBench("Camera render state rebuilt", 0, [&]() {
+		glm::mat4 view = camera.getViewMatrix();
+		glm::mat4 viewProjection = glm::perspective(90.0f, 16.0f / 9.0f, 0.1f, 10000.0f) * view;
+		glm::vec4 frustum[6];
+		extractFrustumPlanes(viewProjection, frustum);
+		sink = sink + viewProjection[3][0] + frustum[5].w;
+	});
+
+	// one op = a moved camera, everything including the inverses recomputed once
+	runBench("Camera::getRenderState moved", 0, [&]() {
+		camera.verticalMovement(0.0f);
+		const CameraRenderState& state = camera.getRenderState();
+		sink = sink + state.viewProjection[3][0] + state.frustum[5].w;
+	});
+
+	// one op = a still camera, the cached state handed back as is
+	runBench("Camera::getRenderState cached", 0, [&]() {
+		const CameraRenderState& state = camera.getRenderState();
+		sink = sink + state.viewProjection[3][0] + state.frustum[5].w;
+	});
+}
+
+static void benchLighting()
+{
+	int counts[] = { 10, 100, 1000 };
+	Camera camera(glm::vec3(50.0f, 20.0f, 50.0f), glm::normalize(glm::vec3(50.0f, -10.0f, 50.0f)), glm::vec3(0.0f, 1.0f, 0.0f));
+	camera.setProjection(90.0f, 16.0f / 9.0f, 0.1f, 10000.0f);
+	const CameraRenderState& state = camera.getRenderState();
+
+	for (int c = 0; c < 3; c++)
+	{
+		// a torch above every wall of a scene that size, as in the game
+		SyntheticScene scene = makeScene(counts[c]);
+		ClusteredLighting lighting;
+		for (unsigned int i = 0; i < scene.positions.size(); i++)
+			lighting.addLight(scene.positions[i] + scene.sizes[i] * glm::vec3(0.5f, 1.0f, 0.5f) + glm::vec3(0.0f, 3.0f, 0.0f), 30.0f, glm::vec3(1.0f, 0.55f, 0.2f));
+
+		// one op = light to cluster assignment for one frame, packed lists included
+		size_t ran = results.size();
+		runBench("clustered light assign x" + std::to_string(counts[c]), 0, [&]() {
+			lighting.assign(state);
+			sink = sink + lighting.getIndexCount();
+		});
+
+		// what a fragment pays: the lights of its own cluster rather than all of them
+		if (results.size() > ran)
+			printf("    %u of %d lights visible, %.2f per cluster on average, %u at most, %u dropped\n", lighting.getVisibleLightCount(), counts[c],
+				(float)lighting.getIndexCount() / CLUSTERED_CLUSTER_COUNT, lighting.getMaxClusterLights(), lighting.getOverflowCount());
+	}
+}
+
+static void benchCommandBuffer()
+{
+	CommandBuffer commands;
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+	glm::vec3 color = glm::vec3(1.0f, 0.55f, 0.2f);
+
+	// one op = what the main loop records for a frame of 1000 objects, each with its own
+	// matrices; nothing is replayed, so the mesh pointers are never followed
+	runBench("command buffer record 1000 draws", 0, [&]() {
+		commands.reset();
+		commands.beginFrame(0);
+		commands.clear(true, true);
+		commands.useShader(NULL);
+		commands.beginGpuScope("objects");
+		for (int i = 0; i < 1000; i++)
+		{
+			commands.setUniform("MVP", model);
+			commands.setUniform("model", model);
+			commands.setUniform("lightColor", color);
+			commands.drawMesh(NULL);
+		}
+		commands.endGpuScope();
+		commands.present(1920, 1080);
+		sink = sink + (float)commands.getSize();
+	});
+
+	// one op = the render thread's walk over that frame, without the GL calls
+	runBench("command buffer read 1000 draws", 0, [&]() {
+		size_t offset = 0;
+		unsigned int draws = 0;
+		while (const RenderCommandHeader* header = commands.read(offset))
+			draws += header->type == RENDER_COMMAND_DRAW_MESH;
+		sink = sink + draws;
+	});
+}
+
+// runs sweep(threads, suffix) with the job system at 1, 2, 4 .. threads, up to one per core,
+// and leaves it at one per core for anything after it
+template <typename Sweep>
+static void forEachThreadCount(Sweep sweep)
+{
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int threads = 1; threads <= hardwareThreads; threads = threads == hardwareThreads ? threads + 1 : std::min(threads * 2, hardwareThreads))
+	{
+		jobSystem.shutdown();
+		jobSystem.init(threads);
+		sweep(threads, std::string(" ") + std::to_string(threads) + (threads == 1 ? " thread" : " threads"));
+	}
+
+	jobSystem.shutdown();
+	jobSystem.init();
+}
+
+// compares the bench that just ran with its single thread run, which it remembers when threads is 1
+static void printScaling(unsigned int threads, double& singleThreadNs, const std::string& detail)
+{
+	if (threads == 1)
+		singleThreadNs = results.back().nsPerOp;
+	else if (singleThreadNs > 0.0)
+		printf("    %.2fx the single thread speed%s\n", singleThreadNs / results.back().nsPerOp, detail.c_str());
+}
+
+static void benchJobs()
+{
+	// a brute force broadphase: every probe against every box, heavy and evenly split
+	SyntheticScene scene = makeScene(16384);
+	std::vector<glm::vec3> probes;
+	for (unsigned int i = 0; i < 512; i++)
+		probes.push_back(scene.positions[(i * 31) % scene.positions.size()] + glm::vec3(0.5f, 0.0f, 0.5f));
+	glm::vec3 probeSize = glm::vec3(2.0f, 5.0f, 2.0f);
+
+	double singleThreadNs = 0.0;
+	forEachThreadCount([&](unsigned int threads, const std::string& suffix) {
+		// one op = 512 probes x 16384 boxes, as parallelFor jobs of 8 probes
+		size_t ran = results.size();
+		runBench("jobs broadphase" + suffix, 0, [&]() {
+			std::atomic<int> hits(0);
+			jobSystem.parallelFor((unsigned int)probes.size(), 8, [&](unsigned int first, unsigned int last) {
+				int local = 0;
+				for (unsigned int p = first; p < last; p++)
+				{
+					for (unsigned int i = 0; i < scene.positions.size(); i++)
+						local += aabbOverlap(probes[p], probeSize, scene.positions[i], scene.sizes[i]);
+				}
+				hits += local;
+			});
+			sink = sink + hits.load();
+		});
+		if (results.size() > ran)
+			printScaling(threads, singleThreadNs, ", " + std::to_string(jobSystem.getStolenCount()) + " jobs stolen so far");
+
+		// one op = the scheduling cost alone: 256 empty jobs on a counter, waited for
+		runBench("jobs 256 empty" + suffix, 0, [&]() {
+			JobCounter counter;
+			for (int j = 0; j < 256; j++)
+				jobSystem.run([]() {}, &counter);
+			jobSystem.wait(counter);
+		});
+
+		// one op = a chain of two dependent batches, the second queued when the first is done
+		runBench("jobs dependent batches" + suffix, 0, [&]() {
+			JobCounter first;
+			JobCounter second;
+			std::atomic<int> order(0);
+			for (int j = 0; j < 16; j++)
+				jobSystem.run([&]() { order++; }, &first);
+			for (int j = 0; j < 16; j++)
+				jobSystem.runAfter(first, [&]() { sink = sink + (order.load() == 16); }, &second);
+			jobSystem.wait(second);
+		});
+	});
+}
+
+#define DRAW_LIST_BENCH_COUNT 100000
+
+static void benchDrawList()
+{
+	SyntheticScene scene = makeScene(DRAW_LIST_BENCH_COUNT);
+	EntityStore store;
+	store.reserve(DRAW_LIST_BENCH_COUNT);
+	for (unsigned int i = 0; i < DRAW_LIST_BENCH_COUNT; i++)
+	{
+		EntityId entity = store.create((int)i, scene.positions[i], scene.sizes[i], i % 3, LEVEL_OBJECT_DYNAMIC);
+		store.setRenderHandle(entity, (int)i);
+	}
+
+	// the level's usual view, from above so a good part of the scene is in it
+	Camera camera(glm::vec3(50.0f, 60.0f, 50.0f), glm::normalize(glm::vec3(50.0f, -40.0f, 50.0f)), glm::vec3(0.0f, 1.0f, 0.0f));
+	camera.setProjection(90.0f, 16.0f / 9.0f, 0.1f, 10000.0f);
+	const CameraRenderState& state = camera.getRenderState();
+
+	DrawListBuilder builder;
+	std::vector<DrawItem> drawList(DRAW_LIST_BENCH_COUNT);
+	std::vector<DrawItem> singleThreadList;
+	unsigned int drawCount = 0;
+
+	double singleThreadNs = 0.0;
+	forEachThreadCount([&](unsigned int threads, const std::string& suffix) {
+		// one op = culling, sort keys and sorting for every entity, as the frame does
+		size_t ran = results.size();
+		runBench("draw list build x" + std::to_string(DRAW_LIST_BENCH_COUNT) + suffix, 0, [&]() {
+			drawCount = builder.build(store, state.frustum, state.position, INVALID_ENTITY, &drawList[0]);
+			sink = sink + drawCount;
+		});
+		if (results.size() == ran)
+			return;
+
+		if (threads == 1)
+		{
+			singleThreadList.assign(drawList.begin(), drawList.begin() + drawCount);
+			printf("    %u of %d visible, %u chunks\n", drawCount, DRAW_LIST_BENCH_COUNT, builder.getChunkCount());
+		}
+
+		// the merge is deterministic, the list must not depend on the thread count
+		bool same = drawCount == singleThreadList.size();
+		for (unsigned int i = 0; i < drawCount && same; i++)
+			same = drawList[i].key == singleThreadList[i].key && drawList[i].entity == singleThreadList[i].entity;
+		printScaling(threads, singleThreadNs, same ? ", same list" : ", DIFFERENT list");
+	});
+}
+
+int main(int argc, char** argv)
+{
+	std::string root = ".";
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--root" && i + 1 < argc)
+			root = argv[++i];
+		else if (arg == "--filter" && i + 1 < argc)
+			filter = argv[++i];
+	}
+
+	printf("%-44s %20s %15s %20s\n", "benchmark", "time", "throughput", "heap");
+
+	if (listFiles(root + "/Resources/Models", ".obj").empty())
+	{
+		printf("No models found under %s/Resources/Models, pass --root <GameEngine project dir>\n", root.c_str());
+		return 1;
+	}
+
+	benchModels(root);
+	benchTextures(root);
+	benchCubemap(root);
+	benchCollision();
+	benchEntities();
+	benchCamera();
+	benchLighting();
+	benchCommandBuffer();
+	benchJobs();
+	benchDrawList();
+
+	return 0;
+}